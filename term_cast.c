@@ -0,0 +1,333 @@
+/**
+ * Terminal Session Recording Implementation
+ * asciicast v2 writer and loader
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "term_cast.h"
+#include "term_emu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+static long long monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Length of the UTF-8 sequence at p: 0 if invalid, -1 if cut short by avail */
+static int utf8_sequence(const uint8_t *p, size_t avail) {
+    uint8_t c = p[0];
+    uint8_t lo = 0x80;
+    uint8_t hi = 0xBF;
+    int len;
+
+    if (c < 0x80) return 1;
+    if (c < 0xC2) return 0;
+    if (c < 0xE0) {
+        len = 2;
+    } else if (c < 0xF0) {
+        len = 3;
+        if (c == 0xE0) lo = 0xA0;        /* Overlong */
+        if (c == 0xED) hi = 0x9F;        /* Surrogates */
+    } else if (c < 0xF5) {
+        len = 4;
+        if (c == 0xF0) lo = 0x90;        /* Overlong */
+        if (c == 0xF4) hi = 0x8F;        /* Above U+10FFFF */
+    } else {
+        return 0;
+    }
+
+    for (int i = 1; i < len; i++) {
+        if ((size_t)i >= avail) return -1;
+        if (p[i] < (i == 1 ? lo : 0x80) || p[i] > (i == 1 ? hi : 0xBF)) return 0;
+    }
+    return len;
+}
+
+/* Write bytes as the inside of a JSON string; invalid UTF-8 becomes U+FFFD */
+static void write_json_string(FILE *file, const uint8_t *p, size_t n) {
+    size_t i = 0;
+
+    while (i < n) {
+        int len = utf8_sequence(p + i, n - i);
+        if (len <= 0) {
+            fputs("\\ufffd", file);
+            i++;
+            continue;
+        }
+        if (len > 1) {
+            fwrite(p + i, 1, (size_t)len, file);
+            i += (size_t)len;
+            continue;
+        }
+
+        uint8_t c = p[i++];
+        switch (c) {
+        case '"':  fputs("\\\"", file); break;
+        case '\\': fputs("\\\\", file); break;
+        case '\n': fputs("\\n", file); break;
+        case '\r': fputs("\\r", file); break;
+        case '\t': fputs("\\t", file); break;
+        case '\b': fputs("\\b", file); break;
+        case '\f': fputs("\\f", file); break;
+        default:
+            if (c < 0x20 || c == 0x7F) {
+                fprintf(file, "\\u%04x", c);
+            } else {
+                fputc(c, file);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Start a recording
+ */
+term_cast_writer_t* term_cast_create(const char *path, int cols, int rows) {
+    term_cast_writer_t *writer = calloc(1, sizeof(term_cast_writer_t));
+    if (!writer) return NULL;
+
+    writer->file = fopen(path, "w");
+    if (!writer->file) {
+        free(writer);
+        return NULL;
+    }
+
+    fprintf(writer->file,
+            "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %lld, "
+            "\"env\": {\"TERM\": \"xterm-256color\"}}\n",
+            cols, rows, (long long)time(NULL));
+    writer->start_us = monotonic_us();
+    return writer;
+}
+
+/**
+ * Append an event
+ */
+bool term_cast_write(term_cast_writer_t *writer, char type, const char *data, size_t len) {
+    if (!writer || (type != 'o' && type != 'i')) return false;
+
+    int stream = type == 'o' ? 0 : 1;
+    const uint8_t *p = (const uint8_t *)data;
+    uint8_t *joined = NULL;
+
+    /* Complete the sequence left over from the last event */
+    if (writer->carry_len[stream] > 0) {
+        size_t carry = writer->carry_len[stream];
+        joined = malloc(carry + len);
+        if (!joined) return false;
+        memcpy(joined, writer->carry[stream], carry);
+        memcpy(joined + carry, data, len);
+        p = joined;
+        len += carry;
+        writer->carry_len[stream] = 0;
+    }
+
+    /* Hold back a sequence cut off at the end */
+    size_t tail = 0;
+    for (size_t k = 1; k <= 3 && k <= len; k++) {
+        if ((p[len - k] & 0xC0) != 0x80) {
+            if (utf8_sequence(p + len - k, k) < 0) tail = k;
+            break;
+        }
+    }
+    memcpy(writer->carry[stream], p + len - tail, tail);
+    writer->carry_len[stream] = tail;
+    len -= tail;
+
+    if (len > 0) {
+        double seconds = (double)(monotonic_us() - writer->start_us) / 1e6;
+        fprintf(writer->file, "[%.6f, \"%c\", \"", seconds, type);
+        write_json_string(writer->file, p, len);
+        fputs("\"]\n", writer->file);
+    }
+
+    free(joined);
+    return !ferror(writer->file);
+}
+
+/**
+ * Finish and close a recording
+ */
+void term_cast_close(term_cast_writer_t *writer) {
+    if (writer) {
+        if (writer->file) fclose(writer->file);
+        free(writer);
+    }
+}
+
+static const char* skip_space(const char *p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+static int hex4(const char *p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+/* Unescape a JSON string body starting after its opening quote
+ * @return Position after the closing quote, NULL if malformed */
+static const char* read_json_string(const char *p, char *out, size_t *out_len) {
+    size_t n = 0;
+
+    while (*p && *p != '"' && *p != '\n') {
+        if (*p != '\\') {
+            out[n++] = *p++;
+            continue;
+        }
+
+        p++;
+        switch (*p) {
+        case 'n': out[n++] = '\n'; break;
+        case 'r': out[n++] = '\r'; break;
+        case 't': out[n++] = '\t'; break;
+        case 'b': out[n++] = '\b'; break;
+        case 'f': out[n++] = '\f'; break;
+        case 'u': {
+            int cp = hex4(p + 1);
+            if (cp < 0) return NULL;
+            p += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && p[1] == '\\' && p[2] == 'u') {
+                int low = hex4(p + 3);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+            }
+            if (cp >= 0xD800 && cp <= 0xDFFF) cp = TERM_REPLACEMENT_CHAR;
+            n += term_utf8_encode((uint32_t)cp, out + n);
+            break;
+        }
+        case '\0':
+            return NULL;
+        default:
+            out[n++] = *p;       /* \" \\ \/ */
+            break;
+        }
+        p++;
+    }
+
+    if (*p != '"') return NULL;
+    *out_len = n;
+    return p + 1;
+}
+
+/* Read a header field such as "width": 80 */
+static int header_int(const char *header, const char *key) {
+    const char *p = strstr(header, key);
+    if (!p) return 0;
+    p = strchr(p + strlen(key), ':');
+    return p ? atoi(p + 1) : 0;
+}
+
+/**
+ * Load a recording
+ */
+term_cast_t* term_cast_load(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return NULL;
+
+    term_cast_t *cast = calloc(1, sizeof(term_cast_t));
+    if (!cast) {
+        fclose(file);
+        return NULL;
+    }
+
+    char *text = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        text = malloc((size_t)size + 1);
+        /* Unescaping only shrinks, so the data fits in the file size */
+        cast->data = malloc((size_t)size + 1);
+    }
+    if (!text || !cast->data || fread(text, 1, (size_t)size, file) != (size_t)size) {
+        int err = ferror(file) ? EIO : (errno ? errno : ENOMEM);
+        fclose(file);
+        free(text);
+        term_cast_free(cast);
+        errno = err;
+        return NULL;
+    }
+    fclose(file);
+    text[size] = '\0';
+
+    int capacity = 0;
+    size_t used = 0;
+    char *line = text;
+
+    while (*line) {
+        char *next = strchr(line, '\n');
+        if (next) *next = '\0';
+
+        const char *p = skip_space(line);
+        if (*p == '{') {
+            cast->width = header_int(p, "\"width\"");
+            cast->height = header_int(p, "\"height\"");
+        } else if (*p == '[') {
+            /* [time, "type", "data"] */
+            char *end;
+            double t = strtod(p + 1, &end);
+            p = skip_space(end);
+            if (*p == ',') p = skip_space(p + 1);
+            char type = (p[0] == '"' && p[1] && p[2] == '"') ? p[1] : 0;
+            if (type) p = skip_space(p + 3);
+            if (type && *p == ',') p = skip_space(p + 1);
+
+            size_t len = 0;
+            if ((type == 'o' || type == 'i') && *p == '"' &&
+                read_json_string(p + 1, cast->data + used, &len)) {
+                if (cast->count == capacity) {
+                    int grown = capacity ? capacity * 2 : 1024;
+                    term_cast_event_t *events = realloc(cast->events, (size_t)grown * sizeof(*events));
+                    if (!events) {
+                        free(text);
+                        term_cast_free(cast);
+                        errno = ENOMEM;
+                        return NULL;
+                    }
+                    cast->events = events;
+                    capacity = grown;
+                }
+                term_cast_event_t *ev = &cast->events[cast->count++];
+                ev->time = t;
+                ev->type = type;
+                ev->offset = used;
+                ev->length = len;
+                used += len;
+                if (type == 'o') cast->output_bytes += len;
+            }
+        }
+
+        if (!next) break;
+        line = next + 1;
+    }
+
+    free(text);
+    return cast;
+}
+
+/**
+ * Free a loaded recording
+ */
+void term_cast_free(term_cast_t *cast) {
+    if (cast) {
+        free(cast->events);
+        free(cast->data);
+        free(cast);
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * Terminal Session Recording for WeActTerm
+ *
+ * asciicast v2 files (asciinema): a JSON header line, then one event per
+ * line, [seconds, "o" or "i", "data"], for output and typed input.
+ * The writer keeps UTF-8 sequences split across reads together so every
+ * event is valid JSON; the reader loads the output and input events of
+ * a recording for replay.
+ */
+
+#ifndef TERM_CAST_H
+#define TERM_CAST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Recording in progress */
+typedef struct {
+    FILE *file;
+    long long start_us;          /* CLOCK_MONOTONIC at creation */
+    uint8_t carry[2][4];         /* Incomplete UTF-8 tail: output, input */
+    size_t carry_len[2];
+} term_cast_writer_t;
+
+/* Replayable event */
+typedef struct {
+    double time;                 /* Seconds from the start */
+    char type;                   /* 'o' output, 'i' input */
+    size_t offset;               /* Data in term_cast_t.data */
+    size_t length;
+} term_cast_event_t;
+
+/* Loaded recording */
+typedef struct {
+    int width;                   /* From the header, 0 if absent */
+    int height;
+    term_cast_event_t *events;
+    int count;
+    char *data;                  /* All event data, unescaped */
+    size_t output_bytes;         /* Total length of output events */
+} term_cast_t;
+
+/**
+ * Start a recording
+ * @return Writer or NULL on error (errno set)
+ */
+term_cast_writer_t* term_cast_create(const char *path, int cols, int rows);
+
+/**
+ * Append an event stamped with the time since term_cast_create()
+ * @param type 'o' for output, 'i' for input
+ */
+bool term_cast_write(term_cast_writer_t *writer, char type, const char *data, size_t len);
+
+/**
+ * Finish and close a recording
+ */
+void term_cast_close(term_cast_writer_t *writer);
+
+/**
+ * Load a recording; events other than output and input are skipped
+ * @return Recording or NULL on error (errno set)
+ */
+term_cast_t* term_cast_load(const char *path);
+
+/**
+ * Free a loaded recording
+ */
+void term_cast_free(term_cast_t *cast);
+
+#endif /* TERM_CAST_H */
@@ -0,0 +1,1272 @@
+/**
+ * Terminal Emulator Core Implementation
+ * DEC/ECMA-48 escape sequence parser and screen model
+ */
+
+#include "term_emu.h"
+#include "weact_display.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+/* Parser states */
+enum {
+    STATE_GROUND = 0,
+    STATE_ESCAPE,
+    STATE_ESCAPE_INTERMEDIATE,
+    STATE_CSI_ENTRY,
+    STATE_CSI_PARAM,
+    STATE_CSI_INTERMEDIATE,
+    STATE_CSI_IGNORE,
+    STATE_OSC_STRING,
+    STATE_STRING,             /* DCS, SOS, PM, APC: consumed up to ST */
+    STATE_COUNT
+};
+
+/* Transition actions */
+enum {
+    ACTION_NONE = 0,
+    ACTION_PRINT,
+    ACTION_EXECUTE,
+    ACTION_COLLECT,
+    ACTION_PARAM,
+    ACTION_ESC_DISPATCH,
+    ACTION_CSI_DISPATCH,
+    ACTION_IGNORE
+};
+
+/* Transition table: action << 4 | next state, built once */
+static uint8_t parse_table[STATE_COUNT][256];
+static bool tables_ready;
+
+/* xterm 256-colour palette in BRG565 */
+static uint16_t palette[256];
+
+static const uint8_t basic_colors[16][3] = {
+    {0x00, 0x00, 0x00}, {0xCD, 0x00, 0x00}, {0x00, 0xCD, 0x00}, {0xCD, 0xCD, 0x00},
+    {0x00, 0x00, 0xEE}, {0xCD, 0x00, 0xCD}, {0x00, 0xCD, 0xCD}, {0xE5, 0xE5, 0xE5},
+    {0x7F, 0x7F, 0x7F}, {0xFF, 0x00, 0x00}, {0x00, 0xFF, 0x00}, {0xFF, 0xFF, 0x00},
+    {0x5C, 0x5C, 0xFF}, {0xFF, 0x00, 0xFF}, {0x00, 0xFF, 0xFF}, {0xFF, 0xFF, 0xFF}
+};
+
+/* DEC special graphics for 0x5F-0x7E (ESC ( 0) */
+static const uint16_t line_drawing[32] = {
+    0x0020, 0x25C6, 0x2592, 0x2409, 0x240C, 0x240D, 0x240A, 0x00B0,
+    0x00B1, 0x2424, 0x240B, 0x2518, 0x2510, 0x250C, 0x2514, 0x253C,
+    0x23BA, 0x23BB, 0x2500, 0x23BC, 0x23BD, 0x251C, 0x2524, 0x2534,
+    0x252C, 0x2502, 0x2264, 0x2265, 0x03C0, 0x2260, 0x00A3, 0x00B7
+};
+
+/* ===== Tables ===== */
+
+static void set_transition(int state, int first, int last, int action, int next) {
+    for (int c = first; c <= last; c++) {
+        parse_table[state][c] = (uint8_t)((action << 4) | next);
+    }
+}
+
+static void build_tables(void) {
+    for (int s = 0; s < STATE_COUNT; s++) {
+        /* C0 controls execute in the middle of a sequence */
+        set_transition(s, 0x00, 0x1F, ACTION_EXECUTE, s);
+        set_transition(s, 0x20, 0xFF, ACTION_IGNORE, s);
+
+        /* Anywhere: CAN and SUB abort, ESC starts over */
+        set_transition(s, 0x18, 0x18, ACTION_EXECUTE, STATE_GROUND);
+        set_transition(s, 0x1A, 0x1A, ACTION_EXECUTE, STATE_GROUND);
+        set_transition(s, 0x1B, 0x1B, ACTION_NONE, STATE_ESCAPE);
+    }
+
+    /* High bytes are text (UTF-8), never 8-bit C1 controls */
+    set_transition(STATE_GROUND, 0x20, 0x7E, ACTION_PRINT, STATE_GROUND);
+    set_transition(STATE_GROUND, 0x80, 0xFF, ACTION_PRINT, STATE_GROUND);
+
+    set_transition(STATE_ESCAPE, 0x20, 0x2F, ACTION_COLLECT, STATE_ESCAPE_INTERMEDIATE);
+    set_transition(STATE_ESCAPE, 0x30, 0x7E, ACTION_ESC_DISPATCH, STATE_GROUND);
+    set_transition(STATE_ESCAPE, '[', '[', ACTION_NONE, STATE_CSI_ENTRY);
+    set_transition(STATE_ESCAPE, ']', ']', ACTION_NONE, STATE_OSC_STRING);
+    set_transition(STATE_ESCAPE, 'P', 'P', ACTION_NONE, STATE_STRING);
+    set_transition(STATE_ESCAPE, 'X', 'X', ACTION_NONE, STATE_STRING);
+    set_transition(STATE_ESCAPE, '^', '_', ACTION_NONE, STATE_STRING);
+
+    set_transition(STATE_ESCAPE_INTERMEDIATE, 0x20, 0x2F, ACTION_COLLECT, STATE_ESCAPE_INTERMEDIATE);
+    set_transition(STATE_ESCAPE_INTERMEDIATE, 0x30, 0x7E, ACTION_ESC_DISPATCH, STATE_GROUND);
+
+    set_transition(STATE_CSI_ENTRY, 0x20, 0x2F, ACTION_COLLECT, STATE_CSI_INTERMEDIATE);
+    set_transition(STATE_CSI_ENTRY, 0x30, 0x39, ACTION_PARAM, STATE_CSI_PARAM);
+    set_transition(STATE_CSI_ENTRY, 0x3A, 0x3A, ACTION_NONE, STATE_CSI_IGNORE);
+    set_transition(STATE_CSI_ENTRY, 0x3B, 0x3B, ACTION_PARAM, STATE_CSI_PARAM);
+    set_transition(STATE_CSI_ENTRY, 0x3C, 0x3F, ACTION_COLLECT, STATE_CSI_PARAM);
+    set_transition(STATE_CSI_ENTRY, 0x40, 0x7E, ACTION_CSI_DISPATCH, STATE_GROUND);
+
+    set_transition(STATE_CSI_PARAM, 0x20, 0x2F, ACTION_COLLECT, STATE_CSI_INTERMEDIATE);
+    set_transition(STATE_CSI_PARAM, 0x30, 0x39, ACTION_PARAM, STATE_CSI_PARAM);
+    set_transition(STATE_CSI_PARAM, 0x3A, 0x3A, ACTION_NONE, STATE_CSI_IGNORE);
+    set_transition(STATE_CSI_PARAM, 0x3B, 0x3B, ACTION_PARAM, STATE_CSI_PARAM);
+    set_transition(STATE_CSI_PARAM, 0x3C, 0x3F, ACTION_NONE, STATE_CSI_IGNORE);
+    set_transition(STATE_CSI_PARAM, 0x40, 0x7E, ACTION_CSI_DISPATCH, STATE_GROUND);
+
+    set_transition(STATE_CSI_INTERMEDIATE, 0x20, 0x2F, ACTION_COLLECT, STATE_CSI_INTERMEDIATE);
+    set_transition(STATE_CSI_INTERMEDIATE, 0x30, 0x3F, ACTION_NONE, STATE_CSI_IGNORE);
+    set_transition(STATE_CSI_INTERMEDIATE, 0x40, 0x7E, ACTION_CSI_DISPATCH, STATE_GROUND);
+
+    set_transition(STATE_CSI_IGNORE, 0x40, 0x7E, ACTION_NONE, STATE_GROUND);
+
+    /* Strings swallow C0 controls; BEL also ends OSC (xterm) */
+    int strings[2] = { STATE_OSC_STRING, STATE_STRING };
+    for (int i = 0; i < 2; i++) {
+        set_transition(strings[i], 0x00, 0x17, ACTION_IGNORE, strings[i]);
+        set_transition(strings[i], 0x19, 0x19, ACTION_IGNORE, strings[i]);
+        set_transition(strings[i], 0x1C, 0x1F, ACTION_IGNORE, strings[i]);
+    }
+    set_transition(STATE_OSC_STRING, 0x07, 0x07, ACTION_NONE, STATE_GROUND);
+
+    /* 16 system colours, 6x6x6 cube, 24 greys */
+    static const uint8_t levels[6] = { 0x00, 0x5F, 0x87, 0xAF, 0xD7, 0xFF };
+    for (int i = 0; i < 16; i++) {
+        palette[i] = weact_rgb_to_brg565(basic_colors[i][0], basic_colors[i][1], basic_colors[i][2]);
+    }
+    for (int i = 0; i < 216; i++) {
+        palette[16 + i] = weact_rgb_to_brg565(levels[i / 36], levels[(i / 6) % 6], levels[i % 6]);
+    }
+    for (int i = 0; i < 24; i++) {
+        uint8_t v = (uint8_t)(8 + i * 10);
+        palette[232 + i] = weact_rgb_to_brg565(v, v, v);
+    }
+
+    tables_ready = true;
+}
+
+/* ===== Character width ===== */
+
+/* Zero-width ranges: combining marks, joiners, variation selectors */
+static const uint32_t zero_width[][2] = {
+    { 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x05BF, 0x05BF },
+    { 0x05C1, 0x05C2 }, { 0x05C4, 0x05C5 }, { 0x05C7, 0x05C7 }, { 0x0610, 0x061A },
+    { 0x064B, 0x065F }, { 0x0670, 0x0670 }, { 0x06D6, 0x06DC }, { 0x06DF, 0x06E4 },
+    { 0x06E7, 0x06E8 }, { 0x06EA, 0x06ED }, { 0x0900, 0x0902 }, { 0x093A, 0x093A },
+    { 0x093C, 0x093C }, { 0x0941, 0x0948 }, { 0x094D, 0x094D }, { 0x0951, 0x0957 },
+    { 0x0962, 0x0963 }, { 0x0E31, 0x0E31 }, { 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E },
+    { 0x1AB0, 0x1AFF }, { 0x1DC0, 0x1DFF }, { 0x200B, 0x200F }, { 0x202A, 0x202E },
+    { 0x2060, 0x2064 }, { 0x20D0, 0x20FF }, { 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F },
+    { 0xFEFF, 0xFEFF }, { 0xE0100, 0xE01EF }
+};
+
+/* Double-width ranges: East Asian Wide / Fullwidth and emoji */
+static const uint32_t double_width[][2] = {
+    { 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC },
+    { 0x23F0, 0x23F0 }, { 0x23F3, 0x23F3 }, { 0x25FD, 0x25FE }, { 0x2614, 0x2615 },
+    { 0x2648, 0x2653 }, { 0x267F, 0x267F }, { 0x2693, 0x2693 }, { 0x26A1, 0x26A1 },
+    { 0x26AA, 0x26AB }, { 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 }, { 0x26CE, 0x26CE },
+    { 0x26D4, 0x26D4 }, { 0x26EA, 0x26EA }, { 0x26F2, 0x26F3 }, { 0x26F5, 0x26F5 },
+    { 0x26FA, 0x26FA }, { 0x26FD, 0x26FD }, { 0x2705, 0x2705 }, { 0x270A, 0x270B },
+    { 0x2728, 0x2728 }, { 0x274C, 0x274C }, { 0x274E, 0x274E }, { 0x2753, 0x2755 },
+    { 0x2757, 0x2757 }, { 0x2795, 0x2797 }, { 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF },
+    { 0x2B1B, 0x2B1C }, { 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 }, { 0x2E80, 0x303E },
+    { 0x3041, 0x33FF }, { 0x3400, 0x4DBF }, { 0x4E00, 0x9FFF }, { 0xA000, 0xA4CF },
+    { 0xA960, 0xA97F }, { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 },
+    { 0xFE30, 0xFE6F }, { 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x16FE0, 0x16FE4 },
+    { 0x17000, 0x18AFF }, { 0x1B000, 0x1B2FF }, { 0x1F004, 0x1F004 }, { 0x1F0CF, 0x1F0CF },
+    { 0x1F18E, 0x1F18E }, { 0x1F191, 0x1F19A }, { 0x1F200, 0x1F2FF }, { 0x1F300, 0x1F64F },
+    { 0x1F680, 0x1F6FF }, { 0x1F7E0, 0x1F7EB }, { 0x1F90C, 0x1F9FF }, { 0x1FA70, 0x1FAFF },
+    { 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD }
+};
+
+static bool in_ranges(uint32_t cp, const uint32_t (*ranges)[2], int count) {
+    int lo = 0;
+    int hi = count - 1;
+
+    if (cp < ranges[0][0] || cp > ranges[hi][1]) return false;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (cp < ranges[mid][0]) {
+            hi = mid - 1;
+        } else if (cp > ranges[mid][1]) {
+            lo = mid + 1;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ===== Screen helpers ===== */
+
+static term_cell_t* row_cells(term_emu_t *term, int row) {
+    return term->screen + (size_t)row * term->cols;
+}
+
+/* Mark rows first..last (inclusive) as changed */
+static void damage_rows(term_emu_t *term, int first, int last) {
+    if (first < 0) first = 0;
+    if (last >= term->rows) last = term->rows - 1;
+    if (first <= last) memset(term->dirty + first, 1, (size_t)(last - first + 1));
+}
+
+static void clear_cells(term_emu_t *term, term_cell_t *cells, int count) {
+    if (count <= 0) return;
+
+    for (int i = 0; i < count; i++) {
+        cells[i] = term->blank;
+    }
+
+    /* Only the active screen is visible */
+    if (cells >= term->screen && cells < term->screen + (size_t)term->rows * term->cols) {
+        int first = (int)((cells - term->screen) / term->cols);
+        int last = (int)((cells + count - 1 - term->screen) / term->cols);
+        damage_rows(term, first, last);
+    }
+}
+
+static uint16_t resolve_color(int32_t color, bool foreground, uint8_t attr) {
+    uint16_t out;
+
+    if (color < 0) {
+        out = foreground ? WEACT_WHITE : WEACT_BLACK;
+    } else if (color < 256) {
+        /* Bold brightens the eight basic colours */
+        if (foreground && (attr & TERM_ATTR_BOLD) && color < 8) color += 8;
+        out = palette[color];
+    } else {
+        out = weact_rgb_to_brg565((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+    }
+
+    /* Half intensity: halve each BRG565 channel */
+    if (foreground && (attr & TERM_ATTR_DIM)) out = (out >> 1) & 0x7BDF;
+    return out;
+}
+
+/* Erase cell follows the background colour of the pen (xterm BCE) */
+static void update_blank(term_emu_t *term) {
+    term->blank.codepoint = ' ';
+    term->blank.fg = resolve_color(-1, true, 0);
+    term->blank.bg = resolve_color(term->pen.bg, false, 0);
+    term->blank.attr = 0;
+}
+
+static void reply(term_emu_t *term, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(term->reply + term->reply_len, sizeof(term->reply) - term->reply_len, fmt, args);
+    va_end(args);
+
+    if (n > 0 && term->reply_len + (size_t)n < sizeof(term->reply)) {
+        term->reply_len += (size_t)n;
+    } else {
+        term->reply[term->reply_len] = '\0';  /* Drop replies that do not fit */
+    }
+}
+
+/* ===== Scrollback =====
+ *
+ * Lines scrolled off the top are stored back to back in a byte ring, each
+ * as: varint cell count, varint text bytes, UTF-8 text, then attribute
+ * runs (varint length, fg, bg, attr) covering the cells. Trailing blanks
+ * are dropped. A ring of start positions indexes the lines, so appending
+ * and looking up a line are O(1); the oldest lines are dropped when either
+ * ring is full.
+ */
+
+static size_t put_varint(uint8_t *out, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static uint32_t get_varint(const uint8_t **p) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = *(*p)++;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    return value;
+}
+
+static uint32_t utf8_next(const uint8_t **p) {
+    const uint8_t *s = *p;
+    uint32_t cp;
+    int extra;
+
+    if (s[0] < 0x80) { cp = s[0]; extra = 0; }
+    else if (s[0] < 0xE0) { cp = s[0] & 0x1F; extra = 1; }
+    else if (s[0] < 0xF0) { cp = s[0] & 0x0F; extra = 2; }
+    else { cp = s[0] & 0x07; extra = 3; }
+
+    for (int i = 1; i <= extra; i++) {
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *p = s + 1 + extra;
+    return cp;
+}
+
+/* Cell of a blank history position */
+static term_cell_t history_blank(void) {
+    term_cell_t cell = { ' ', WEACT_WHITE, WEACT_BLACK, 0 };
+    return cell;
+}
+
+static bool same_style(const term_cell_t *a, const term_cell_t *b) {
+    return a->fg == b->fg && a->bg == b->bg && a->attr == b->attr;
+}
+
+/* Worst case record size for a line of cols cells */
+static size_t history_record_max(int cols) {
+    return 10 + (size_t)cols * (4 + 5 + 5);
+}
+
+static size_t encode_line(const term_cell_t *line, int cols, uint8_t *out) {
+    term_cell_t blank = history_blank();
+    int count = cols;
+    while (count > 0 && line[count - 1].codepoint == ' ' &&
+           same_style(&line[count - 1], &blank)) {
+        count--;
+    }
+
+    /* Header holds the text length, so measure first */
+    size_t text_len = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t cp = line[i].codepoint;
+        text_len += cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+    }
+
+    size_t n = put_varint(out, (uint32_t)count);
+    n += put_varint(out + n, (uint32_t)text_len);
+    for (int i = 0; i < count; i++) {
+        n += term_utf8_encode(line[i].codepoint, (char *)out + n);
+    }
+
+    for (int i = 0; i < count; ) {
+        int run = 1;
+        while (i + run < count && same_style(&line[i + run], &line[i])) run++;
+
+        n += put_varint(out + n, (uint32_t)run);
+        out[n++] = (uint8_t)(line[i].fg >> 8);
+        out[n++] = (uint8_t)line[i].fg;
+        out[n++] = (uint8_t)(line[i].bg >> 8);
+        out[n++] = (uint8_t)line[i].bg;
+        out[n++] = line[i].attr;
+        i += run;
+    }
+    return n;
+}
+
+static void drop_oldest_history(term_emu_t *term) {
+    term->history_first = (term->history_first + 1) % term->history_capacity;
+    term->history_count--;
+}
+
+static void push_history(term_emu_t *term, const term_cell_t *line) {
+    if (term->history_capacity == 0) return;
+
+    size_t len = encode_line(line, term->cols, term->history_scratch);
+
+    /* Make room in both rings */
+    while (term->history_count > 0) {
+        uint64_t oldest = term->history_lines[term->history_first];
+        bool bytes_full = term->history_end + len - oldest > term->history_size;
+        if (!bytes_full && term->history_count < term->history_capacity) break;
+        drop_oldest_history(term);
+    }
+
+    int slot = (term->history_first + term->history_count) % term->history_capacity;
+    term->history_lines[slot] = term->history_end;
+    term->history_count++;
+
+    /* Copy in, wrapping at the end of the ring */
+    size_t pos = (size_t)(term->history_end % term->history_size);
+    size_t first = term->history_size - pos < len ? term->history_size - pos : len;
+    memcpy(term->history + pos, term->history_scratch, first);
+    memcpy(term->history, term->history_scratch + first, len - first);
+    term->history_end += len;
+}
+
+static void clear_history(term_emu_t *term) {
+    term->history_count = 0;
+    term->history_first = 0;
+}
+
+/* Scroll rows top..bottom (inclusive) up by n, blanking the bottom */
+static void scroll_up(term_emu_t *term, int top, int bottom, int n) {
+    int height = bottom - top + 1;
+    if (n > height) n = height;
+    if (n <= 0) return;
+
+    memmove(row_cells(term, top), row_cells(term, top + n),
+            (size_t)(height - n) * term->cols * sizeof(term_cell_t));
+    clear_cells(term, row_cells(term, bottom - n + 1), n * term->cols);
+    damage_rows(term, top, bottom);
+}
+
+static void scroll_down(term_emu_t *term, int top, int bottom, int n) {
+    int height = bottom - top + 1;
+    if (n > height) n = height;
+    if (n <= 0) return;
+
+    memmove(row_cells(term, top + n), row_cells(term, top),
+            (size_t)(height - n) * term->cols * sizeof(term_cell_t));
+    clear_cells(term, row_cells(term, top), n * term->cols);
+    damage_rows(term, top, bottom);
+}
+
+static void line_feed(term_emu_t *term) {
+    term->wrap_pending = false;
+
+    if (term->cursor_y == term->scroll_bottom) {
+        if (term->scroll_top == 0 && !term->alt_screen) {
+            push_history(term, row_cells(term, 0));
+        }
+        scroll_up(term, term->scroll_top, term->scroll_bottom, 1);
+    } else if (term->cursor_y < term->rows - 1) {
+        term->cursor_y++;
+    }
+}
+
+static void reverse_index(term_emu_t *term) {
+    term->wrap_pending = false;
+
+    if (term->cursor_y == term->scroll_top) {
+        scroll_down(term, term->scroll_top, term->scroll_bottom, 1);
+    } else if (term->cursor_y > 0) {
+        term->cursor_y--;
+    }
+}
+
+/* Move cursor, clamped to the screen (or the scroll region in origin mode) */
+static void set_cursor(term_emu_t *term, int x, int y) {
+    int top = term->origin_mode ? term->scroll_top : 0;
+    int bottom = term->origin_mode ? term->scroll_bottom : term->rows - 1;
+
+    term->cursor_x = x < 0 ? 0 : (x >= term->cols ? term->cols - 1 : x);
+    term->cursor_y = y < top ? top : (y > bottom ? bottom : y);
+    term->wrap_pending = false;
+}
+
+static void insert_cells(term_emu_t *term, int n) {
+    term_cell_t *line = row_cells(term, term->cursor_y);
+    int x = term->cursor_x;
+    if (n > term->cols - x) n = term->cols - x;
+
+    memmove(line + x + n, line + x, (size_t)(term->cols - x - n) * sizeof(term_cell_t));
+    clear_cells(term, line + x, n);
+}
+
+static void delete_cells(term_emu_t *term, int n) {
+    term_cell_t *line = row_cells(term, term->cursor_y);
+    int x = term->cursor_x;
+    if (n > term->cols - x) n = term->cols - x;
+
+    memmove(line + x, line + x + n, (size_t)(term->cols - x - n) * sizeof(term_cell_t));
+    clear_cells(term, line + term->cols - n, n);
+}
+
+static void save_cursor(term_emu_t *term) {
+    term_saved_t *s = &term->saved[term->alt_screen];
+    s->x = term->cursor_x;
+    s->y = term->cursor_y;
+    s->pen = term->pen;
+    s->origin_mode = term->origin_mode;
+    s->wrap_pending = term->wrap_pending;
+    memcpy(s->charset, term->charset, sizeof(s->charset));
+    s->active_charset = term->active_charset;
+}
+
+static void restore_cursor(term_emu_t *term) {
+    const term_saved_t *s = &term->saved[term->alt_screen];
+    term->pen = s->pen;
+    term->origin_mode = s->origin_mode;
+    memcpy(term->charset, s->charset, sizeof(term->charset));
+    term->active_charset = s->active_charset;
+    update_blank(term);
+
+    term->cursor_x = s->x < term->cols ? s->x : term->cols - 1;
+    term->cursor_y = s->y < term->rows ? s->y : term->rows - 1;
+    term->wrap_pending = s->wrap_pending;
+}
+
+static void set_alt_screen(term_emu_t *term, bool enable, bool clear) {
+    if (enable == term->alt_screen) return;
+
+    term->alt_screen = enable;
+    term->screen = enable ? term->alternate : term->primary;
+    if (enable && clear) clear_cells(term, term->alternate, term->rows * term->cols);
+    damage_rows(term, 0, term->rows - 1);
+}
+
+/* Power-on state (RIS); scrollback is kept */
+static void reset_state(term_emu_t *term) {
+    term->pen.fg = -1;
+    term->pen.bg = -1;
+    term->pen.attr = 0;
+    update_blank(term);
+
+    term->alt_screen = false;
+    term->screen = term->primary;
+    clear_cells(term, term->primary, term->rows * term->cols);
+    clear_cells(term, term->alternate, term->rows * term->cols);
+
+    term->cursor_x = 0;
+    term->cursor_y = 0;
+    term->wrap_pending = false;
+    term->cursor_visible = true;
+    term->scroll_top = 0;
+    term->scroll_bottom = term->rows - 1;
+    term->origin_mode = false;
+    term->autowrap = true;
+    term->insert_mode = false;
+    term->app_cursor_keys = false;
+    term->charset[0] = 'B';
+    term->charset[1] = 'B';
+    term->active_charset = 0;
+    term->last_char = 0;
+
+    save_cursor(term);
+    term->saved[1] = term->saved[0];
+}
+
+/* ===== Actions ===== */
+
+/* Blank the other half of a wide character about to be split at x */
+static void split_wide(term_emu_t *term, term_cell_t *line, int x) {
+    if (x < 0 || x >= term->cols) return;
+
+    if (line[x].codepoint == TERM_WIDE_CONTINUATION && x > 0) {
+        line[x - 1] = term->blank;
+    }
+    if ((line[x].attr & TERM_ATTR_WIDE) && x + 1 < term->cols) {
+        line[x + 1] = term->blank;
+    }
+}
+
+static void print(term_emu_t *term, uint32_t codepoint) {
+    if (term->charset[term->active_charset] == '0' && codepoint >= 0x5F && codepoint <= 0x7E) {
+        codepoint = line_drawing[codepoint - 0x5F];
+    }
+
+    /* Combining marks cannot be composed onto the previous glyph: dropped */
+    int width = term_char_width(codepoint);
+    if (width == 0) return;
+    if (width > term->cols) width = 1;
+
+    if (term->wrap_pending) {
+        term->cursor_x = 0;
+        line_feed(term);
+    }
+
+    /* A wide character does not fit in the last column */
+    if (width == 2 && term->cursor_x == term->cols - 1) {
+        if (term->autowrap) {
+            split_wide(term, row_cells(term, term->cursor_y), term->cursor_x);
+            row_cells(term, term->cursor_y)[term->cursor_x] = term->blank;
+            term->cursor_x = 0;
+            line_feed(term);
+        } else {
+            term->cursor_x--;
+        }
+    }
+    if (term->insert_mode) insert_cells(term, width);
+
+    term_cell_t *line = row_cells(term, term->cursor_y);
+    split_wide(term, line, term->cursor_x);
+    split_wide(term, line, term->cursor_x + width - 1);
+
+    term_cell_t *cell = line + term->cursor_x;
+    cell->codepoint = codepoint;
+    cell->fg = resolve_color(term->pen.fg, true, term->pen.attr);
+    cell->bg = resolve_color(term->pen.bg, false, term->pen.attr);
+    cell->attr = term->pen.attr;
+    if (width == 2) {
+        cell->attr |= TERM_ATTR_WIDE;
+        cell[1] = *cell;
+        cell[1].codepoint = TERM_WIDE_CONTINUATION;
+        cell[1].attr &= (uint8_t)~TERM_ATTR_WIDE;
+    }
+    term->dirty[term->cursor_y] = 1;
+    term->last_char = codepoint;
+
+    if (term->cursor_x + width < term->cols) {
+        term->cursor_x += width;
+    } else {
+        term->cursor_x = term->cols - 1;
+        term->wrap_pending = term->autowrap;
+    }
+}
+
+/* Incremental UTF-8 decoder: state survives between reads. Malformed
+ * input (overlong forms, surrogates, stray bytes) prints U+FFFD. */
+static void decode_utf8(term_emu_t *term, uint8_t c) {
+    if (term->utf8_remaining > 0) {
+        /* Continuation byte: anything else was handled by the caller */
+        term->utf8_codepoint = (term->utf8_codepoint << 6) | (c & 0x3F);
+        if (--term->utf8_remaining == 0) {
+            uint32_t cp = term->utf8_codepoint;
+            bool valid = cp >= term->utf8_min && cp <= 0x10FFFF && (cp < 0xD800 || cp > 0xDFFF);
+            print(term, valid ? cp : TERM_REPLACEMENT_CHAR);
+        }
+        return;
+    }
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        term->utf8_codepoint = c & 0x1F;
+        term->utf8_remaining = 1;
+        term->utf8_min = 0x80;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        term->utf8_codepoint = c & 0x0F;
+        term->utf8_remaining = 2;
+        term->utf8_min = 0x800;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        term->utf8_codepoint = c & 0x07;
+        term->utf8_remaining = 3;
+        term->utf8_min = 0x10000;
+    } else {
+        print(term, TERM_REPLACEMENT_CHAR);
+    }
+}
+
+static void execute(term_emu_t *term, uint8_t c) {
+    switch (c) {
+        case '\b':
+            if (term->cursor_x > 0) term->cursor_x--;
+            term->wrap_pending = false;
+            break;
+        case '\t': {
+            int x = (term->cursor_x / 8 + 1) * 8;
+            term->cursor_x = x < term->cols ? x : term->cols - 1;
+            term->wrap_pending = false;
+            break;
+        }
+        case '\n':
+        case '\v':
+        case '\f':
+            line_feed(term);
+            break;
+        case '\r':
+            term->cursor_x = 0;
+            term->wrap_pending = false;
+            break;
+        case 0x0E:  /* SO */
+            term->active_charset = 1;
+            break;
+        case 0x0F:  /* SI */
+            term->active_charset = 0;
+            break;
+        default:
+            break;  /* BEL, NUL, ... */
+    }
+}
+
+static void clear_sequence(term_emu_t *term) {
+    memset(term->params, 0, sizeof(term->params));
+    term->param_count = 0;
+    term->intermediate = 0;
+    term->private_marker = 0;
+}
+
+static void collect(term_emu_t *term, uint8_t c) {
+    if (c >= 0x3C && c <= 0x3F) {
+        term->private_marker = (char)c;
+    } else {
+        term->intermediate = (char)c;
+    }
+}
+
+static void param(term_emu_t *term, uint8_t c) {
+    if (term->param_count == 0) term->param_count = 1;
+
+    if (c == ';') {
+        if (term->param_count < TERM_MAX_PARAMS) term->param_count++;
+        return;
+    }
+
+    int *p = &term->params[term->param_count - 1];
+    *p = *p * 10 + (c - '0');
+    if (*p > 65535) *p = 65535;
+}
+
+static void esc_dispatch(term_emu_t *term, uint8_t c) {
+    if (term->intermediate == '(' || term->intermediate == ')') {
+        term->charset[term->intermediate == ')'] = c == '0' ? '0' : 'B';
+        return;
+    }
+
+    if (term->intermediate == '#' && c == '8') {
+        /* DECALN: screen alignment pattern */
+        for (int i = 0; i < term->rows * term->cols; i++) {
+            term->screen[i] = term->blank;
+            term->screen[i].codepoint = 'E';
+        }
+        damage_rows(term, 0, term->rows - 1);
+        return;
+    }
+    if (term->intermediate) return;
+
+    switch (c) {
+        case '7': save_cursor(term); break;
+        case '8': restore_cursor(term); break;
+        case 'D': line_feed(term); break;
+        case 'E':
+            term->cursor_x = 0;
+            line_feed(term);
+            break;
+        case 'M': reverse_index(term); break;
+        case 'c': reset_state(term); break;
+        default: break;  /* Keypad modes, ST, ... */
+    }
+}
+
+/* Numeric parameter with default for missing or zero values */
+static int arg(const term_emu_t *term, int i, int def) {
+    return (i < term->param_count && term->params[i] > 0) ? term->params[i] : def;
+}
+
+static int32_t extended_color(const term_emu_t *term, int *i) {
+    int kind = *i + 1 < term->param_count ? term->params[*i + 1] : 0;
+
+    if (kind == 5 && *i + 2 < term->param_count) {
+        *i += 2;
+        return term->params[*i] & 0xFF;
+    }
+    if (kind == 2 && *i + 4 < term->param_count) {
+        int r = term->params[*i + 2] & 0xFF;
+        int g = term->params[*i + 3] & 0xFF;
+        int b = term->params[*i + 4] & 0xFF;
+        *i += 4;
+        return 0x1000000 | (r << 16) | (g << 8) | b;
+    }
+    return -2;  /* Malformed: ignore */
+}
+
+static void select_graphic_rendition(term_emu_t *term) {
+    int count = term->param_count ? term->param_count : 1;
+    term_pen_t *pen = &term->pen;
+
+    for (int i = 0; i < count; i++) {
+        int p = term->params[i];
+
+        if (p == 0) {
+            pen->fg = -1;
+            pen->bg = -1;
+            pen->attr = 0;
+        } else if (p == 1) {
+            pen->attr |= TERM_ATTR_BOLD;
+        } else if (p == 2) {
+            pen->attr |= TERM_ATTR_DIM;
+        } else if (p == 4) {
+            pen->attr |= TERM_ATTR_UNDERLINE;
+        } else if (p == 7) {
+            pen->attr |= TERM_ATTR_REVERSE;
+        } else if (p == 8) {
+            pen->attr |= TERM_ATTR_INVISIBLE;
+        } else if (p == 22) {
+            pen->attr &= ~(TERM_ATTR_BOLD | TERM_ATTR_DIM);
+        } else if (p == 24) {
+            pen->attr &= ~TERM_ATTR_UNDERLINE;
+        } else if (p == 27) {
+            pen->attr &= ~TERM_ATTR_REVERSE;
+        } else if (p == 28) {
+            pen->attr &= ~TERM_ATTR_INVISIBLE;
+        } else if (p >= 30 && p <= 37) {
+            pen->fg = p - 30;
+        } else if (p == 38) {
+            int32_t color = extended_color(term, &i);
+            if (color != -2) pen->fg = color;
+        } else if (p == 39) {
+            pen->fg = -1;
+        } else if (p >= 40 && p <= 47) {
+            pen->bg = p - 40;
+        } else if (p == 48) {
+            int32_t color = extended_color(term, &i);
+            if (color != -2) pen->bg = color;
+        } else if (p == 49) {
+            pen->bg = -1;
+        } else if (p >= 90 && p <= 97) {
+            pen->fg = p - 90 + 8;
+        } else if (p >= 100 && p <= 107) {
+            pen->bg = p - 100 + 8;
+        }
+    }
+
+    update_blank(term);
+}
+
+static void set_mode(term_emu_t *term, bool enable) {
+    for (int i = 0; i < (term->param_count ? term->param_count : 1); i++) {
+        int mode = term->params[i];
+
+        if (term->private_marker != '?') {
+            if (mode == 4) term->insert_mode = enable;
+            continue;
+        }
+
+        switch (mode) {
+            case 1:
+                term->app_cursor_keys = enable;
+                break;
+            case 6:
+                term->origin_mode = enable;
+                set_cursor(term, 0, term->origin_mode ? term->scroll_top : 0);
+                break;
+            case 7:
+                term->autowrap = enable;
+                break;
+            case 25:
+                term->cursor_visible = enable;
+                break;
+            case 47:
+            case 1047:
+                set_alt_screen(term, enable, true);
+                break;
+            case 1048:
+                if (enable) save_cursor(term);
+                else restore_cursor(term);
+                break;
+            case 1049:
+                if (enable) {
+                    save_cursor(term);
+                    set_alt_screen(term, true, true);
+                } else {
+                    set_alt_screen(term, false, false);
+                    restore_cursor(term);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void erase_display(term_emu_t *term, int mode) {
+    term_cell_t *cursor = row_cells(term, term->cursor_y) + term->cursor_x;
+    term_cell_t *end = term->screen + (size_t)term->rows * term->cols;
+
+    if (mode == 0) {
+        clear_cells(term, cursor, (int)(end - cursor));
+    } else if (mode == 1) {
+        clear_cells(term, term->screen, (int)(cursor - term->screen) + 1);
+    } else if (mode == 2 || mode == 3) {
+        clear_cells(term, term->screen, term->rows * term->cols);
+        if (mode == 3) clear_history(term);
+    }
+}
+
+static void erase_line(term_emu_t *term, int mode) {
+    term_cell_t *line = row_cells(term, term->cursor_y);
+
+    if (mode == 0) {
+        clear_cells(term, line + term->cursor_x, term->cols - term->cursor_x);
+    } else if (mode == 1) {
+        clear_cells(term, line, term->cursor_x + 1);
+    } else if (mode == 2) {
+        clear_cells(term, line, term->cols);
+    }
+}
+
+static void csi_dispatch(term_emu_t *term, uint8_t c) {
+    int n = arg(term, 0, 1);
+    int x = term->cursor_x;
+    int y = term->cursor_y;
+
+    if (term->intermediate) {
+        if (term->intermediate == '!' && c == 'p') {
+            /* DECSTR soft reset */
+            term->pen.fg = term->pen.bg = -1;
+            term->pen.attr = 0;
+            update_blank(term);
+            term->cursor_visible = true;
+            term->scroll_top = 0;
+            term->scroll_bottom = term->rows - 1;
+            term->origin_mode = false;
+            term->autowrap = true;
+            term->insert_mode = false;
+            term->app_cursor_keys = false;
+        }
+        return;  /* Cursor style and other intermediates ignored */
+    }
+
+    if (term->private_marker && c != 'h' && c != 'l' && c != 'c') return;
+
+    switch (c) {
+        case '@':  /* ICH */
+            insert_cells(term, n);
+            break;
+        case 'A': {  /* CUU: stops at the top margin from inside the region */
+            int top = y >= term->scroll_top ? term->scroll_top : 0;
+            term->cursor_y = y - n < top ? top : y - n;
+            term->wrap_pending = false;
+            break;
+        }
+        case 'B':  /* CUD */
+        case 'e': {  /* VPR */
+            int bottom = y <= term->scroll_bottom ? term->scroll_bottom : term->rows - 1;
+            term->cursor_y = y + n > bottom ? bottom : y + n;
+            term->wrap_pending = false;
+            break;
+        }
+        case 'C':  /* CUF */
+        case 'a':  /* HPR */
+            set_cursor(term, x + n, y);
+            break;
+        case 'D':  /* CUB */
+            set_cursor(term, x - n, y);
+            break;
+        case 'E':  /* CNL */
+            set_cursor(term, 0, y + n);
+            break;
+        case 'F':  /* CPL */
+            set_cursor(term, 0, y - n);
+            break;
+        case 'G':  /* CHA */
+        case '`':  /* HPA */
+            set_cursor(term, n - 1, y);
+            break;
+        case 'H':  /* CUP */
+        case 'f':  /* HVP */
+            set_cursor(term, arg(term, 1, 1) - 1,
+                       n - 1 + (term->origin_mode ? term->scroll_top : 0));
+            break;
+        case 'I':  /* CHT */
+            set_cursor(term, (x / 8 + n) * 8, y);
+            break;
+        case 'Z':  /* CBT */
+            set_cursor(term, ((x + 7) / 8 - n) * 8, y);
+            break;
+        case 'J':  /* ED */
+            erase_display(term, arg(term, 0, 0));
+            break;
+        case 'K':  /* EL */
+            erase_line(term, arg(term, 0, 0));
+            break;
+        case 'L':  /* IL */
+            if (y >= term->scroll_top && y <= term->scroll_bottom) {
+                scroll_down(term, y, term->scroll_bottom, n);
+                set_cursor(term, 0, y);
+            }
+            break;
+        case 'M':  /* DL */
+            if (y >= term->scroll_top && y <= term->scroll_bottom) {
+                scroll_up(term, y, term->scroll_bottom, n);
+                set_cursor(term, 0, y);
+            }
+            break;
+        case 'P':  /* DCH */
+            delete_cells(term, n);
+            break;
+        case 'S':  /* SU */
+            scroll_up(term, term->scroll_top, term->scroll_bottom, n);
+            break;
+        case 'T':  /* SD */
+            scroll_down(term, term->scroll_top, term->scroll_bottom, n);
+            break;
+        case 'X': {  /* ECH */
+            int count = n < term->cols - x ? n : term->cols - x;
+            clear_cells(term, row_cells(term, y) + x, count);
+            break;
+        }
+        case 'b':  /* REP */
+            for (int i = 0; i < n && term->last_char; i++) print(term, term->last_char);
+            break;
+        case 'c':  /* DA */
+            if (term->private_marker == '>') reply(term, "\033[>0;10;1c");
+            else if (!term->private_marker) reply(term, "\033[?1;2c");
+            break;
+        case 'd':  /* VPA */
+            set_cursor(term, x, n - 1 + (term->origin_mode ? term->scroll_top : 0));
+            break;
+        case 'h':  /* SM */
+            set_mode(term, true);
+            break;
+        case 'l':  /* RM */
+            set_mode(term, false);
+            break;
+        case 'm':  /* SGR */
+            select_graphic_rendition(term);
+            break;
+        case 'n':  /* DSR */
+            if (arg(term, 0, 0) == 5) {
+                reply(term, "\033[0n");
+            } else if (arg(term, 0, 0) == 6) {
+                reply(term, "\033[%d;%dR",
+                      y + 1 - (term->origin_mode ? term->scroll_top : 0), x + 1);
+            }
+            break;
+        case 'r': {  /* DECSTBM */
+            int top = arg(term, 0, 1) - 1;
+            int bottom = arg(term, 1, term->rows) - 1;
+            if (bottom >= term->rows) bottom = term->rows - 1;
+            if (top < bottom) {
+                term->scroll_top = top;
+                term->scroll_bottom = bottom;
+                set_cursor(term, 0, term->origin_mode ? top : 0);
+            }
+            break;
+        }
+        case 's':
+            save_cursor(term);
+            break;
+        case 'u':
+            restore_cursor(term);
+            break;
+        default:
+            break;
+    }
+}
+
+/* ===== Public API ===== */
+
+/**
+ * Create terminal
+ */
+term_emu_t* term_emu_create(int cols, int rows) {
+    if (cols <= 0 || rows <= 0) return NULL;
+    if (!tables_ready) build_tables();
+
+    term_emu_t *term = calloc(1, sizeof(term_emu_t));
+    if (!term) return NULL;
+
+    term->cols = cols;
+    term->rows = rows;
+    term->primary = calloc((size_t)cols * rows, sizeof(term_cell_t));
+    term->alternate = calloc((size_t)cols * rows, sizeof(term_cell_t));
+    term->dirty = calloc((size_t)rows, 1);
+    term->history_scratch = malloc(history_record_max(cols));
+    if (!term->primary || !term->alternate || !term->dirty || !term->history_scratch ||
+        !term_emu_set_scrollback(term, TERM_SCROLLBACK_LINES)) {
+        term_emu_destroy(term);
+        return NULL;
+    }
+
+    term->state = STATE_GROUND;
+    reset_state(term);
+    return term;
+}
+
+/**
+ * Destroy terminal
+ */
+void term_emu_destroy(term_emu_t *term) {
+    if (term) {
+        free(term->primary);
+        free(term->alternate);
+        free(term->dirty);
+        free(term->history);
+        free(term->history_lines);
+        free(term->history_scratch);
+        free(term);
+    }
+}
+
+/**
+ * Feed output through the parser
+ */
+void term_emu_feed(term_emu_t *term, const char *data, size_t len) {
+    if (!term || !data) return;
+
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = p[i];
+        uint8_t entry = parse_table[term->state][c];
+        int next = entry & 0x0F;
+
+        /* UTF-8 sequence cut short by anything but a continuation byte */
+        if (term->utf8_remaining > 0 && (c & 0xC0) != 0x80) {
+            term->utf8_remaining = 0;
+            print(term, TERM_REPLACEMENT_CHAR);
+        }
+
+        /* Entering ESCAPE or CSI starts a new sequence */
+        if (c == 0x1B || (next == STATE_CSI_ENTRY && term->state != STATE_CSI_ENTRY)) {
+            clear_sequence(term);
+        }
+
+        switch (entry >> 4) {
+            case ACTION_PRINT:
+                if (c < 0x80) print(term, c); else decode_utf8(term, c);
+                break;
+            case ACTION_EXECUTE:      execute(term, c); break;
+            case ACTION_COLLECT:      collect(term, c); break;
+            case ACTION_PARAM:        param(term, c); break;
+            case ACTION_ESC_DISPATCH: esc_dispatch(term, c); break;
+            case ACTION_CSI_DISPATCH: csi_dispatch(term, c); break;
+            default: break;
+        }
+
+        term->state = (uint8_t)next;
+    }
+}
+
+/**
+ * Get screen row
+ */
+const term_cell_t* term_emu_row(const term_emu_t *term, int row) {
+    if (!term || row < 0 || row >= term->rows) return NULL;
+    return term->screen + (size_t)row * term->cols;
+}
+
+/**
+ * Check row damage
+ */
+bool term_emu_row_dirty(const term_emu_t *term, int row) {
+    if (!term || row < 0 || row >= term->rows) return false;
+    return term->dirty[row] != 0;
+}
+
+/**
+ * Clear damage
+ */
+void term_emu_clear_damage(term_emu_t *term) {
+    if (term) memset(term->dirty, 0, (size_t)term->rows);
+}
+
+/**
+ * Store a cell directly
+ */
+bool term_emu_set_cell(term_emu_t *term, int x, int y, const term_cell_t *cell) {
+    if (!term || x < 0 || y < 0 || x >= term->cols || y >= term->rows) return false;
+
+    term_cell_t *dst = row_cells(term, y) + x;
+    if (dst->codepoint == cell->codepoint && dst->fg == cell->fg &&
+        dst->bg == cell->bg && dst->attr == cell->attr) {
+        return false;
+    }
+    *dst = *cell;
+    term->dirty[y] = 1;
+    return true;
+}
+
+/**
+ * Place cursor directly
+ */
+void term_emu_set_cursor(term_emu_t *term, int x, int y, bool visible) {
+    if (!term) return;
+    term->cursor_visible = visible;
+    term->origin_mode = false;
+    set_cursor(term, x, y);
+}
+
+/**
+ * Get palette colour
+ */
+uint16_t term_emu_color(int index) {
+    if (!tables_ready) build_tables();
+    return palette[index & 0xFF];
+}
+
+/**
+ * Set scrollback depth
+ */
+bool term_emu_set_scrollback(term_emu_t *term, int lines) {
+    if (!term || lines < 0 || lines > TERM_SCROLLBACK_MAX) return false;
+
+    size_t size = (size_t)lines * TERM_SCROLLBACK_LINE_BYTES;
+    if (size < history_record_max(term->cols)) size = history_record_max(term->cols);
+
+    uint8_t *data = malloc(size);
+    uint64_t *index = malloc((lines > 0 ? (size_t)lines : 1) * sizeof(uint64_t));
+    if (!data || !index) {
+        free(data);
+        free(index);
+        return false;
+    }
+
+    free(term->history);
+    free(term->history_lines);
+    term->history = data;
+    term->history_size = size;
+    term->history_lines = index;
+    term->history_capacity = lines;
+    term->history_end = 0;
+    clear_history(term);
+    return true;
+}
+
+/**
+ * Get scrollback line
+ */
+bool term_emu_history_line(const term_emu_t *term, int index, term_cell_t *cells, int cols) {
+    if (!term || !cells || index < 0 || index >= term->history_count) return false;
+
+    /* Copy the record out of the ring */
+    int slot = (term->history_first + term->history_count - 1 - index) % term->history_capacity;
+    int next = (slot + 1) % term->history_capacity;
+    uint64_t start = term->history_lines[slot];
+    uint64_t end = index == 0 ? term->history_end : term->history_lines[next];
+    size_t len = (size_t)(end - start);
+    size_t pos = (size_t)(start % term->history_size);
+    size_t first = term->history_size - pos < len ? term->history_size - pos : len;
+    memcpy(term->history_scratch, term->history + pos, first);
+    memcpy(term->history_scratch + first, term->history, len - first);
+
+    const uint8_t *p = term->history_scratch;
+    int count = (int)get_varint(&p);
+    uint32_t text_len = get_varint(&p);
+    const uint8_t *text = p;
+    const uint8_t *runs = p + text_len;
+
+    term_cell_t blank = history_blank();
+    for (int i = 0; i < cols; i++) {
+        cells[i] = blank;
+        if (i < count) cells[i].codepoint = utf8_next(&text);
+    }
+
+    for (int i = 0; i < count; ) {
+        int run = (int)get_varint(&runs);
+        uint16_t fg = (uint16_t)((runs[0] << 8) | runs[1]);
+        uint16_t bg = (uint16_t)((runs[2] << 8) | runs[3]);
+        uint8_t attr = runs[4];
+        runs += 5;
+
+        for (int j = i; j < i + run && j < cols; j++) {
+            cells[j].fg = fg;
+            cells[j].bg = bg;
+            cells[j].attr = attr;
+        }
+        i += run;
+    }
+    return true;
+}
+
+/**
+ * Get character width in cells
+ */
+int term_char_width(uint32_t codepoint) {
+    if (codepoint < 0x300) return 1;  /* ASCII, Latin-1 and Latin Extended */
+    if (in_ranges(codepoint, zero_width, (int)(sizeof(zero_width) / sizeof(zero_width[0])))) {
+        return 0;
+    }
+    if (in_ranges(codepoint, double_width, (int)(sizeof(double_width) / sizeof(double_width[0])))) {
+        return 2;
+    }
+    return 1;
+}
+
+/**
+ * Encode codepoint as UTF-8
+ */
+size_t term_utf8_encode(uint32_t codepoint, char *out) {
+    if (codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
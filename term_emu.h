@@ -0,0 +1,200 @@
+/**
+ * Terminal Emulator Core for WeActTerm
+ *
+ * Escape sequence parser following the DEC/ECMA-48 state machine
+ * (vt100.net "DEC ANSI parser"), driven by a byte transition table, and
+ * the screen model it updates: a grid of cells with attributes, cursor,
+ * scroll region, alternate screen and scrollback history.
+ *
+ * Parser state lives in the terminal, so sequences split across reads
+ * are handled. Colours are stored as BRG565 ready for the panel.
+ * Scrollback is a ring of compact records (UTF-8 text plus attribute
+ * runs) with a configurable depth.
+ */
+
+#ifndef TERM_EMU_H
+#define TERM_EMU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TERM_MAX_PARAMS       16
+#define TERM_SCROLLBACK_LINES      1000    /* Default depth */
+#define TERM_SCROLLBACK_MAX        100000
+#define TERM_SCROLLBACK_LINE_BYTES 48      /* Average line budget: bounds memory */
+
+/* Cell attributes */
+#define TERM_ATTR_BOLD        0x01
+#define TERM_ATTR_DIM         0x02
+#define TERM_ATTR_UNDERLINE   0x04
+#define TERM_ATTR_REVERSE     0x08
+#define TERM_ATTR_INVISIBLE   0x10
+#define TERM_ATTR_WIDE        0x20   /* Left half of a double-width character */
+
+/* Codepoint of the right half of a double-width character */
+#define TERM_WIDE_CONTINUATION 0
+#define TERM_REPLACEMENT_CHAR  0xFFFD
+
+/* Screen cell */
+typedef struct {
+    uint32_t codepoint;          /* ' ' when blank */
+    uint16_t fg;                 /* BRG565 */
+    uint16_t bg;                 /* BRG565 */
+    uint8_t attr;                /* TERM_ATTR_* */
+} term_cell_t;
+
+/* Graphic rendition for new characters */
+typedef struct {
+    int32_t fg;                  /* Palette index 0-255, 0x1RRGGBB, or -1 default */
+    int32_t bg;
+    uint8_t attr;
+} term_pen_t;
+
+/* State saved by DECSC / CSI s */
+typedef struct {
+    int x;
+    int y;
+    term_pen_t pen;
+    bool origin_mode;
+    bool wrap_pending;
+    uint8_t charset[2];
+    int active_charset;
+} term_saved_t;
+
+/* Terminal */
+typedef struct {
+    int cols;
+    int rows;
+    term_cell_t *screen;         /* Active screen, rows * cols */
+    term_cell_t *primary;
+    term_cell_t *alternate;
+    bool alt_screen;
+    uint8_t *dirty;              /* Per-row damage since term_emu_clear_damage() */
+
+    /* Cursor and modes */
+    int cursor_x;
+    int cursor_y;
+    bool wrap_pending;           /* Next printable wraps first (last column) */
+    bool cursor_visible;
+    int scroll_top;              /* Scroll region, inclusive */
+    int scroll_bottom;
+    bool origin_mode;
+    bool autowrap;
+    bool insert_mode;
+    bool app_cursor_keys;        /* DECCKM: arrows as ESC O x */
+    term_pen_t pen;
+    term_cell_t blank;           /* Erase cell for the current pen */
+    uint8_t charset[2];          /* G0/G1: 'B' ASCII, '0' line drawing */
+    int active_charset;
+    term_saved_t saved[2];       /* Primary, alternate */
+    uint32_t last_char;          /* For REP */
+
+    /* Parser */
+    uint8_t state;
+    int params[TERM_MAX_PARAMS];
+    int param_count;
+    char intermediate;
+    char private_marker;
+    uint32_t utf8_codepoint;     /* UTF-8 sequence being decoded */
+    uint32_t utf8_min;           /* Smallest valid value (rejects overlong forms) */
+    int utf8_remaining;          /* Continuation bytes still expected */
+
+    /* Lines scrolled off the top of the primary screen: encoded records
+     * in a byte ring, indexed by a ring of start positions */
+    uint8_t *history;
+    size_t history_size;
+    uint64_t history_end;        /* Bytes ever appended: next record start */
+    uint64_t *history_lines;     /* Record start per line, oldest at history_first */
+    int history_capacity;        /* Depth in lines */
+    int history_first;
+    int history_count;
+    uint8_t *history_scratch;    /* One record */
+
+    /* Answerback (device status reports) for the application */
+    char reply[64];
+    size_t reply_len;
+} term_emu_t;
+
+/**
+ * Create terminal (blank screen, cursor home)
+ * @return Terminal or NULL on error
+ */
+term_emu_t* term_emu_create(int cols, int rows);
+
+/**
+ * Destroy terminal
+ */
+void term_emu_destroy(term_emu_t *term);
+
+/**
+ * Feed application output through the parser
+ * Replies to status requests accumulate in term->reply; the caller sends
+ * them to the application and resets reply_len.
+ */
+void term_emu_feed(term_emu_t *term, const char *data, size_t len);
+
+/**
+ * Get screen row (cols cells)
+ */
+const term_cell_t* term_emu_row(const term_emu_t *term, int row);
+
+/**
+ * Check whether a screen row changed since the last term_emu_clear_damage()
+ * Cursor movement alone does not damage a row.
+ */
+bool term_emu_row_dirty(const term_emu_t *term, int row);
+
+/**
+ * Forget damage once the screen has been rendered
+ */
+void term_emu_clear_damage(term_emu_t *term);
+
+/**
+ * Store a cell directly, for screens mirrored from another source
+ * Damages the row when the cell changes; no wide-character bookkeeping.
+ * @return true if the cell changed
+ */
+bool term_emu_set_cell(term_emu_t *term, int x, int y, const term_cell_t *cell);
+
+/**
+ * Place cursor directly (clamped to the screen)
+ */
+void term_emu_set_cursor(term_emu_t *term, int x, int y, bool visible);
+
+/**
+ * Get xterm palette colour (0-15 ANSI, 16-255 cube and greys) as BRG565
+ */
+uint16_t term_emu_color(int index);
+
+/**
+ * Set scrollback depth, discarding the current scrollback
+ * Memory is bounded by lines * TERM_SCROLLBACK_LINE_BYTES; when lines are
+ * longer than that on average, fewer of them are kept.
+ * @param lines 0 to TERM_SCROLLBACK_MAX
+ * @return true on success
+ */
+bool term_emu_set_scrollback(term_emu_t *term, int lines);
+
+/**
+ * Get scrollback line as cells
+ * @param index 0 = most recent line scrolled off
+ * @param cells Receives cols cells, blank past the end of the line
+ * @return false if out of range
+ */
+bool term_emu_history_line(const term_emu_t *term, int index, term_cell_t *cells, int cols);
+
+/**
+ * Get display width of a character in cells (wcwidth without the locale)
+ * @return 0 for combining marks, 2 for East Asian wide and emoji, else 1
+ */
+int term_char_width(uint32_t codepoint);
+
+/**
+ * Encode codepoint as UTF-8
+ * @param out At least 4 bytes
+ * @return Bytes written
+ */
+size_t term_utf8_encode(uint32_t codepoint, char *out);
+
+#endif /* TERM_EMU_H */
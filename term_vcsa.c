@@ -0,0 +1,160 @@
+/**
+ * Linux Virtual Console Reader Implementation
+ * Snapshots of /dev/vcsaN mapped to terminal cells
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "term_vcsa.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define VCSA_HEADER 4
+
+/* VGA colour order (blue, green, red bits) to ANSI order */
+static const uint8_t vga_to_ansi[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+/* CP437 0x80-0xFF */
+static const uint16_t cp437_high[128] = {
+    0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+    0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+    0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+    0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x20A7, 0x0192,
+    0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA,
+    0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+    0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556,
+    0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+    0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F,
+    0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+    0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B,
+    0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+    0x03B1, 0x00DF, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4,
+    0x03A6, 0x0398, 0x03A9, 0x03B4, 0x221E, 0x03C6, 0x03B5, 0x2229,
+    0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248,
+    0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
+};
+
+/**
+ * Open virtual console
+ */
+term_vcsa_t* term_vcsa_open(const char *path) {
+    term_vcsa_t *vcsa = calloc(1, sizeof(term_vcsa_t));
+    if (!vcsa) return NULL;
+
+    vcsa->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (vcsa->fd < 0) {
+        free(vcsa);
+        return NULL;
+    }
+
+    struct stat st;
+    vcsa->pollable = fstat(vcsa->fd, &st) == 0 && S_ISCHR(st.st_mode);
+
+    if (!term_vcsa_read(vcsa)) {
+        int err = errno;
+        term_vcsa_close(vcsa);
+        errno = err;
+        return NULL;
+    }
+    return vcsa;
+}
+
+/**
+ * Close reader
+ */
+void term_vcsa_close(term_vcsa_t *vcsa) {
+    if (vcsa) {
+        if (vcsa->fd >= 0) close(vcsa->fd);
+        free(vcsa->cells);
+        free(vcsa->previous);
+        free(vcsa);
+    }
+}
+
+/**
+ * Read the current screen
+ */
+bool term_vcsa_read(term_vcsa_t *vcsa) {
+    if (!vcsa) return false;
+
+    uint8_t header[VCSA_HEADER];
+    ssize_t got = pread(vcsa->fd, header, sizeof(header), 0);
+    if (got != (ssize_t)sizeof(header)) {
+        if (got >= 0) errno = EINVAL;
+        return false;
+    }
+
+    int lines = header[0];
+    int cols = header[1];
+    if (lines == 0 || cols == 0) {
+        errno = EINVAL;
+        return false;
+    }
+
+    size_t bytes = (size_t)lines * cols * 2;
+    if (bytes > vcsa->capacity) {
+        uint8_t *cells = realloc(vcsa->cells, bytes);
+        if (cells) vcsa->cells = cells;
+        uint8_t *previous = realloc(vcsa->previous, bytes);
+        if (previous) vcsa->previous = previous;
+        if (!cells || !previous) return false;
+        vcsa->capacity = bytes;
+    }
+
+    /* Keep the last snapshot for change detection */
+    uint8_t *swap = vcsa->previous;
+    vcsa->previous = vcsa->cells;
+    vcsa->cells = swap;
+
+    ssize_t n = pread(vcsa->fd, vcsa->cells, bytes, VCSA_HEADER);
+    if (n < 0) return false;
+    if ((size_t)n < bytes) {
+        /* Short file: the rest of the screen is blank */
+        memset(vcsa->cells + n, 0, bytes - (size_t)n);
+    }
+
+    vcsa->resized = lines != vcsa->lines || cols != vcsa->cols;
+    vcsa->lines = lines;
+    vcsa->cols = cols;
+    vcsa->cursor_x = header[2];
+    vcsa->cursor_y = header[3];
+    return true;
+}
+
+/**
+ * Check whether a cell changed
+ */
+bool term_vcsa_changed(const term_vcsa_t *vcsa, int x, int y) {
+    if (vcsa->resized) return true;
+    size_t offset = ((size_t)y * vcsa->cols + x) * 2;
+    return vcsa->cells[offset] != vcsa->previous[offset] ||
+           vcsa->cells[offset + 1] != vcsa->previous[offset + 1];
+}
+
+/**
+ * Convert a cell
+ */
+void term_vcsa_cell(const term_vcsa_t *vcsa, int x, int y, term_cell_t *cell) {
+    size_t offset = ((size_t)y * vcsa->cols + x) * 2;
+    uint8_t ch = vcsa->cells[offset];
+    uint8_t attr = vcsa->cells[offset + 1];
+
+    if (ch >= 0x80) {
+        cell->codepoint = cp437_high[ch - 0x80];
+    } else if (ch < 0x20 || ch == 0x7F) {
+        cell->codepoint = ' ';
+    } else {
+        cell->codepoint = ch;
+    }
+
+    /* Low nibble: foreground with intensity bit; bits 4-6: background */
+    int fg = vga_to_ansi[attr & 0x07] | (attr & 0x08);
+    int bg = vga_to_ansi[(attr >> 4) & 0x07];
+    cell->fg = term_emu_color(fg);
+    cell->bg = term_emu_color(bg);
+    cell->attr = 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * Linux Virtual Console Reader for WeActTerm
+ *
+ * Reads /dev/vcsaN: a 4-byte header (lines, columns, cursor x, cursor y)
+ * followed by a character byte and a VGA attribute byte per cell. Each
+ * read keeps the previous snapshot so callers repaint only cells that
+ * changed. A regular file with the same layout can stand in for the
+ * device.
+ *
+ * Character bytes are console font positions; the default CP437 layout
+ * is assumed when mapping them to Unicode.
+ */
+
+#ifndef TERM_VCSA_H
+#define TERM_VCSA_H
+
+#include "term_emu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Virtual console snapshot */
+typedef struct {
+    int fd;
+    bool pollable;               /* Character device: POLLPRI on change */
+    int lines;
+    int cols;
+    int cursor_x;
+    int cursor_y;
+    bool resized;                /* Size changed in the last read: all cells changed */
+    uint8_t *cells;              /* Last read, 2 bytes per cell */
+    uint8_t *previous;           /* Read before that */
+    size_t capacity;             /* Bytes allocated per snapshot */
+} term_vcsa_t;
+
+/**
+ * Open virtual console (or a file in vcsa layout) and read it once
+ * @return Reader or NULL on error (errno set)
+ */
+term_vcsa_t* term_vcsa_open(const char *path);
+
+/**
+ * Close reader
+ */
+void term_vcsa_close(term_vcsa_t *vcsa);
+
+/**
+ * Read the current screen; the last one becomes the previous snapshot
+ * Reading also acknowledges a pending change notification.
+ * @return false on read error or malformed header
+ */
+bool term_vcsa_read(term_vcsa_t *vcsa);
+
+/**
+ * Check whether a cell differs from the previous snapshot
+ */
+bool term_vcsa_changed(const term_vcsa_t *vcsa, int x, int y);
+
+/**
+ * Convert a cell to a terminal cell (Unicode, BRG565 colours)
+ */
+void term_vcsa_cell(const term_vcsa_t *vcsa, int x, int y, term_cell_t *cell);
+
+#endif /* TERM_VCSA_H */
@@ -9,9 +9,17 @@
 #include "text_freetype.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SIZES_H
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
 
 /* Default font paths to try */
 static const char *default_font_paths[] = {
@@ -23,16 +31,217 @@ static const char *default_font_paths[] = {
     NULL
 };
 
+/* Fallback fonts tried, in order, by ft_text_add_default_fallbacks() */
+static const char *default_fallback_paths[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/TTF/DejaVuSans.ttf",
+    "/usr/share/fonts/truetype/noto/NotoSansSymbols-Regular.ttf",
+    "/usr/share/fonts/truetype/noto/NotoSansSymbols2-Regular.ttf",
+    "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
+    "/usr/share/fonts/noto-cjk/NotoSansCJK-Regular.ttc",  /* Arch Linux */
+    "/usr/share/fonts/truetype/wqy/wqy-microhei.ttc",
+    "/usr/share/fonts/truetype/droid/DroidSansFallbackFull.ttf",
+    "/usr/share/fonts/truetype/noto/NotoEmoji-Regular.ttf",
+    "/usr/share/fonts/truetype/ancient-scripts/Symbola_hint.ttf",
+    NULL
+};
+
+/* Glyph atlas file layout (little-endian):
+ *   header:  "WATL", u16 version, u16 size_count, char font_path[256]
+ *   sizes:   u16 pixel_size, i16 ascender, i16 descender, u16 reserved,
+ *            u32 glyph_count, u32 glyph_offset
+ *   glyphs:  u32 codepoint, u16 width, u16 rows, i16 left, i16 top,
+ *            i16 advance, u16 reserved, u32 bitmap_offset (sorted by codepoint)
+ *   bitmaps: width * rows coverage bytes per glyph
+ */
+#define ATLAS_MAGIC         "WATL"
+#define ATLAS_VERSION       1
+#define ATLAS_PATH_SIZE     256
+#define ATLAS_HEADER_SIZE   (8 + ATLAS_PATH_SIZE)
+#define ATLAS_SIZE_RECORD   16
+#define ATLAS_GLYPH_RECORD  20
+
+/* Glyph cache sizing */
+#define GLYPH_CACHE_ENTRIES 512
+#define GLYPH_CACHE_BUCKETS 1024          /* Power of two */
+#define GLYPH_ARENA_SIZE    (128 * 1024)  /* Coverage bitmap storage */
+#define GLYPH_NONE          (-1)
+
+/* Horizontal run of set pixels in a monochrome glyph */
+typedef struct {
+    uint16_t row;
+    uint16_t x;
+    uint16_t length;
+} ft_run_t;
+
+/* Cached glyph: coverage bitmap (or runs) plus placement metrics */
+typedef struct {
+    /* Key */
+    const void *font;         /* Face or atlas the context renders from */
+    uint32_t codepoint;
+    uint16_t size;
+    bool mono;                /* Hinted 1-bit rendering stored as runs */
+    
+    /* Metrics (pixels) */
+    uint16_t width;
+    uint16_t rows;
+    int16_t left;
+    int16_t top;
+    int16_t advance;
+    uint8_t *bitmap;          /* width * rows coverage bytes, or runs */
+    uint16_t run_count;       /* Mono glyphs: ft_run_t entries in bitmap */
+    bool in_arena;            /* false: points into a mapped atlas */
+    
+    /* Links (entry indices) */
+    int hash_next;
+    int lru_prev;
+    int lru_next;
+} ft_glyph_t;
+
+/* LRU glyph cache; bitmaps live in a bump arena compacted on overflow */
+typedef struct {
+    ft_glyph_t entries[GLYPH_CACHE_ENTRIES];
+    int buckets[GLYPH_CACHE_BUCKETS];
+    int lru_head;             /* Most recently used */
+    int lru_tail;             /* Least recently used */
+    int free_head;            /* Unused entries, chained via hash_next */
+    int count;
+    uint8_t *arena;
+    size_t arena_used;
+} ft_glyph_cache_t;
+
+/* Advance and kerning cache sizing */
+#define ADVANCE_DIRECT      0x500   /* Latin and Cyrillic: direct table */
+#define ADVANCE_UNKNOWN     INT16_MIN
+#define ADVANCE_HASH_EMPTY  UINT32_MAX
+#define KERN_CACHE_SIZE     1024    /* Power of two, direct-mapped */
+
+/* Advance widths and kerning pairs for one font at one pixel size */
+typedef struct ft_metrics {
+    const void *font;
+    int size;
+    bool mono;                /* Hinted for 1-bit rendering */
+    int16_t direct[ADVANCE_DIRECT];
+    
+    /* Other codepoints: open addressing, grown at 3/4 load */
+    uint32_t *hash_keys;
+    int16_t *hash_advances;
+    size_t hash_capacity;
+    size_t hash_count;
+    
+    /* Kerning by codepoint pair */
+    uint64_t kern_keys[KERN_CACHE_SIZE];   /* 0 = empty */
+    int8_t kern_values[KERN_CACHE_SIZE];
+    
+    struct ft_metrics *next;
+} ft_metrics_t;
+
+/* Fallback font chain */
+#define FT_MAX_FALLBACKS    8
+#define CHARMAP_EMPTY       UINT32_MAX
+#define CHARMAP_NONE        (-1)    /* No face has the codepoint */
+
+typedef struct {
+    char path[ATLAS_PATH_SIZE];
+    struct ft_font *font;     /* Opened on first lookup that reaches it */
+    bool failed;
+} ft_fallback_t;
+
+/* Codepoint -> face (0 = primary, n = fallback n-1) and glyph index */
+typedef struct {
+    uint32_t codepoint;
+    int16_t face;
+    uint32_t glyph_index;
+} ft_charmap_entry_t;
+
+/* Scaled face size: switching between sizes is a pointer swap */
+typedef struct ft_font_size {
+    int pixel_size;
+    FT_Size size;
+    struct ft_font_size *next;
+} ft_font_size_t;
+
+/* Font file shared by every context that uses it: mapped once and opened
+ * as a memory face. The face's active size is shared too, so users go
+ * through font_face() to activate their size before touching it. */
+typedef struct ft_font {
+    char path[ATLAS_PATH_SIZE];
+    uint8_t *data;
+    size_t data_size;
+    FT_Face face;
+    ft_font_size_t *sizes;    /* One FT_Size per pixel size used */
+    ft_font_size_t *active;
+    int refs;
+    struct ft_font *next;
+} ft_font_t;
+
+/* Mapped glyph atlas */
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    int size_count;
+} ft_atlas_t;
+
 /* FreeType context structure */
 struct ft_text_context {
     weact_display_t *display;
-    FT_Library library;
-    FT_Face face;
+    ft_font_t *font;          /* NULL until needed when an atlas is used */
+    char font_path[ATLAS_PATH_SIZE];
+    bool face_failed;
     int font_size;
     uint16_t color;
     ft_text_align_t align;
+    ft_text_render_t render_mode;
+    ft_glyph_cache_t *cache;
+    ft_metrics_t *metrics;      /* One table per font and size */
+    ft_metrics_t *metrics_cur;
+    bool kerning;
+    ft_atlas_t *atlas;
+    const uint8_t *atlas_size;  /* Size record for font_size, or NULL */
+    
+    ft_fallback_t fallbacks[FT_MAX_FALLBACKS];
+    int fallback_count;
+    ft_charmap_entry_t *charmap;  /* Open addressing, grown at 3/4 load */
+    size_t charmap_capacity;
+    size_t charmap_count;
+    
+    /* Coverage blend LUTs for the current color: [5-bit coverage][channel] */
+    bool blend_valid;
+    uint16_t blend_color;
+    uint8_t blend_b[32][32];
+    uint8_t blend_r[32][32];
+    uint8_t blend_g[32][64];
 };
 
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void set_error(char *error, size_t error_size, const char *fmt, ...) {
+    if (error && error_size > 0) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(error, error_size, fmt, args);
+        va_end(args);
+    }
+}
+
 /**
  * UTF-8 helper: decode next character
  * Returns character code and advances pointer
@@ -40,6 +249,7 @@ struct ft_text_context {
 static uint32_t utf8_decode(const unsigned char **str) {
     const unsigned char *s = *str;
     uint32_t c = *s++;
+    int extra;
     
     if (c < 0x80) {
         /* ASCII */
@@ -47,28 +257,1019 @@ static uint32_t utf8_decode(const unsigned char **str) {
         return c;
     } else if ((c & 0xE0) == 0xC0) {
         /* 2-byte sequence */
-        uint32_t c2 = *s++;
-        *str = s;
-        return ((c & 0x1F) << 6) | (c2 & 0x3F);
+        c &= 0x1F;
+        extra = 1;
     } else if ((c & 0xF0) == 0xE0) {
         /* 3-byte sequence */
-        uint32_t c2 = *s++;
-        uint32_t c3 = *s++;
-        *str = s;
-        return ((c & 0x0F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
+        c &= 0x0F;
+        extra = 2;
     } else if ((c & 0xF8) == 0xF0) {
         /* 4-byte sequence */
-        uint32_t c2 = *s++;
-        uint32_t c3 = *s++;
-        uint32_t c4 = *s++;
+        c &= 0x07;
+        extra = 3;
+    } else {
+        /* Invalid lead byte */
         *str = s;
-        return ((c & 0x07) << 18) | ((c2 & 0x3F) << 12) | 
-               ((c3 & 0x3F) << 6) | (c4 & 0x3F);
+        return 0xFFFD;
+    }
+    
+    /* Never step over a terminator or into the next character */
+    for (int i = 0; i < extra; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *str = s;
+            return 0xFFFD;  /* Replacement character */
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+    
+    *str = s + extra;
+    return c;
+}
+
+/* ===== Glyph cache ===== */
+
+static ft_glyph_cache_t* glyph_cache_create(void) {
+    ft_glyph_cache_t *cache = calloc(1, sizeof(ft_glyph_cache_t));
+    if (!cache) return NULL;
+    
+    cache->arena = malloc(GLYPH_ARENA_SIZE);
+    if (!cache->arena) {
+        free(cache);
+        return NULL;
+    }
+    
+    for (int i = 0; i < GLYPH_CACHE_BUCKETS; i++) {
+        cache->buckets[i] = GLYPH_NONE;
+    }
+    for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        cache->entries[i].hash_next = (i + 1 < GLYPH_CACHE_ENTRIES) ? i + 1 : GLYPH_NONE;
+    }
+    cache->free_head = 0;
+    cache->lru_head = GLYPH_NONE;
+    cache->lru_tail = GLYPH_NONE;
+    return cache;
+}
+
+static void glyph_cache_destroy(ft_glyph_cache_t *cache) {
+    if (cache) {
+        free(cache->arena);
+        free(cache);
+    }
+}
+
+static unsigned int glyph_hash(const void *font, int size, bool mono, uint32_t codepoint) {
+    uintptr_t h = (uintptr_t)font >> 4;
+    h ^= (uintptr_t)(size * 2 + mono) * 0x9E3779B1u;
+    h ^= (uintptr_t)codepoint * 0x85EBCA77u;
+    h ^= h >> 15;
+    return (unsigned int)h & (GLYPH_CACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(ft_glyph_cache_t *cache, int i) {
+    ft_glyph_t *g = &cache->entries[i];
+    if (g->lru_prev != GLYPH_NONE) cache->entries[g->lru_prev].lru_next = g->lru_next;
+    else cache->lru_head = g->lru_next;
+    if (g->lru_next != GLYPH_NONE) cache->entries[g->lru_next].lru_prev = g->lru_prev;
+    else cache->lru_tail = g->lru_prev;
+}
+
+static void lru_push_front(ft_glyph_cache_t *cache, int i) {
+    ft_glyph_t *g = &cache->entries[i];
+    g->lru_prev = GLYPH_NONE;
+    g->lru_next = cache->lru_head;
+    if (cache->lru_head != GLYPH_NONE) cache->entries[cache->lru_head].lru_prev = i;
+    cache->lru_head = i;
+    if (cache->lru_tail == GLYPH_NONE) cache->lru_tail = i;
+}
+
+static void glyph_cache_evict(ft_glyph_cache_t *cache, int i) {
+    ft_glyph_t *g = &cache->entries[i];
+    int *link = &cache->buckets[glyph_hash(g->font, g->size, g->mono, g->codepoint)];
+    
+    while (*link != i) link = &cache->entries[*link].hash_next;
+    *link = g->hash_next;
+    
+    lru_unlink(cache, i);
+    g->hash_next = cache->free_head;
+    cache->free_head = i;
+    cache->count--;
+}
+
+static ft_glyph_t* glyph_cache_find(ft_glyph_cache_t *cache, const void *font, int size,
+                                    bool mono, uint32_t codepoint) {
+    int i = cache->buckets[glyph_hash(font, size, mono, codepoint)];
+    
+    while (i != GLYPH_NONE) {
+        ft_glyph_t *g = &cache->entries[i];
+        if (g->codepoint == codepoint && g->size == size && g->mono == mono && g->font == font) {
+            if (cache->lru_head != i) {
+                lru_unlink(cache, i);
+                lru_push_front(cache, i);
+            }
+            return g;
+        }
+        i = g->hash_next;
+    }
+    return NULL;
+}
+
+/* Arena bytes used by glyph data, kept even so runs stay aligned */
+static size_t glyph_data_size(const ft_glyph_t *g) {
+    size_t bytes = g->mono ? g->run_count * sizeof(ft_run_t) : (size_t)g->width * g->rows;
+    return (bytes + 1) & ~(size_t)1;
+}
+
+/* Make room for bytes in the arena: drop the LRU half, then compact */
+static bool glyph_arena_reserve(ft_glyph_cache_t *cache, size_t bytes) {
+    if (bytes > GLYPH_ARENA_SIZE / 4) return false;
+    if (cache->arena_used + bytes <= GLYPH_ARENA_SIZE) return true;
+    
+    int keep = cache->count / 2;
+    while (cache->count > keep) glyph_cache_evict(cache, cache->lru_tail);
+    
+    uint8_t *fresh = malloc(GLYPH_ARENA_SIZE);
+    if (!fresh) return false;
+    
+    size_t used = 0;
+    for (int i = cache->lru_head; i != GLYPH_NONE; i = cache->entries[i].lru_next) {
+        ft_glyph_t *g = &cache->entries[i];
+        if (!g->in_arena) continue;
+        size_t size = glyph_data_size(g);
+        memcpy(fresh + used, g->bitmap, size);
+        g->bitmap = fresh + used;
+        used += size;
+    }
+    
+    free(cache->arena);
+    cache->arena = fresh;
+    cache->arena_used = used;
+    return cache->arena_used + bytes <= GLYPH_ARENA_SIZE;
+}
+
+/* Take a free entry for key and reserve bytes of arena for its bitmap */
+static ft_glyph_t* glyph_cache_alloc(ft_glyph_cache_t *cache, const void *font, int size,
+                                     bool mono, uint32_t codepoint, size_t bytes) {
+    bytes = (bytes + 1) & ~(size_t)1;
+    if (!glyph_arena_reserve(cache, bytes)) return NULL;
+    
+    if (cache->free_head == GLYPH_NONE) {
+        glyph_cache_evict(cache, cache->lru_tail);
+    }
+    
+    int i = cache->free_head;
+    ft_glyph_t *g = &cache->entries[i];
+    cache->free_head = g->hash_next;
+    
+    memset(g, 0, sizeof(ft_glyph_t));
+    g->font = font;
+    g->codepoint = codepoint;
+    g->size = (uint16_t)size;
+    g->mono = mono;
+    g->bitmap = cache->arena + cache->arena_used;
+    g->in_arena = true;
+    cache->arena_used += bytes;
+    
+    unsigned int h = glyph_hash(font, size, mono, codepoint);
+    g->hash_next = cache->buckets[h];
+    cache->buckets[h] = i;
+    lru_push_front(cache, i);
+    cache->count++;
+    return g;
+}
+
+/* ===== Atlas ===== */
+
+/* Map atlas file; returns NULL if path is not an atlas */
+static ft_atlas_t* atlas_open(const char *path, char *font_path, size_t font_path_size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < ATLAS_HEADER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+    
+    uint8_t *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    
+    size_t size = (size_t)st.st_size;
+    int size_count = get_le16(data + 6);
+    if (memcmp(data, ATLAS_MAGIC, 4) != 0 || get_le16(data + 4) != ATLAS_VERSION ||
+        ATLAS_HEADER_SIZE + (size_t)size_count * ATLAS_SIZE_RECORD > size) {
+        munmap(data, size);
+        return NULL;
+    }
+    
+    /* Glyph tables must lie inside the file */
+    for (int i = 0; i < size_count; i++) {
+        const uint8_t *rec = data + ATLAS_HEADER_SIZE + i * ATLAS_SIZE_RECORD;
+        uint64_t end = get_le32(rec + 12) + (uint64_t)get_le32(rec + 8) * ATLAS_GLYPH_RECORD;
+        if (end > size) {
+            munmap(data, size);
+            return NULL;
+        }
+    }
+    
+    ft_atlas_t *atlas = calloc(1, sizeof(ft_atlas_t));
+    if (!atlas) {
+        munmap(data, size);
+        return NULL;
+    }
+    atlas->data = data;
+    atlas->size = size;
+    atlas->size_count = size_count;
+    
+    snprintf(font_path, font_path_size, "%.*s", ATLAS_PATH_SIZE - 1, (const char *)data + 8);
+    return atlas;
+}
+
+static void atlas_close(ft_atlas_t *atlas) {
+    if (atlas) {
+        munmap(atlas->data, atlas->size);
+        free(atlas);
+    }
+}
+
+static const uint8_t* atlas_find_size(const ft_atlas_t *atlas, int pixel_size) {
+    if (!atlas) return NULL;
+    for (int i = 0; i < atlas->size_count; i++) {
+        const uint8_t *rec = atlas->data + ATLAS_HEADER_SIZE + i * ATLAS_SIZE_RECORD;
+        if (get_le16(rec) == pixel_size) return rec;
+    }
+    return NULL;
+}
+
+/* Binary search glyph record in size table */
+static const uint8_t* atlas_find_glyph(const ft_atlas_t *atlas, const uint8_t *size_rec,
+                                       uint32_t codepoint) {
+    const uint8_t *table = atlas->data + get_le32(size_rec + 12);
+    int lo = 0, hi = (int)get_le32(size_rec + 8) - 1;
+    
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const uint8_t *rec = table + (size_t)mid * ATLAS_GLYPH_RECORD;
+        uint32_t cp = get_le32(rec);
+        if (cp == codepoint) {
+            size_t bytes = (size_t)get_le16(rec + 4) * get_le16(rec + 6);
+            return get_le32(rec + 16) + bytes <= atlas->size ? rec : NULL;
+        }
+        if (cp < codepoint) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+/* ===== Glyph loading ===== */
+
+/* Font registry: one FreeType library for the process, one face per file.
+ * Not thread-safe, like the rest of the renderer. */
+static FT_Library font_library;
+static ft_font_t *font_registry;
+
+/* Map font file and open it, or take another reference to it */
+static ft_font_t* font_acquire(const char *path) {
+    for (ft_font_t *font = font_registry; font; font = font->next) {
+        if (strcmp(font->path, path) == 0) {
+            font->refs++;
+            return font;
+        }
+    }
+    
+    if (strlen(path) >= ATLAS_PATH_SIZE) return NULL;
+    if (!font_library && FT_Init_FreeType(&font_library)) {
+        fprintf(stderr, "FreeType: Failed to initialize library\n");
+        font_library = NULL;
+        return NULL;
+    }
+    
+    ft_font_t *font = calloc(1, sizeof(ft_font_t));
+    if (!font) return NULL;
+    
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        font->data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (font->data == MAP_FAILED) font->data = NULL;
+        else font->data_size = (size_t)st.st_size;
+    }
+    if (fd >= 0) close(fd);
+    
+    if (!font->data || FT_New_Memory_Face(font_library, font->data, (FT_Long)font->data_size,
+                                          0, &font->face)) {
+        if (font->data) munmap(font->data, font->data_size);
+        free(font);
+        if (!font_registry) {
+            FT_Done_FreeType(font_library);
+            font_library = NULL;
+        }
+        return NULL;
+    }
+    
+    memcpy(font->path, path, strlen(path) + 1);
+    font->refs = 1;
+    font->next = font_registry;
+    font_registry = font;
+    return font;
+}
+
+/* Drop reference; the last one closes the face and unmaps the file */
+static void font_release(ft_font_t *font) {
+    if (!font || --font->refs > 0) return;
+    
+    for (ft_font_t **p = &font_registry; *p; p = &(*p)->next) {
+        if (*p == font) {
+            *p = font->next;
+            break;
+        }
+    }
+    while (font->sizes) {
+        ft_font_size_t *next = font->sizes->next;
+        free(font->sizes);
+        font->sizes = next;
+    }
+    FT_Done_Face(font->face);  /* Also frees the FT_Size objects */
+    munmap(font->data, font->data_size);
+    free(font);
+    
+    if (!font_registry) {
+        FT_Done_FreeType(font_library);
+        font_library = NULL;
+    }
+}
+
+/* Shared face with pixel_size active; each size is scaled once and kept */
+static FT_Face font_face(ft_font_t *font, int pixel_size) {
+    ft_font_size_t *fs = font->active;
+    if (fs && fs->pixel_size == pixel_size) return font->face;
+    
+    for (fs = font->sizes; fs; fs = fs->next) {
+        if (fs->pixel_size == pixel_size) break;
+    }
+    
+    if (!fs) {
+        fs = calloc(1, sizeof(ft_font_size_t));
+        if (!fs) return NULL;
+        if (FT_New_Size(font->face, &fs->size)) {
+            free(fs);
+            return NULL;
+        }
+        if (FT_Activate_Size(fs->size) || FT_Set_Pixel_Sizes(font->face, 0, pixel_size)) {
+            FT_Done_Size(fs->size);  /* FreeType activates another size */
+            free(fs);
+            font->active = NULL;
+            return NULL;
+        }
+        fs->pixel_size = pixel_size;
+        fs->next = font->sizes;
+        font->sizes = fs;
+    } else if (FT_Activate_Size(fs->size)) {
+        return NULL;
+    }
+    
+    font->active = fs;
+    return font->face;
+}
+
+/* Primary face at the current size, opened on first use (atlas contexts
+ * start without one) */
+static FT_Face load_face(ft_text_context_t *ctx) {
+    if (!ctx->font) {
+        if (ctx->face_failed) return NULL;
+        ctx->font = font_acquire(ctx->font_path);
+        if (!ctx->font) {
+            fprintf(stderr, "FreeType: Failed to load font: %s\n", ctx->font_path);
+            ctx->face_failed = true;
+            return NULL;
+        }
+    }
+    
+    FT_Face face = font_face(ctx->font, ctx->font_size);
+    if (!face) {
+        fprintf(stderr, "FreeType: Failed to set font size: %d\n", ctx->font_size);
+    }
+    return face;
+}
+
+/* Fallback face at the current size, opened on first use */
+static FT_Face fallback_face(ft_text_context_t *ctx, int i) {
+    ft_fallback_t *fb = &ctx->fallbacks[i];
+    if (fb->failed) return NULL;
+    
+    if (!fb->font) {
+        fb->font = font_acquire(fb->path);
+        if (!fb->font) {
+            fb->failed = true;
+            return NULL;
+        }
+    }
+    return font_face(fb->font, ctx->font_size);
+}
+
+static size_t charmap_find(const ft_text_context_t *ctx, uint32_t codepoint) {
+    size_t mask = ctx->charmap_capacity - 1;
+    size_t i = (codepoint * 2654435761u) & mask;
+    
+    while (ctx->charmap[i].codepoint != CHARMAP_EMPTY && ctx->charmap[i].codepoint != codepoint) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void charmap_insert(ft_text_context_t *ctx, uint32_t codepoint, int face,
+                           uint32_t glyph_index) {
+    if ((ctx->charmap_count + 1) * 4 > ctx->charmap_capacity * 3) {
+        size_t capacity = ctx->charmap_capacity ? ctx->charmap_capacity * 2 : 256;
+        ft_charmap_entry_t *map = malloc(capacity * sizeof(ft_charmap_entry_t));
+        if (!map) return;  /* Stays uncached */
+        
+        for (size_t i = 0; i < capacity; i++) {
+            map[i].codepoint = CHARMAP_EMPTY;
+        }
+        
+        ft_charmap_entry_t *old = ctx->charmap;
+        size_t old_capacity = ctx->charmap_capacity;
+        ctx->charmap = map;
+        ctx->charmap_capacity = capacity;
+        
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].codepoint != CHARMAP_EMPTY) {
+                ctx->charmap[charmap_find(ctx, old[i].codepoint)] = old[i];
+            }
+        }
+        free(old);
+    }
+    
+    size_t i = charmap_find(ctx, codepoint);
+    if (ctx->charmap[i].codepoint == CHARMAP_EMPTY) ctx->charmap_count++;
+    ctx->charmap[i].codepoint = codepoint;
+    ctx->charmap[i].face = (int16_t)face;
+    ctx->charmap[i].glyph_index = glyph_index;
+}
+
+/* Find the first face in the chain that has codepoint; each codepoint is
+ * searched across faces once. Missing everywhere: primary .notdef. */
+static bool resolve_glyph(ft_text_context_t *ctx, uint32_t codepoint,
+                          FT_Face *face, FT_UInt *glyph_index) {
+    int slot = CHARMAP_NONE;
+    FT_UInt index = 0;
+    bool cached = false;
+    
+    if (ctx->charmap_capacity > 0) {
+        const ft_charmap_entry_t *e = &ctx->charmap[charmap_find(ctx, codepoint)];
+        if (e->codepoint == codepoint) {
+            slot = e->face;
+            index = e->glyph_index;
+            cached = true;
+        }
+    }
+    
+    if (!cached) {
+        FT_Face primary = load_face(ctx);
+        if (primary && (index = FT_Get_Char_Index(primary, codepoint)) != 0) {
+            slot = 0;
+        } else {
+            for (int i = 0; i < ctx->fallback_count; i++) {
+                FT_Face f = fallback_face(ctx, i);
+                if (f && (index = FT_Get_Char_Index(f, codepoint)) != 0) {
+                    slot = i + 1;
+                    break;
+                }
+            }
+            if (slot == CHARMAP_NONE && primary) {
+                slot = 0;
+                index = 0;
+            }
+        }
+        charmap_insert(ctx, codepoint, slot, index);
+    }
+    
+    if (slot == CHARMAP_NONE) return false;
+    *face = slot == 0 ? load_face(ctx) : fallback_face(ctx, slot - 1);
+    *glyph_index = index;
+    return *face != NULL;
+}
+
+/* Drop everything derived from the face chain */
+static void reset_caches(ft_text_context_t *ctx) {
+    for (size_t i = 0; i < ctx->charmap_capacity; i++) {
+        ctx->charmap[i].codepoint = CHARMAP_EMPTY;
+    }
+    ctx->charmap_count = 0;
+    
+    ft_glyph_cache_t *cache = ctx->cache;
+    while (cache->count > 0) glyph_cache_evict(cache, cache->lru_tail);
+    cache->arena_used = 0;
+    
+    for (ft_metrics_t *m = ctx->metrics; m; m = m->next) {
+        for (int i = 0; i < ADVANCE_DIRECT; i++) {
+            m->direct[i] = ADVANCE_UNKNOWN;
+        }
+        for (size_t i = 0; i < m->hash_capacity; i++) {
+            m->hash_keys[i] = ADVANCE_HASH_EMPTY;
+        }
+        m->hash_count = 0;
+        memset(m->kern_keys, 0, sizeof(m->kern_keys));
+    }
+}
+
+/* Cache key for the font this context renders from */
+static const void* font_key(const ft_text_context_t *ctx) {
+    return ctx->atlas ? (const void *)ctx->atlas : (const void *)ctx->font;
+}
+
+/* Glyphs are hinted for 1-bit output in mono mode */
+static bool mono_mode(const ft_text_context_t *ctx) {
+    return ctx->render_mode == FT_TEXT_RENDER_MONO;
+}
+
+static FT_Int32 load_flags(const ft_text_context_t *ctx) {
+    return mono_mode(ctx) ? FT_LOAD_TARGET_MONO : FT_LOAD_DEFAULT;
+}
+
+/* Collect horizontal runs of set pixels (out == NULL: count only). The
+ * source is a 1-bit bitmap, or coverage bytes thresholded at 50%. */
+static int build_runs(const uint8_t *src, int pitch, bool bits, int width, int rows,
+                      ft_run_t *out) {
+    int count = 0;
+    
+    for (int row = 0; row < rows; row++) {
+        const uint8_t *line = src + (ptrdiff_t)row * pitch;
+        int x = 0;
+        
+        while (x < width) {
+            while (x < width && !(bits ? line[x >> 3] & (0x80 >> (x & 7)) : line[x] > 128)) x++;
+            int start = x;
+            while (x < width && (bits ? line[x >> 3] & (0x80 >> (x & 7)) : line[x] > 128)) x++;
+            
+            if (x > start) {
+                if (out) {
+                    out[count].row = (uint16_t)row;
+                    out[count].x = (uint16_t)start;
+                    out[count].length = (uint16_t)(x - start);
+                }
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/* Store glyph bitmap in the cache: coverage bytes, or runs in mono mode */
+static ft_glyph_t* glyph_cache_store(ft_text_context_t *ctx, uint32_t codepoint,
+                                     const uint8_t *src, int pitch, bool bits,
+                                     int width, int rows) {
+    bool mono = mono_mode(ctx);
+    int runs = mono ? build_runs(src, pitch, bits, width, rows, NULL) : 0;
+    size_t bytes = mono ? runs * sizeof(ft_run_t) : (size_t)width * rows;
+    
+    if (runs > UINT16_MAX) return NULL;
+    
+    ft_glyph_t *g = glyph_cache_alloc(ctx->cache, font_key(ctx), ctx->font_size, mono,
+                                      codepoint, bytes);
+    if (!g) return NULL;
+    
+    g->width = (uint16_t)width;
+    g->rows = (uint16_t)rows;
+    if (mono) {
+        g->run_count = (uint16_t)build_runs(src, pitch, bits, width, rows, (ft_run_t *)g->bitmap);
+    } else {
+        /* Store tightly packed (pitch == width) */
+        for (int row = 0; row < rows; row++) {
+            memcpy(g->bitmap + row * width, src + (ptrdiff_t)row * pitch, width);
+        }
+    }
+    return g;
+}
+
+/* Fetch glyph from the atlas, or rasterize it with FreeType, into the cache */
+static ft_glyph_t* glyph_cache_load(ft_text_context_t *ctx, uint32_t codepoint) {
+    ft_glyph_t *g;
+    
+    if (ctx->atlas_size) {
+        const uint8_t *rec = atlas_find_glyph(ctx->atlas, ctx->atlas_size, codepoint);
+        if (rec) {
+            int width = get_le16(rec + 4);
+            const uint8_t *bitmap = ctx->atlas->data + get_le32(rec + 16);
+            
+            if (mono_mode(ctx)) {
+                /* Atlas coverage is thresholded into runs */
+                g = glyph_cache_store(ctx, codepoint, bitmap, width, false, width,
+                                      get_le16(rec + 6));
+            } else {
+                g = glyph_cache_alloc(ctx->cache, font_key(ctx), ctx->font_size, false,
+                                      codepoint, 0);
+                if (g) {
+                    g->width = (uint16_t)width;
+                    g->rows = get_le16(rec + 6);
+                    g->bitmap = (uint8_t *)bitmap;
+                    g->in_arena = false;
+                }
+            }
+            if (!g) return NULL;
+            g->left = (int16_t)get_le16(rec + 8);
+            g->top = (int16_t)get_le16(rec + 10);
+            g->advance = (int16_t)get_le16(rec + 12);
+            return g;
+        }
+    }
+    
+    FT_Face face;
+    FT_UInt glyph_index;
+    if (!resolve_glyph(ctx, codepoint, &face, &glyph_index)) return NULL;
+    
+    FT_Bitmap *bitmap = NULL;
+    int advance = 0;
+    
+    if (FT_Load_Glyph(face, glyph_index, load_flags(ctx)) == 0) {
+        advance = face->glyph->advance.x >> 6;
+        if (FT_Render_Glyph(face->glyph, mono_mode(ctx) ? FT_RENDER_MODE_MONO
+                                                        : FT_RENDER_MODE_NORMAL) == 0) {
+            bitmap = &face->glyph->bitmap;
+        }
+    }
+    
+    if (bitmap) {
+        g = glyph_cache_store(ctx, codepoint, bitmap->buffer, bitmap->pitch,
+                              bitmap->pixel_mode == FT_PIXEL_MODE_MONO,
+                              (int)bitmap->width, (int)bitmap->rows);
+    } else {
+        g = glyph_cache_store(ctx, codepoint, NULL, 0, false, 0, 0);
+    }
+    if (!g) return NULL;
+    
+    g->advance = (int16_t)advance;
+    if (bitmap) {
+        g->left = (int16_t)face->glyph->bitmap_left;
+        g->top = (int16_t)face->glyph->bitmap_top;
+    }
+    return g;
+}
+
+/* Look up glyph, rasterizing on miss */
+static const ft_glyph_t* get_glyph(ft_text_context_t *ctx, uint32_t codepoint) {
+    ft_glyph_t *g = glyph_cache_find(ctx->cache, font_key(ctx), ctx->font_size, mono_mode(ctx),
+                                     codepoint);
+    return g ? g : glyph_cache_load(ctx, codepoint);
+}
+
+/* ===== Advance and kerning cache ===== */
+
+static void metrics_destroy(ft_metrics_t *list) {
+    while (list) {
+        ft_metrics_t *next = list->next;
+        free(list->hash_keys);
+        free(list->hash_advances);
+        free(list);
+        list = next;
+    }
+}
+
+/* Table for the current font and size, created on first use */
+static ft_metrics_t* current_metrics(ft_text_context_t *ctx) {
+    const void *font = font_key(ctx);
+    bool mono = mono_mode(ctx);
+    ft_metrics_t *m = ctx->metrics_cur;
+    
+    if (m && m->font == font && m->size == ctx->font_size && m->mono == mono) return m;
+    
+    for (m = ctx->metrics; m; m = m->next) {
+        if (m->font == font && m->size == ctx->font_size && m->mono == mono) break;
+    }
+    
+    if (!m) {
+        m = calloc(1, sizeof(ft_metrics_t));
+        if (!m) return NULL;
+        m->font = font;
+        m->size = ctx->font_size;
+        m->mono = mono;
+        for (int i = 0; i < ADVANCE_DIRECT; i++) {
+            m->direct[i] = ADVANCE_UNKNOWN;
+        }
+        m->next = ctx->metrics;
+        ctx->metrics = m;
+    }
+    
+    ctx->metrics_cur = m;
+    return m;
+}
+
+/* Slot holding codepoint, or the empty slot where it belongs */
+static size_t advance_hash_find(const ft_metrics_t *m, uint32_t codepoint) {
+    size_t mask = m->hash_capacity - 1;
+    size_t i = (codepoint * 2654435761u) & mask;
+    
+    while (m->hash_keys[i] != ADVANCE_HASH_EMPTY && m->hash_keys[i] != codepoint) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool advance_hash_insert(ft_metrics_t *m, uint32_t codepoint, int16_t advance) {
+    if ((m->hash_count + 1) * 4 > m->hash_capacity * 3) {
+        size_t capacity = m->hash_capacity ? m->hash_capacity * 2 : 64;
+        uint32_t *keys = malloc(capacity * sizeof(uint32_t));
+        int16_t *advances = malloc(capacity * sizeof(int16_t));
+        if (!keys || !advances) {
+            free(keys);
+            free(advances);
+            return false;
+        }
+        memset(keys, 0xFF, capacity * sizeof(uint32_t));
+        
+        uint32_t *old_keys = m->hash_keys;
+        int16_t *old_advances = m->hash_advances;
+        size_t old_capacity = m->hash_capacity;
+        m->hash_keys = keys;
+        m->hash_advances = advances;
+        m->hash_capacity = capacity;
+        
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_keys[i] != ADVANCE_HASH_EMPTY) {
+                size_t j = advance_hash_find(m, old_keys[i]);
+                m->hash_keys[j] = old_keys[i];
+                m->hash_advances[j] = old_advances[i];
+            }
+        }
+        free(old_keys);
+        free(old_advances);
+    }
+    
+    size_t i = advance_hash_find(m, codepoint);
+    if (m->hash_keys[i] == ADVANCE_HASH_EMPTY) m->hash_count++;
+    m->hash_keys[i] = codepoint;
+    m->hash_advances[i] = advance;
+    return true;
+}
+
+/* Advance of codepoint without rasterizing it */
+static int measure_advance(ft_text_context_t *ctx, uint32_t codepoint) {
+    if (ctx->atlas_size) {
+        const uint8_t *rec = atlas_find_glyph(ctx->atlas, ctx->atlas_size, codepoint);
+        if (rec) return (int16_t)get_le16(rec + 12);
+    }
+    
+    FT_Face face;
+    FT_UInt glyph_index;
+    if (!resolve_glyph(ctx, codepoint, &face, &glyph_index)) return 0;
+    if (FT_Load_Glyph(face, glyph_index, load_flags(ctx))) return 0;
+    return face->glyph->advance.x >> 6;
+}
+
+static int get_advance(ft_text_context_t *ctx, uint32_t codepoint) {
+    ft_metrics_t *m = current_metrics(ctx);
+    if (!m) return measure_advance(ctx, codepoint);
+    
+    if (codepoint < ADVANCE_DIRECT) {
+        if (m->direct[codepoint] == ADVANCE_UNKNOWN) {
+            m->direct[codepoint] = (int16_t)measure_advance(ctx, codepoint);
+        }
+        return m->direct[codepoint];
+    }
+    
+    if (m->hash_capacity > 0) {
+        size_t i = advance_hash_find(m, codepoint);
+        if (m->hash_keys[i] == codepoint) return m->hash_advances[i];
+    }
+    
+    int advance = measure_advance(ctx, codepoint);
+    advance_hash_insert(m, codepoint, (int16_t)advance);
+    return advance;
+}
+
+/* Kerning adjustment between two codepoints (0 unless enabled) */
+static int get_kerning(ft_text_context_t *ctx, uint32_t left, uint32_t right) {
+    if (!ctx->kerning || left == 0) return 0;
+    
+    ft_metrics_t *m = current_metrics(ctx);
+    uint64_t key = ((uint64_t)left << 32) | right;
+    size_t i = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 54) & (KERN_CACHE_SIZE - 1);
+    if (m && m->kern_keys[i] == key) return m->kern_values[i];
+    
+    /* Only pairs from the same face can be kerned */
+    int delta = 0;
+    FT_Face left_face, right_face;
+    FT_UInt left_index, right_index;
+    if (resolve_glyph(ctx, left, &left_face, &left_index) &&
+        resolve_glyph(ctx, right, &right_face, &right_index) &&
+        left_face == right_face && FT_HAS_KERNING(left_face)) {
+        FT_Vector kern;
+        if (FT_Get_Kerning(left_face, left_index, right_index, FT_KERNING_DEFAULT, &kern) == 0) {
+            delta = (int)(kern.x >> 6);
+        }
     }
     
-    /* Invalid UTF-8 */
-    *str = s;
-    return 0xFFFD;  /* Replacement character */
+    if (m) {
+        m->kern_keys[i] = key;
+        m->kern_values[i] = (int8_t)delta;
+    }
+    return delta;
+}
+
+/* Font metrics in pixels (descent positive) */
+static int get_ascent(ft_text_context_t *ctx) {
+    if (ctx->atlas_size) return (int16_t)get_le16(ctx->atlas_size + 2);
+    FT_Face face = load_face(ctx);
+    return face ? face->size->metrics.ascender >> 6 : 0;
+}
+
+static int get_descent(ft_text_context_t *ctx) {
+    if (ctx->atlas_size) return -(int16_t)get_le16(ctx->atlas_size + 4);
+    FT_Face face = load_face(ctx);
+    return face ? -(face->size->metrics.descender >> 6) : 0;
+}
+
+/* ===== Atlas baking ===== */
+
+typedef struct {
+    uint32_t codepoint;
+    uint16_t width;
+    uint16_t rows;
+    int16_t left;
+    int16_t top;
+    int16_t advance;
+    uint32_t bitmap_offset;   /* Into bitmap blob */
+} bake_glyph_t;
+
+static int compare_bake_glyph(const void *a, const void *b) {
+    uint32_t ca = ((const bake_glyph_t *)a)->codepoint;
+    uint32_t cb = ((const bake_glyph_t *)b)->codepoint;
+    return (ca > cb) - (ca < cb);
+}
+
+/* Rasterize one size into glyphs/blob; returns glyph count or -1 */
+static int bake_size(FT_Face face, const uint32_t (*ranges)[2], int range_count,
+                     bake_glyph_t **glyphs, size_t *glyph_count, size_t *glyph_capacity,
+                     uint8_t **blob, size_t *blob_size, size_t *blob_capacity) {
+    size_t first = *glyph_count;
+    
+    for (int r = 0; r < range_count; r++) {
+        for (uint32_t cp = ranges[r][0]; cp <= ranges[r][1] && cp <= 0x10FFFF; cp++) {
+            FT_UInt glyph_index = FT_Get_Char_Index(face, cp);
+            if (glyph_index == 0) continue;  /* Left to the font at runtime */
+            if (FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT) ||
+                FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) {
+                continue;
+            }
+            
+            FT_Bitmap *bitmap = &face->glyph->bitmap;
+            size_t bytes = (size_t)bitmap->width * bitmap->rows;
+            
+            if (*glyph_count == *glyph_capacity) {
+                size_t capacity = *glyph_capacity ? *glyph_capacity * 2 : 256;
+                bake_glyph_t *p = realloc(*glyphs, capacity * sizeof(bake_glyph_t));
+                if (!p) return -1;
+                *glyphs = p;
+                *glyph_capacity = capacity;
+            }
+            if (*blob_size + bytes > *blob_capacity) {
+                size_t capacity = *blob_capacity ? *blob_capacity * 2 : 65536;
+                while (capacity < *blob_size + bytes) capacity *= 2;
+                uint8_t *p = realloc(*blob, capacity);
+                if (!p) return -1;
+                *blob = p;
+                *blob_capacity = capacity;
+            }
+            
+            bake_glyph_t *g = &(*glyphs)[(*glyph_count)++];
+            g->codepoint = cp;
+            g->width = (uint16_t)bitmap->width;
+            g->rows = (uint16_t)bitmap->rows;
+            g->left = (int16_t)face->glyph->bitmap_left;
+            g->top = (int16_t)face->glyph->bitmap_top;
+            g->advance = (int16_t)(face->glyph->advance.x >> 6);
+            g->bitmap_offset = (uint32_t)*blob_size;
+            
+            for (unsigned int row = 0; row < bitmap->rows; row++) {
+                memcpy(*blob + *blob_size + row * bitmap->width,
+                       bitmap->buffer + row * bitmap->pitch, bitmap->width);
+            }
+            *blob_size += bytes;
+        }
+    }
+    
+    /* Sort for binary search and drop duplicates from overlapping ranges */
+    bake_glyph_t *slice = *glyphs + first;
+    size_t n = *glyph_count - first, out = 0;
+    qsort(slice, n, sizeof(bake_glyph_t), compare_bake_glyph);
+    for (size_t i = 0; i < n; i++) {
+        if (out == 0 || slice[out - 1].codepoint != slice[i].codepoint) {
+            slice[out++] = slice[i];
+        }
+    }
+    *glyph_count = first + out;
+    return (int)out;
+}
+
+/**
+ * Bake glyph atlas
+ */
+bool ft_text_bake_atlas(const char *font_path, const int *sizes, int size_count,
+                        const uint32_t (*ranges)[2], int range_count,
+                        const char *output_path, char *error, size_t error_size) {
+    if (!font_path || !sizes || size_count <= 0 || size_count > 0xFFFF ||
+        !ranges || range_count <= 0 || !output_path) {
+        set_error(error, error_size, "Invalid atlas parameters");
+        return false;
+    }
+    
+    ft_font_t *font = font_acquire(font_path);
+    if (!font) {
+        set_error(error, error_size, "Failed to load font: %s", font_path);
+        return false;
+    }
+    
+    size_t sizes_bytes = (size_t)size_count * ATLAS_SIZE_RECORD;
+    uint8_t *header = calloc(1, ATLAS_HEADER_SIZE + sizes_bytes);
+    bake_glyph_t *glyphs = NULL;
+    uint8_t *blob = NULL;
+    size_t glyph_count = 0, glyph_capacity = 0, blob_size = 0, blob_capacity = 0;
+    bool ok = header != NULL;
+    
+    if (!ok) set_error(error, error_size, "Out of memory");
+    
+    for (int i = 0; ok && i < size_count; i++) {
+        FT_Face face = sizes[i] > 0 ? font_face(font, sizes[i]) : NULL;
+        if (!face) {
+            set_error(error, error_size, "Failed to set font size: %d", sizes[i]);
+            ok = false;
+            break;
+        }
+        
+        size_t first = glyph_count;
+        int count = bake_size(face, ranges, range_count, &glyphs, &glyph_count, &glyph_capacity,
+                              &blob, &blob_size, &blob_capacity);
+        if (count < 0) {
+            set_error(error, error_size, "Out of memory");
+            ok = false;
+            break;
+        }
+        
+        uint8_t *rec = header + ATLAS_HEADER_SIZE + i * ATLAS_SIZE_RECORD;
+        put_le16(rec, (uint16_t)sizes[i]);
+        put_le16(rec + 2, (uint16_t)(int16_t)(face->size->metrics.ascender >> 6));
+        put_le16(rec + 4, (uint16_t)(int16_t)(face->size->metrics.descender >> 6));
+        put_le32(rec + 8, (uint32_t)count);
+        put_le32(rec + 12, (uint32_t)(ATLAS_HEADER_SIZE + sizes_bytes + first * ATLAS_GLYPH_RECORD));
+    }
+    
+    font_release(font);
+    
+    FILE *fp = NULL;
+    if (ok) {
+        memcpy(header, ATLAS_MAGIC, 4);
+        put_le16(header + 4, ATLAS_VERSION);
+        put_le16(header + 6, (uint16_t)size_count);
+        
+        /* Absolute source path so the atlas works from any directory */
+        char resolved[PATH_MAX];
+        const char *source = realpath(font_path, resolved) ? resolved : font_path;
+        size_t source_len = strlen(source);
+        
+        if (source_len >= ATLAS_PATH_SIZE) {
+            set_error(error, error_size, "Font path too long: %s", source);
+            ok = false;
+        } else {
+            memcpy(header + 8, source, source_len);
+            fp = fopen(output_path, "wb");
+        }
+        if (ok && !fp) {
+            set_error(error, error_size, "Cannot create %s: %s", output_path, strerror(errno));
+            ok = false;
+        }
+    }
+    
+    if (ok) {
+        size_t bitmap_base = ATLAS_HEADER_SIZE + sizes_bytes + glyph_count * ATLAS_GLYPH_RECORD;
+        ok = fwrite(header, 1, ATLAS_HEADER_SIZE + sizes_bytes, fp) == ATLAS_HEADER_SIZE + sizes_bytes;
+        
+        for (size_t i = 0; ok && i < glyph_count; i++) {
+            uint8_t rec[ATLAS_GLYPH_RECORD] = {0};
+            put_le32(rec, glyphs[i].codepoint);
+            put_le16(rec + 4, glyphs[i].width);
+            put_le16(rec + 6, glyphs[i].rows);
+            put_le16(rec + 8, (uint16_t)glyphs[i].left);
+            put_le16(rec + 10, (uint16_t)glyphs[i].top);
+            put_le16(rec + 12, (uint16_t)glyphs[i].advance);
+            put_le32(rec + 16, (uint32_t)(bitmap_base + glyphs[i].bitmap_offset));
+            ok = fwrite(rec, 1, sizeof(rec), fp) == sizeof(rec);
+        }
+        
+        if (ok && blob_size > 0) {
+            ok = fwrite(blob, 1, blob_size, fp) == blob_size;
+        }
+        if (fclose(fp) != 0) ok = false;
+        if (!ok) {
+            set_error(error, error_size, "Failed to write %s", output_path);
+            remove(output_path);
+        }
+    }
+    
+    free(header);
+    free(glyphs);
+    free(blob);
+    return ok;
 }
 
 /**
@@ -114,39 +1315,39 @@ ft_text_context_t* ft_text_init(weact_display_t *display,
     ctx->color = 0xFFFF;  /* White */
     ctx->align = FT_TEXT_ALIGN_LEFT;
     
-    /* Initialize FreeType */
-    if (FT_Init_FreeType(&ctx->library)) {
-        fprintf(stderr, "FreeType: Failed to initialize library\n");
+    ctx->cache = glyph_cache_create();
+    if (!ctx->cache) {
         free(ctx);
         return NULL;
     }
     
+    /* Pre-baked atlas: FreeType is only loaded for glyphs it lacks */
+    if (font_path) {
+        ctx->atlas = atlas_open(font_path, ctx->font_path, sizeof(ctx->font_path));
+        if (ctx->atlas) {
+            if (ctx->font_path[0] == '\0' && ft_text_get_default_font()) {
+                snprintf(ctx->font_path, sizeof(ctx->font_path), "%s", ft_text_get_default_font());
+            }
+            ctx->atlas_size = atlas_find_size(ctx->atlas, font_size);
+            return ctx;
+        }
+    }
+    
     /* Determine font path */
     const char *actual_font_path = font_path;
     if (!actual_font_path) {
         actual_font_path = ft_text_get_default_font();
         if (!actual_font_path) {
             fprintf(stderr, "FreeType: No suitable font found\n");
-            FT_Done_FreeType(ctx->library);
-            free(ctx);
+            ft_text_cleanup(ctx);
             return NULL;
         }
     }
+    snprintf(ctx->font_path, sizeof(ctx->font_path), "%s", actual_font_path);
     
     /* Load font */
-    if (FT_New_Face(ctx->library, actual_font_path, 0, &ctx->face)) {
-        fprintf(stderr, "FreeType: Failed to load font: %s\n", actual_font_path);
-        FT_Done_FreeType(ctx->library);
-        free(ctx);
-        return NULL;
-    }
-    
-    /* Set pixel size */
-    if (FT_Set_Pixel_Sizes(ctx->face, 0, font_size)) {
-        fprintf(stderr, "FreeType: Failed to set font size: %d\n", font_size);
-        FT_Done_Face(ctx->face);
-        FT_Done_FreeType(ctx->library);
-        free(ctx);
+    if (!load_face(ctx)) {
+        ft_text_cleanup(ctx);
         return NULL;
     }
     
@@ -158,23 +1359,64 @@ ft_text_context_t* ft_text_init(weact_display_t *display,
  */
 void ft_text_cleanup(ft_text_context_t *ctx) {
     if (ctx) {
-        if (ctx->face) FT_Done_Face(ctx->face);
-        if (ctx->library) FT_Done_FreeType(ctx->library);
+        font_release(ctx->font);
+        for (int i = 0; i < ctx->fallback_count; i++) {
+            font_release(ctx->fallbacks[i].font);
+        }
+        free(ctx->charmap);
+        glyph_cache_destroy(ctx->cache);
+        metrics_destroy(ctx->metrics);
+        atlas_close(ctx->atlas);
         free(ctx);
     }
 }
 
+/**
+ * Add fallback font
+ */
+bool ft_text_add_fallback(ft_text_context_t *ctx, const char *font_path) {
+    if (!ctx || !font_path || ctx->fallback_count >= FT_MAX_FALLBACKS ||
+        strlen(font_path) >= ATLAS_PATH_SIZE) {
+        return false;
+    }
+    
+    ft_fallback_t *fb = &ctx->fallbacks[ctx->fallback_count++];
+    memset(fb, 0, sizeof(ft_fallback_t));
+    memcpy(fb->path, font_path, strlen(font_path) + 1);
+    
+    /* Codepoints looked up so far may now resolve differently */
+    reset_caches(ctx);
+    return true;
+}
+
+/**
+ * Add installed system fallback fonts
+ */
+int ft_text_add_default_fallbacks(ft_text_context_t *ctx) {
+    if (!ctx) return 0;
+    
+    int added = 0;
+    for (int i = 0; default_fallback_paths[i] != NULL; i++) {
+        const char *path = default_fallback_paths[i];
+        if (strcmp(path, ctx->font_path) == 0 || access(path, R_OK) != 0) continue;
+        if (!ft_text_add_fallback(ctx, path)) break;
+        added++;
+    }
+    return added;
+}
+
 /**
  * Set font size
  */
 bool ft_text_set_size(ft_text_context_t *ctx, int size) {
-    if (!ctx || !ctx->face) return false;
+    if (!ctx || size <= 0) return false;
     
-    if (FT_Set_Pixel_Sizes(ctx->face, 0, size)) {
+    if (ctx->font && !font_face(ctx->font, size)) {
         return false;
     }
     
     ctx->font_size = size;
+    ctx->atlas_size = atlas_find_size(ctx->atlas, size);
     return true;
 }
 
@@ -187,6 +1429,24 @@ void ft_text_set_color(ft_text_context_t *ctx, uint16_t color) {
     }
 }
 
+/**
+ * Set glyph render mode
+ */
+void ft_text_set_render_mode(ft_text_context_t *ctx, ft_text_render_t mode) {
+    if (ctx) {
+        ctx->render_mode = mode;
+    }
+}
+
+/**
+ * Enable kerning
+ */
+void ft_text_set_kerning(ft_text_context_t *ctx, bool enable) {
+    if (ctx) {
+        ctx->kerning = enable;
+    }
+}
+
 /**
  * Set text alignment
  */
@@ -200,22 +1460,22 @@ void ft_text_set_alignment(ft_text_context_t *ctx, ft_text_align_t align) {
  * Get text width (UTF-8 aware)
  */
 int ft_text_get_width(ft_text_context_t *ctx, const char *text) {
-    if (!ctx || !ctx->face || !text) return 0;
+    if (!ctx || !text) return 0;
     
     int width = 0;
+    uint32_t prev = 0;
     const unsigned char *p = (const unsigned char *)text;
     
+    /* Table walk: no glyph is loaded or rasterized more than once per size */
     while (*p) {
         uint32_t codepoint = utf8_decode(&p);
-        if (codepoint == '\n') continue;
-        
-        /* Load glyph */
-        FT_UInt glyph_index = FT_Get_Char_Index(ctx->face, codepoint);
-        if (FT_Load_Glyph(ctx->face, glyph_index, FT_LOAD_DEFAULT)) {
+        if (codepoint == '\n') {
+            prev = 0;
             continue;
         }
         
-        width += ctx->face->glyph->advance.x >> 6;
+        width += get_kerning(ctx, prev, codepoint) + get_advance(ctx, codepoint);
+        prev = codepoint;
     }
     
     return width;
@@ -225,49 +1485,143 @@ int ft_text_get_width(ft_text_context_t *ctx, const char *text) {
  * Get text height (actual font height including ascent and descent)
  */
 int ft_text_get_height(ft_text_context_t *ctx) {
-    if (!ctx || !ctx->face) return 0;
+    if (!ctx) return 0;
     
     /* Calculate real height from font metrics */
-    int ascent = ctx->face->size->metrics.ascender >> 6;
-    int descent = -(ctx->face->size->metrics.descender >> 6);
+    return get_ascent(ctx) + get_descent(ctx);
+}
+
+/* Precompute channel blends of the text color over every background value */
+static void build_blend_lut(ft_text_context_t *ctx) {
+    int fb = ctx->color >> 11;
+    int fr = (ctx->color >> 6) & 0x1F;
+    int fg = ctx->color & 0x3F;
+    
+    for (int a = 0; a < 32; a++) {
+        for (int v = 0; v < 32; v++) {
+            ctx->blend_b[a][v] = (uint8_t)((v * (31 - a) + fb * a + 15) / 31);
+            ctx->blend_r[a][v] = (uint8_t)((v * (31 - a) + fr * a + 15) / 31);
+        }
+        for (int v = 0; v < 64; v++) {
+            ctx->blend_g[a][v] = (uint8_t)((v * (31 - a) + fg * a + 15) / 31);
+        }
+    }
     
-    return ascent + descent;
+    ctx->blend_color = ctx->color;
+    ctx->blend_valid = true;
 }
 
 /**
- * Draw a single glyph
- */
-static void draw_glyph(ft_text_context_t *ctx, FT_Bitmap *bitmap, 
-                       int x, int y, uint16_t color) {
-    for (unsigned int row = 0; row < bitmap->rows; row++) {
-        for (unsigned int col = 0; col < bitmap->width; col++) {
-            int pixel_x = x + col;
-            int pixel_y = y + row;
-            
-            /* Get pixel value (0-255) */
-            unsigned char value = bitmap->buffer[row * bitmap->pitch + col];
+ * Draw a single glyph in the context color, limited to clip
+ */
+static void draw_glyph_clipped(ft_text_context_t *ctx, const ft_glyph_t *glyph, int x, int y,
+                               const weact_rect_t *clip) {
+    weact_display_t *display = ctx->display;
+    if (!display->back_buffer) return;
+    
+    /* Clip once against the clip rectangle and the display */
+    int left = clip->x > 0 ? clip->x : 0;
+    int top = clip->y > 0 ? clip->y : 0;
+    int right = clip->x + clip->width;
+    int bottom = clip->y + clip->height;
+    if (right > display->display_width) right = display->display_width;
+    if (bottom > display->display_height) bottom = display->display_height;
+    
+    int col0 = x < left ? left - x : 0;
+    int row0 = y < top ? top - y : 0;
+    int col1 = glyph->width;
+    int row1 = glyph->rows;
+    if (x + col1 > right) col1 = right - x;
+    if (y + row1 > bottom) row1 = bottom - y;
+    if (col0 >= col1 || row0 >= row1) return;
+    
+    /* Runs: one span fill each, trimmed to the clipped box */
+    if (glyph->mono) {
+        const ft_run_t *runs = (const ft_run_t *)glyph->bitmap;
+        uint8_t hi = ctx->color >> 8;
+        uint8_t lo = ctx->color & 0xFF;
+        
+        for (int i = 0; i < glyph->run_count; i++) {
+            int row = runs[i].row;
+            int start = runs[i].x;
+            int end = start + runs[i].length;
+            if (row < row0 || row >= row1) continue;
+            if (start < col0) start = col0;
+            if (end > col1) end = col1;
+            if (start >= end) continue;
             
-            /* Skip fully transparent pixels */
-            if (value < 30) continue;
+            if (display->index_bpp) {
+                weact_draw_hline(display, x + start, y + row, end - start, ctx->color);
+                continue;
+            }
+            uint8_t *p = display->back_buffer + ((y + row) * display->display_width + x + start) * 2;
+            for (int n = end - start; n > 0; n--, p += 2) {
+                p[0] = hi;
+                p[1] = lo;
+            }
+        }
+        return;
+    }
+    
+    /* Palette indices cannot be blended: threshold instead */
+    if (ctx->render_mode == FT_TEXT_RENDER_THRESHOLD || display->index_bpp) {
+        for (int row = row0; row < row1; row++) {
+            for (int col = col0; col < col1; col++) {
+                if (glyph->bitmap[row * glyph->width + col] > 128) {
+                    weact_draw_pixel(display, x + col, y + row, ctx->color);
+                }
+            }
+        }
+        return;
+    }
+    
+    /* Blend straight into the back buffer */
+    if (!ctx->blend_valid || ctx->blend_color != ctx->color) {
+        build_blend_lut(ctx);
+    }
+    
+    uint8_t hi = ctx->color >> 8;
+    uint8_t lo = ctx->color & 0xFF;
+    
+    for (int row = row0; row < row1; row++) {
+        const uint8_t *src = glyph->bitmap + row * glyph->width;
+        uint8_t *dst = display->back_buffer + ((y + row) * display->display_width + x) * 2;
+        
+        for (int col = col0; col < col1; col++) {
+            int a = src[col] >> 3;
+            if (a == 0) continue;
             
-            /* Draw pixel with alpha blending approximation */
-            /* For simplicity, we just draw if value > threshold */
-            if (value > 128) {
-                weact_draw_pixel(ctx->display, pixel_x, pixel_y, color);
+            uint8_t *p = dst + col * 2;
+            if (a == 31) {
+                p[0] = hi;
+                p[1] = lo;
+                continue;
             }
+            
+            int bg = (p[0] << 8) | p[1];
+            int out = (ctx->blend_b[a][bg >> 11] << 11) |
+                      (ctx->blend_r[a][(bg >> 6) & 0x1F] << 6) |
+                      ctx->blend_g[a][bg & 0x3F];
+            p[0] = (uint8_t)(out >> 8);
+            p[1] = (uint8_t)(out & 0xFF);
         }
     }
 }
 
+static void draw_glyph(ft_text_context_t *ctx, const ft_glyph_t *glyph, int x, int y) {
+    weact_rect_t all = { 0, 0, ctx->display->display_width, ctx->display->display_height };
+    draw_glyph_clipped(ctx, glyph, x, y, &all);
+}
+
 /**
  * Draw text (UTF-8 with Cyrillic support!)
  */
 void ft_text_draw(ft_text_context_t *ctx, int x, int y, const char *text) {
-    if (!ctx || !ctx->face || !text) return;
+    if (!ctx || !text) return;
     
     /* Calculate ascent (height above baseline) */
     /* This converts Y from "top of text" to "baseline" */
-    int ascent = ctx->face->size->metrics.ascender >> 6;
+    int ascent = get_ascent(ctx);
     
     int pen_x = x;
     int pen_y = y + ascent;  /* Move baseline down by ascent */
@@ -286,6 +1640,7 @@ void ft_text_draw(ft_text_context_t *ctx, int x, int y, const char *text) {
     
     /* Draw each character */
     const unsigned char *p = (const unsigned char *)text;
+    uint32_t prev = 0;
     
     while (*p) {
         uint32_t codepoint = utf8_decode(&p);
@@ -294,111 +1649,713 @@ void ft_text_draw(ft_text_context_t *ctx, int x, int y, const char *text) {
         if (codepoint == '\n') {
             pen_x = x;
             pen_y += ctx->font_size;
+            prev = 0;
             continue;
         }
         
-        /* Load glyph */
-        FT_UInt glyph_index = FT_Get_Char_Index(ctx->face, codepoint);
-        if (FT_Load_Glyph(ctx->face, glyph_index, FT_LOAD_DEFAULT)) {
-            continue;
-        }
+        pen_x += get_kerning(ctx, prev, codepoint);
+        prev = codepoint;
         
-        /* Render glyph */
-        if (FT_Render_Glyph(ctx->face->glyph, FT_RENDER_MODE_NORMAL)) {
+        /* Cached glyph (rasterized once per face, size and codepoint) */
+        const ft_glyph_t *glyph = get_glyph(ctx, codepoint);
+        if (!glyph) {
             continue;
         }
         
         /* Draw glyph bitmap */
-        draw_glyph(ctx, &ctx->face->glyph->bitmap,
-                   pen_x + ctx->face->glyph->bitmap_left,
-                   pen_y - ctx->face->glyph->bitmap_top,
-                   ctx->color);
+        draw_glyph(ctx, glyph, pen_x + glyph->left, pen_y - glyph->top);
         
         /* Advance pen */
-        pen_x += ctx->face->glyph->advance.x >> 6;
+        pen_x += glyph->advance;
     }
 }
 
 /**
- * Draw text with word wrapping (UTF-8 aware)
+ * Draw a single character inside clip
  */
-void ft_text_draw_wrapped(ft_text_context_t *ctx, int x, int y,
-                           int max_width, int max_height, const char *text) {
-    if (!ctx || !text) return;
+void ft_text_draw_char(ft_text_context_t *ctx, int x, int y, uint32_t codepoint,
+                       const weact_rect_t *clip) {
+    if (!ctx || !clip) return;
     
-    int current_y = y;
+    const ft_glyph_t *glyph = get_glyph(ctx, codepoint);
+    if (!glyph) return;
     
-    /* Calculate proper line height from font metrics */
-    int ascent = ctx->face->size->metrics.ascender >> 6;
-    int descent = -(ctx->face->size->metrics.descender >> 6);
-    int line_height = ascent + descent + 2;  /* +2 for line spacing */
+    int baseline = y + get_ascent(ctx);
+    draw_glyph_clipped(ctx, glyph, x + glyph->left, baseline - glyph->top, clip);
+}
+
+/* ===== Character cells ===== */
+
+/* Cells are addressed through a direct table: keep ranges in the BMP */
+#define CELLS_MAX_CODEPOINT 0x10000
+
+struct ft_text_cells {
+    weact_display_t *display;
+    int width;
+    int height;
+    uint32_t limit;           /* Codepoints below this have a slot */
+    uint16_t *slot;           /* Codepoint -> mask index + 1, 0 if not rendered */
+    uint8_t *masks;           /* width * height bytes per character, 1 = ink */
+};
+
+/**
+ * Get cell size from font metrics
+ */
+void ft_text_get_cell_size(ft_text_context_t *ctx, int *width, int *height) {
+    int max_advance = 0;
     
-    /* Simple word wrapping */
-    char line_buffer[512];
-    int line_pos = 0;
-    const char *word_start = text;
-    const char *p = text;
+    if (ctx) {
+        char text[2] = { 0, 0 };
+        for (int c = 0x20; c < 0x7F; c++) {
+            text[0] = (char)c;
+            int advance = ft_text_get_width(ctx, text);
+            if (advance > max_advance) max_advance = advance;
+        }
+    }
     
-    while (*p) {
-        /* Find word boundary */
-        while (*p && *p != ' ' && *p != '\n' && *p != '\t') p++;
-        
-        int word_len = p - word_start;
-        
-        /* Build test line */
-        char test_line[512];
-        snprintf(test_line, sizeof(test_line), "%.*s%s%.*s",
-                 line_pos, line_buffer,
-                 (line_pos > 0) ? " " : "",
-                 word_len, word_start);
-        
-        int test_width = ft_text_get_width(ctx, test_line);
-        
-        /* Check if line is too long */
-        if (test_width > max_width && line_pos > 0) {
-            /* Draw current line */
-            line_buffer[line_pos] = '\0';
-            ft_text_draw(ctx, x, current_y, line_buffer);
-            
-            current_y += line_height;
-            if (current_y + line_height > y + max_height) {
-                break;
+    if (width) *width = max_advance > 0 ? max_advance : 1;
+    if (height) {
+        int h = ctx ? ft_text_get_height(ctx) : 0;
+        *height = h > 0 ? h : 1;
+    }
+}
+
+/* Rasterize one glyph into a cell mask, pen at the left edge on the baseline */
+static void render_cell_mask(const ft_glyph_t *glyph, int ascent, uint8_t *mask,
+                             int width, int height) {
+    int gx = glyph->left;
+    int gy = ascent - glyph->top;
+    
+    if (glyph->mono) {
+        const ft_run_t *runs = (const ft_run_t *)glyph->bitmap;
+        for (int i = 0; i < glyph->run_count; i++) {
+            int y = gy + runs[i].row;
+            if (y < 0 || y >= height) continue;
+            for (int x = gx + runs[i].x; x < gx + runs[i].x + runs[i].length; x++) {
+                if (x >= 0 && x < width) mask[y * width + x] = 1;
+            }
+        }
+        return;
+    }
+    
+    for (int row = 0; row < glyph->rows; row++) {
+        int y = gy + row;
+        if (y < 0 || y >= height) continue;
+        for (int col = 0; col < glyph->width; col++) {
+            int x = gx + col;
+            if (x >= 0 && x < width && glyph->bitmap[row * glyph->width + col] > 128) {
+                mask[y * width + x] = 1;
             }
+        }
+    }
+}
+
+/**
+ * Pre-render cells
+ */
+ft_text_cells_t* ft_text_cells_create(ft_text_context_t *ctx, int width, int height,
+                                      const uint32_t (*ranges)[2], int range_count) {
+    if (!ctx || width <= 0 || height <= 0 || !ranges || range_count <= 0) return NULL;
+    
+    uint32_t limit = 0;
+    size_t count = 0;
+    for (int i = 0; i < range_count; i++) {
+        if (ranges[i][0] > ranges[i][1] || ranges[i][1] >= CELLS_MAX_CODEPOINT) return NULL;
+        if (ranges[i][1] + 1 > limit) limit = ranges[i][1] + 1;
+        count += ranges[i][1] - ranges[i][0] + 1;
+    }
+    
+    ft_text_cells_t *cells = calloc(1, sizeof(ft_text_cells_t));
+    if (!cells) return NULL;
+    
+    size_t cell_bytes = (size_t)width * height;
+    cells->display = ctx->display;
+    cells->width = width;
+    cells->height = height;
+    cells->limit = limit;
+    cells->slot = calloc(limit, sizeof(uint16_t));
+    cells->masks = calloc(count, cell_bytes);
+    if (!cells->slot || !cells->masks) {
+        ft_text_cells_destroy(cells);
+        return NULL;
+    }
+    
+    int ascent = get_ascent(ctx);
+    uint16_t used = 0;
+    
+    for (int i = 0; i < range_count; i++) {
+        for (uint32_t cp = ranges[i][0]; cp <= ranges[i][1]; cp++) {
+            if (cells->slot[cp]) continue;  /* Overlapping ranges */
             
-            /* Start new line with current word */
-            snprintf(line_buffer, sizeof(line_buffer), "%.*s", word_len, word_start);
-            line_pos = word_len;
-        } else {
-            /* Add word to current line */
-            if (line_pos > 0 && line_pos < (int)sizeof(line_buffer) - 1) {
-                line_buffer[line_pos++] = ' ';
+            const ft_glyph_t *glyph = get_glyph(ctx, cp);
+            if (!glyph || used == UINT16_MAX) continue;
+            
+            render_cell_mask(glyph, ascent, cells->masks + used * cell_bytes, width, height);
+            cells->slot[cp] = ++used;
+        }
+    }
+    
+    return cells;
+}
+
+/**
+ * Free cells
+ */
+void ft_text_cells_destroy(ft_text_cells_t *cells) {
+    if (cells) {
+        free(cells->slot);
+        free(cells->masks);
+        free(cells);
+    }
+}
+
+/**
+ * Draw one cell in a single pass
+ */
+bool ft_text_cells_draw(const ft_text_cells_t *cells, int x, int y, uint32_t codepoint,
+                        uint16_t fg, uint16_t bg) {
+    if (!cells || codepoint >= cells->limit || !cells->slot[codepoint]) return false;
+    
+    weact_display_t *display = cells->display;
+    if (!display->back_buffer) return false;
+    
+    const uint8_t *mask = cells->masks +
+                          (size_t)(cells->slot[codepoint] - 1) * cells->width * cells->height;
+    
+    /* Indexed buffers and cells crossing the edge go pixel by pixel */
+    if (display->index_bpp || x < 0 || y < 0 ||
+        x + cells->width > display->display_width ||
+        y + cells->height > display->display_height) {
+        for (int row = 0; row < cells->height; row++) {
+            for (int col = 0; col < cells->width; col++) {
+                weact_draw_pixel(display, x + col, y + row, *mask++ ? fg : bg);
             }
-            for (int i = 0; i < word_len && line_pos < (int)sizeof(line_buffer) - 1; i++) {
-                line_buffer[line_pos++] = word_start[i];
+        }
+        return true;
+    }
+    
+    uint8_t colors[2][2] = { { bg >> 8, bg & 0xFF }, { fg >> 8, fg & 0xFF } };
+    
+    for (int row = 0; row < cells->height; row++) {
+        uint8_t *p = display->back_buffer + ((y + row) * display->display_width + x) * 2;
+        for (int col = 0; col < cells->width; col++, p += 2) {
+            const uint8_t *c = colors[*mask++];
+            p[0] = c[0];
+            p[1] = c[1];
+        }
+    }
+    return true;
+}
+
+/* ===== Word wrap ===== */
+
+/* Positioned glyph in a layout */
+typedef struct {
+    uint32_t codepoint;
+    int16_t x;                /* Ink box relative to the layout origin */
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+    int16_t line;             /* Line and pen position: ordering key for diffs */
+    int16_t pen_x;
+} ft_layout_glyph_t;
+
+struct ft_text_layout {
+    const void *font;
+    int size;
+    int width;                /* Box width used for alignment */
+    int height;               /* Line stack height */
+    int lines;
+    bool overflow;
+    bool has_bounds;
+    weact_rect_t bounds;      /* Ink bounding box */
+    ft_layout_glyph_t *glyphs;
+    int count;
+    int capacity;
+    bool failed;              /* Allocation error while building */
+};
+
+/* One wrapped line: words in [start, end) separated by whitespace runs */
+typedef struct {
+    const unsigned char *start;
+    const unsigned char *end;
+    int width;
+    int gaps;                 /* Whitespace runs between words */
+    bool last;                /* Ends a paragraph (not justified) */
+} wrap_line_t;
+
+typedef struct {
+    ft_text_context_t *ctx;
+    int x;
+    int y;
+    int max_width;
+    int max_height;           /* <= 0: unlimited */
+    bool draw;
+    int line_height;
+    int space_width;
+    int lines;
+    bool overflow;
+    int widest;
+    ft_text_layout_t *layout; /* Record glyphs instead of drawing */
+} wrap_state_t;
+
+static bool is_blank(unsigned char c) {
+    return c == ' ' || c == '\t';
+}
+
+/* Width of a word (no whitespace inside) */
+static int word_width(ft_text_context_t *ctx, const unsigned char *p, const unsigned char *end) {
+    int width = 0;
+    uint32_t prev = 0;
+    
+    while (p < end) {
+        uint32_t codepoint = utf8_decode(&p);
+        width += get_kerning(ctx, prev, codepoint) + get_advance(ctx, codepoint);
+        prev = codepoint;
+    }
+    return width;
+}
+
+static void layout_add(ft_text_layout_t *layout, uint32_t codepoint, const ft_glyph_t *glyph,
+                       int x, int y, int line, int pen_x) {
+    if (glyph->width == 0 || glyph->rows == 0) return;
+    
+    if (layout->count == layout->capacity) {
+        int capacity = layout->capacity ? layout->capacity * 2 : 64;
+        ft_layout_glyph_t *p = realloc(layout->glyphs, (size_t)capacity * sizeof(ft_layout_glyph_t));
+        if (!p) {
+            layout->failed = true;
+            return;
+        }
+        layout->glyphs = p;
+        layout->capacity = capacity;
+    }
+    
+    ft_layout_glyph_t *g = &layout->glyphs[layout->count++];
+    g->codepoint = codepoint;
+    g->x = (int16_t)x;
+    g->y = (int16_t)y;
+    g->width = glyph->width;
+    g->height = glyph->rows;
+    g->line = (int16_t)line;
+    g->pen_x = (int16_t)pen_x;
+    
+    weact_rect_t r = { x, y, glyph->width, glyph->rows };
+    if (!layout->has_bounds) {
+        layout->bounds = r;
+        layout->has_bounds = true;
+    } else {
+        int x1 = layout->bounds.x + layout->bounds.width;
+        int y1 = layout->bounds.y + layout->bounds.height;
+        if (r.x + r.width > x1) x1 = r.x + r.width;
+        if (r.y + r.height > y1) y1 = r.y + r.height;
+        if (r.x < layout->bounds.x) layout->bounds.x = r.x;
+        if (r.y < layout->bounds.y) layout->bounds.y = r.y;
+        layout->bounds.width = x1 - layout->bounds.x;
+        layout->bounds.height = y1 - layout->bounds.y;
+    }
+}
+
+/* Draw line at its left edge; extra pixels are spread over the gaps */
+static void draw_line(const wrap_state_t *st, const wrap_line_t *line, int x, int y, int extra) {
+    ft_text_context_t *ctx = st->ctx;
+    const unsigned char *p = line->start;
+    int pen_x = x;
+    int pen_y = y + get_ascent(ctx);
+    int gap = 0;
+    uint32_t prev = 0;
+    
+    while (p < line->end) {
+        if (is_blank(*p)) {
+            while (p < line->end && is_blank(*p)) p++;
+            pen_x += st->space_width;
+            if (line->gaps > 0) {
+                pen_x += extra / line->gaps + (gap < extra % line->gaps ? 1 : 0);
             }
+            gap++;
+            prev = 0;
+            continue;
         }
         
-        /* Handle newline */
-        if (*p == '\n') {
-            if (line_pos > 0) {
-                line_buffer[line_pos] = '\0';
-                ft_text_draw(ctx, x, current_y, line_buffer);
-                current_y += line_height;
-                line_pos = 0;
+        uint32_t codepoint = utf8_decode(&p);
+        pen_x += get_kerning(ctx, prev, codepoint);
+        prev = codepoint;
+        
+        const ft_glyph_t *glyph = get_glyph(ctx, codepoint);
+        if (glyph) {
+            if (st->layout) {
+                layout_add(st->layout, codepoint, glyph, pen_x + glyph->left,
+                           pen_y - glyph->top, st->lines, pen_x);
+            } else {
+                draw_glyph(ctx, glyph, pen_x + glyph->left, pen_y - glyph->top);
             }
+            pen_x += glyph->advance;
+        }
+    }
+}
+
+/* Place line below the previous ones; false once the box is full */
+static bool wrap_emit(wrap_state_t *st, const wrap_line_t *line) {
+    if (st->max_height > 0 && st->lines > 0 &&
+        (st->lines + 1) * st->line_height > st->max_height) {
+        st->overflow = true;
+        return false;
+    }
+    
+    if (line->width > st->widest) st->widest = line->width;
+    
+    if (st->draw) {
+        int slack = st->max_width - line->width;
+        int x = st->x;
+        int extra = 0;
+        
+        switch (st->ctx->align) {
+            case FT_TEXT_ALIGN_CENTER:
+                x += slack / 2;
+                break;
+            case FT_TEXT_ALIGN_RIGHT:
+                x += slack;
+                break;
+            case FT_TEXT_ALIGN_JUSTIFY:
+                if (!line->last && line->gaps > 0) extra = slack;
+                break;
+            default:
+                break;
+        }
+        if (x < st->x) x = st->x;
+        if (extra < 0) extra = 0;
+        
+        draw_line(st, line, x, st->y + st->lines * st->line_height, extra);
+    }
+    
+    st->lines++;
+    return true;
+}
+
+/* Break a word wider than the box at character boundaries */
+static bool wrap_split_word(wrap_state_t *st, const unsigned char *start, const unsigned char *end,
+                            wrap_line_t *line) {
+    ft_text_context_t *ctx = st->ctx;
+    const unsigned char *p = start;
+    const unsigned char *chunk = start;
+    int width = 0;
+    uint32_t prev = 0;
+    
+    while (p < end) {
+        const unsigned char *c = p;
+        uint32_t codepoint = utf8_decode(&p);
+        int advance = get_kerning(ctx, prev, codepoint) + get_advance(ctx, codepoint);
+        
+        if (width > 0 && width + advance > st->max_width) {
+            wrap_line_t piece = { chunk, c, width, 0, false };
+            if (!wrap_emit(st, &piece)) return false;
+            chunk = c;
+            width = 0;
+            advance = get_advance(ctx, codepoint);
+        }
+        width += advance;
+        prev = codepoint;
+    }
+    
+    line->start = chunk;
+    line->end = end;
+    line->width = width;
+    line->gaps = 0;
+    return true;
+}
+
+/* Single pass over the text: every word is measured once from cached advances */
+static void wrap_text(wrap_state_t *st, const char *text) {
+    ft_text_context_t *ctx = st->ctx;
+    const unsigned char *p = (const unsigned char *)text;
+    wrap_line_t line = { NULL, NULL, 0, 0, false };
+    bool has_words = false;
+    
+    st->line_height = get_ascent(ctx) + get_descent(ctx) + 2;  /* +2 for line spacing */
+    st->space_width = get_advance(ctx, ' ');
+    st->lines = 0;
+    st->overflow = false;
+    st->widest = 0;
+    
+    for (;;) {
+        while (is_blank(*p)) p++;
+        
+        /* End of paragraph */
+        if (*p == '\n' || *p == '\0') {
+            if (*p == '\0' && !has_words) return;
+            if (!has_words) line.start = line.end = p;  /* Blank line */
+            line.last = true;
+            if (!wrap_emit(st, &line)) return;
+            if (*p == '\0') return;
             p++;
-            word_start = p;
+            has_words = false;
+            continue;
+        }
+        
+        const unsigned char *word = p;
+        while (*p && !is_blank(*p) && *p != '\n') p++;
+        int width = word_width(ctx, word, p);
+        
+        if (has_words && line.width + st->space_width + width <= st->max_width) {
+            line.end = p;
+            line.width += st->space_width + width;
+            line.gaps++;
+            continue;
+        }
+        
+        if (has_words) {
+            line.last = false;
+            if (!wrap_emit(st, &line)) return;
+        }
+        
+        has_words = true;
+        line.last = false;
+        if (width > st->max_width) {
+            if (!wrap_split_word(st, word, p, &line)) return;
+        } else {
+            line.start = word;
+            line.end = p;
+            line.width = width;
+            line.gaps = 0;
+        }
+    }
+}
+
+/**
+ * Draw text with word wrapping (UTF-8 aware)
+ */
+bool ft_text_draw_wrapped(ft_text_context_t *ctx, int x, int y,
+                          int max_width, int max_height, const char *text) {
+    if (!ctx || !text) return false;
+    
+    wrap_state_t st = { ctx, x, y, max_width, max_height, true, 0, 0, 0, false, 0, NULL };
+    wrap_text(&st, text);
+    return !st.overflow;
+}
+
+/**
+ * Measure wrapped text without drawing
+ */
+bool ft_text_measure_wrapped(ft_text_context_t *ctx, int max_width, int max_height,
+                             const char *text, ft_text_wrap_info_t *info) {
+    if (!ctx || !text) return false;
+    
+    wrap_state_t st = { ctx, 0, 0, max_width, max_height, false, 0, 0, 0, false, 0, NULL };
+    wrap_text(&st, text);
+    
+    if (info) {
+        info->lines = st.lines;
+        info->height = st.lines > 0 ? st.lines * st.line_height - 2 : 0;
+        info->overflow = st.overflow;
+    }
+    return !st.overflow;
+}
+
+/* ===== Layouts ===== */
+
+/**
+ * Lay out text once for repeated drawing
+ */
+ft_text_layout_t* ft_text_layout_create(ft_text_context_t *ctx, const char *text,
+                                        int max_width, int max_height) {
+    if (!ctx || !text) return NULL;
+    
+    ft_text_layout_t *layout = calloc(1, sizeof(ft_text_layout_t));
+    if (!layout) return NULL;
+    
+    /* Unwrapped text is aligned within its widest line */
+    if (max_width <= 0) {
+        wrap_state_t measure = { ctx, 0, 0, INT16_MAX, max_height, false, 0, 0, 0, false, 0, NULL };
+        wrap_text(&measure, text);
+        max_width = measure.widest;
+    }
+    
+    wrap_state_t st = { ctx, 0, 0, max_width, max_height, true, 0, 0, 0, false, 0, layout };
+    wrap_text(&st, text);
+    
+    if (layout->failed) {
+        ft_text_layout_destroy(layout);
+        return NULL;
+    }
+    
+    layout->font = font_key(ctx);
+    layout->size = ctx->font_size;
+    layout->width = max_width;
+    layout->lines = st.lines;
+    layout->height = st.lines > 0 ? st.lines * st.line_height - 2 : 0;
+    layout->overflow = st.overflow;
+    return layout;
+}
+
+/**
+ * Free layout
+ */
+void ft_text_layout_destroy(ft_text_layout_t *layout) {
+    if (layout) {
+        free(layout->glyphs);
+        free(layout);
+    }
+}
+
+/**
+ * Get layout box and ink bounds
+ */
+void ft_text_layout_get_info(const ft_text_layout_t *layout, ft_text_wrap_info_t *info,
+                             weact_rect_t *bounds) {
+    if (!layout) return;
+    
+    if (info) {
+        info->lines = layout->lines;
+        info->height = layout->height;
+        info->overflow = layout->overflow;
+    }
+    if (bounds) {
+        weact_rect_t empty = { 0, 0, 0, 0 };
+        *bounds = layout->has_bounds ? layout->bounds : empty;
+    }
+}
+
+/* Draw layout glyphs that touch clip (display coordinates) */
+static void layout_draw_clipped(ft_text_context_t *ctx, const ft_text_layout_t *layout,
+                                int x, int y, const weact_rect_t *clip) {
+    /* Glyphs are cached per size: render at the size the layout was made with */
+    int size = ctx->font_size;
+    if (size != layout->size) ft_text_set_size(ctx, layout->size);
+    
+    for (int i = 0; i < layout->count; i++) {
+        const ft_layout_glyph_t *g = &layout->glyphs[i];
+        int gx = x + g->x;
+        int gy = y + g->y;
+        
+        if (gx >= clip->x + clip->width || gx + g->width <= clip->x ||
+            gy >= clip->y + clip->height || gy + g->height <= clip->y) {
             continue;
         }
         
-        /* Skip whitespace */
-        while (*p == ' ' || *p == '\t') p++;
-        word_start = p;
+        const ft_glyph_t *glyph = get_glyph(ctx, g->codepoint);
+        if (glyph) draw_glyph_clipped(ctx, glyph, gx, gy, clip);
+    }
+    
+    if (size != layout->size) ft_text_set_size(ctx, size);
+}
+
+/**
+ * Draw layout at offset
+ */
+void ft_text_layout_draw(ft_text_context_t *ctx, const ft_text_layout_t *layout, int x, int y) {
+    if (!ctx || !layout) return;
+    
+    weact_rect_t all = { 0, 0, ctx->display->display_width, ctx->display->display_height };
+    layout_draw_clipped(ctx, layout, x, y, &all);
+}
+
+static bool layout_glyph_equal(const ft_layout_glyph_t *a, const ft_layout_glyph_t *b) {
+    return a->codepoint == b->codepoint && a->x == b->x && a->y == b->y;
+}
+
+/* Ordering of glyphs by line, then pen position */
+static int layout_glyph_order(const ft_layout_glyph_t *a, const ft_layout_glyph_t *b) {
+    if (a->line != b->line) return a->line < b->line ? -1 : 1;
+    if (a->pen_x != b->pen_x) return a->pen_x < b->pen_x ? -1 : 1;
+    return 0;
+}
+
+static void rect_union(weact_rect_t *dst, const weact_rect_t *r) {
+    int x1 = dst->x + dst->width;
+    int y1 = dst->y + dst->height;
+    if (r->x + r->width > x1) x1 = r->x + r->width;
+    if (r->y + r->height > y1) y1 = r->y + r->height;
+    if (r->x < dst->x) dst->x = r->x;
+    if (r->y < dst->y) dst->y = r->y;
+    dst->width = x1 - dst->x;
+    dst->height = y1 - dst->y;
+}
+
+/* Add changed glyph box; boxes on the same line are merged into spans */
+static void diff_add(weact_rect_t *rects, int *count, int max_rects, int *last_line,
+                     const ft_layout_glyph_t *g) {
+    weact_rect_t r = { g->x, g->y, g->width, g->height };
+    
+    if (*count > 0 && (*last_line == g->line || *count >= max_rects)) {
+        rect_union(&rects[*count - 1], &r);
+    } else {
+        rects[(*count)++] = r;
+    }
+    *last_line = g->line;
+}
+
+/**
+ * Diff two layouts
+ */
+int ft_text_layout_diff(const ft_text_layout_t *old, const ft_text_layout_t *layout,
+                        weact_rect_t *rects, int max_rects) {
+    if (!layout || !rects || max_rects <= 0) return 0;
+    
+    int count = 0;
+    int last_line = -1;
+    
+    /* Different font or size: everything changed */
+    if (!old || old->font != layout->font || old->size != layout->size) {
+        weact_rect_t all = layout->has_bounds ? layout->bounds : (weact_rect_t){ 0, 0, 0, 0 };
+        if (old && old->has_bounds) {
+            if (layout->has_bounds) rect_union(&all, &old->bounds);
+            else all = old->bounds;
+        }
+        if (all.width <= 0 || all.height <= 0) return 0;
+        rects[0] = all;
+        return 1;
+    }
+    
+    /* Both are in line / pen order: merge walk */
+    int i = 0, j = 0;
+    while (i < old->count || j < layout->count) {
+        const ft_layout_glyph_t *a = i < old->count ? &old->glyphs[i] : NULL;
+        const ft_layout_glyph_t *b = j < layout->count ? &layout->glyphs[j] : NULL;
+        
+        if (a && b) {
+            int order = layout_glyph_order(a, b);
+            if (order == 0) {
+                if (!layout_glyph_equal(a, b)) {
+                    diff_add(rects, &count, max_rects, &last_line, a);
+                    diff_add(rects, &count, max_rects, &last_line, b);
+                }
+                i++;
+                j++;
+            } else if (order < 0) {
+                diff_add(rects, &count, max_rects, &last_line, a);
+                i++;
+            } else {
+                diff_add(rects, &count, max_rects, &last_line, b);
+                j++;
+            }
+        } else if (a) {
+            diff_add(rects, &count, max_rects, &last_line, a);
+            i++;
+        } else {
+            diff_add(rects, &count, max_rects, &last_line, b);
+            j++;
+        }
     }
     
-    /* Draw last line */
-    if (line_pos > 0) {
-        line_buffer[line_pos] = '\0';
-        ft_text_draw(ctx, x, current_y, line_buffer);
+    return count;
+}
+
+/**
+ * Redraw only what changed between layouts
+ */
+int ft_text_layout_update(ft_text_context_t *ctx, const ft_text_layout_t *old,
+                          const ft_text_layout_t *layout, int x, int y, uint16_t bg,
+                          weact_rect_t *rects, int max_rects) {
+    if (!ctx || !layout || !rects || max_rects <= 0) return 0;
+    
+    int count = ft_text_layout_diff(old, layout, rects, max_rects);
+    
+    for (int i = 0; i < count; i++) {
+        rects[i].x += x;
+        rects[i].y += y;
+        weact_draw_rect(ctx->display, rects[i].x, rects[i].y, rects[i].width, rects[i].height,
+                        bg, true);
+        layout_draw_clipped(ctx, layout, x, y, &rects[i]);
     }
+    return count;
 }
@@ -8,6 +8,8 @@
 
 #include "weact_display.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* Font size presets (can use any size 6-32) */
 #define FT_FONT_SIZE_SMALL  8
@@ -18,16 +20,40 @@
 typedef enum {
     FT_TEXT_ALIGN_LEFT = 0,
     FT_TEXT_ALIGN_CENTER,
-    FT_TEXT_ALIGN_RIGHT
+    FT_TEXT_ALIGN_RIGHT,
+    FT_TEXT_ALIGN_JUSTIFY        /* Wrapped text only; single lines draw left */
 } ft_text_align_t;
 
+/* Wrapped text metrics */
+typedef struct {
+    int lines;                   /* Lines that fit */
+    int height;                  /* Pixels used by those lines */
+    bool overflow;               /* Text did not fit in max_height */
+} ft_text_wrap_info_t;
+
+/* Glyph render mode */
+typedef enum {
+    FT_TEXT_RENDER_AA = 0,       /* Coverage blended into the background (default) */
+    FT_TEXT_RENDER_THRESHOLD,    /* Only pixels above 50% coverage, no blending */
+    FT_TEXT_RENDER_MONO          /* Hinted 1-bit glyphs drawn as spans (fastest) */
+} ft_text_render_t;
+
 /* FreeType text context */
 typedef struct ft_text_context ft_text_context_t;
 
+/* Laid-out text: positioned glyphs, reusable across frames */
+typedef struct ft_text_layout ft_text_layout_t;
+
+/* Characters pre-rendered into fixed-size cells (terminal grids) */
+typedef struct ft_text_cells ft_text_cells_t;
+
 /**
  * Initialize FreeType text renderer
  * @param display WeAct display handle
- * @param font_path Path to TTF font file (NULL for default DejaVu Sans)
+ * @param font_path Path to TTF font file or .watlas glyph atlas
+ *                  (NULL for default DejaVu Sans). An atlas is mapped
+ *                  instead of loading FreeType; glyphs and sizes it does
+ *                  not contain are rendered from its source font on demand.
  * @param font_size Font size in points (6-32)
  * @return Text context or NULL on error
  */
@@ -40,8 +66,24 @@ ft_text_context_t* ft_text_init(weact_display_t *display,
  */
 void ft_text_cleanup(ft_text_context_t *ctx);
 
+/**
+ * Add fallback font for codepoints the primary font lacks
+ * Fallbacks are searched in the order added and opened only when a
+ * codepoint first reaches them; the result is cached per codepoint.
+ * @return false if the chain is full
+ */
+bool ft_text_add_fallback(ft_text_context_t *ctx, const char *font_path);
+
+/**
+ * Add installed system fonts (DejaVu, Noto symbols/CJK, ...) as fallbacks
+ * @return Number of fonts added
+ */
+int ft_text_add_default_fallbacks(ft_text_context_t *ctx);
+
 /**
  * Set font size
+ * Each size is scaled once and keeps its glyph and advance caches, so
+ * switching back and forth between sizes is cheap.
  */
 bool ft_text_set_size(ft_text_context_t *ctx, int size);
 
@@ -50,6 +92,22 @@ bool ft_text_set_size(ft_text_context_t *ctx, int size);
  */
 void ft_text_set_color(ft_text_context_t *ctx, uint16_t color);
 
+/**
+ * Set glyph render mode
+ * Anti-aliasing blends with what is already in the back buffer, so draw
+ * over a cleared background rather than over earlier text.
+ * Palette-indexed displays use the threshold mode unless mono is selected.
+ * Mono glyphs are hinted for 1-bit output and may be narrower than
+ * anti-aliased ones; layouts are measured in the mode active when created.
+ */
+void ft_text_set_render_mode(ft_text_context_t *ctx, ft_text_render_t mode);
+
+/**
+ * Enable kerning from the font's kern table (default: off)
+ * Applies to both measuring and drawing. Loads the font if an atlas is used.
+ */
+void ft_text_set_kerning(ft_text_context_t *ctx, bool enable);
+
 /**
  * Set text alignment
  */
@@ -74,17 +132,141 @@ int ft_text_get_height(ft_text_context_t *ctx);
  */
 void ft_text_draw(ft_text_context_t *ctx, int x, int y, const char *text);
 
+/**
+ * Draw a single character, keeping every pixel inside clip
+ * Meant for character cells: glyphs that overhang the cell cannot leave
+ * pixels in a neighbour that is not repainted.
+ * @param x X coordinate (pen position)
+ * @param y Y coordinate (top of the line, as ft_text_draw)
+ * @param clip Rectangle in display coordinates
+ */
+void ft_text_draw_char(ft_text_context_t *ctx, int x, int y, uint32_t codepoint,
+                       const weact_rect_t *clip);
+
+/**
+ * Get character cell size from the font metrics at the current size
+ * Width is the widest printable ASCII advance (the advance of every glyph
+ * for a monospace font), height is ascent + descent.
+ */
+void ft_text_get_cell_size(ft_text_context_t *ctx, int *width, int *height);
+
+/**
+ * Pre-render characters into cell bitmaps
+ * Glyphs use the current font, size and render mode, with the pen at the
+ * cell's left edge and the baseline at the font ascent; ink outside the
+ * cell is cut off. Codepoints must be below U+10000.
+ * @param ranges Inclusive codepoint ranges as {first, last} pairs
+ * @return Cell set or NULL on error
+ */
+ft_text_cells_t* ft_text_cells_create(ft_text_context_t *ctx, int width, int height,
+                                      const uint32_t (*ranges)[2], int range_count);
+
+/**
+ * Free cell set
+ */
+void ft_text_cells_destroy(ft_text_cells_t *cells);
+
+/**
+ * Draw a pre-rendered cell: background and glyph in one pass
+ * @param x Cell left edge
+ * @param y Cell top edge
+ * @return false if the character was not pre-rendered (nothing drawn)
+ */
+bool ft_text_cells_draw(const ft_text_cells_t *cells, int x, int y, uint32_t codepoint,
+                        uint16_t fg, uint16_t bg);
+
 /**
  * Draw text with word wrapping
+ * Each line is aligned inside the box with the context alignment; newlines
+ * start a new paragraph and words wider than the box are broken.
+ * @param ctx Text context
+ * @param x Box X coordinate
+ * @param y Box Y coordinate (top)
+ * @param max_width Box width in pixels
+ * @param max_height Box height in pixels (<= 0: unlimited)
+ * @param text UTF-8 text string (any length)
+ * @return false if the text did not fit
+ */
+bool ft_text_draw_wrapped(ft_text_context_t *ctx, int x, int y,
+                          int max_width, int max_height, const char *text);
+
+/**
+ * Measure wrapped text without drawing
+ * @param info Line count, height and overflow (may be NULL)
+ * @return false if the text does not fit
+ */
+bool ft_text_measure_wrapped(ft_text_context_t *ctx, int max_width, int max_height,
+                             const char *text, ft_text_wrap_info_t *info);
+
+/**
+ * Lay out text once for repeated drawing
+ * Text is wrapped and aligned as by ft_text_draw_wrapped() with the current
+ * size and alignment, and stored as positioned glyphs.
  * @param ctx Text context
- * @param x X coordinate
- * @param y Y coordinate
- * @param max_width Maximum width in pixels
- * @param max_height Maximum height in pixels
  * @param text UTF-8 text string
+ * @param max_width Box width (<= 0: no wrapping, align within widest line)
+ * @param max_height Box height (<= 0: unlimited)
+ * @return Layout or NULL on error
+ */
+ft_text_layout_t* ft_text_layout_create(ft_text_context_t *ctx, const char *text,
+                                        int max_width, int max_height);
+
+/**
+ * Free layout
+ */
+void ft_text_layout_destroy(ft_text_layout_t *layout);
+
+/**
+ * Get layout lines/height and ink bounding box (layout coordinates)
+ * @param info Line count, height and overflow (may be NULL)
+ * @param bounds Pixels touched when drawn at 0,0 (may be NULL)
+ */
+void ft_text_layout_get_info(const ft_text_layout_t *layout, ft_text_wrap_info_t *info,
+                             weact_rect_t *bounds);
+
+/**
+ * Draw layout with its top-left corner at x, y
+ */
+void ft_text_layout_draw(ft_text_context_t *ctx, const ft_text_layout_t *layout, int x, int y);
+
+/**
+ * Find glyph cells that differ between two layouts
+ * Changed cells on one line are merged; when max_rects is exceeded the
+ * remaining cells are merged into the last rectangle.
+ * @param old Previous layout (NULL: everything changed)
+ * @param layout New layout
+ * @param rects Output rectangles (layout coordinates)
+ * @return Number of rectangles
+ */
+int ft_text_layout_diff(const ft_text_layout_t *old, const ft_text_layout_t *layout,
+                        weact_rect_t *rects, int max_rects);
+
+/**
+ * Replace old layout with new one on screen, touching only changed cells
+ * Changed cells are cleared to bg and redrawn from the new layout.
+ * @param rects Output: changed areas in display coordinates, e.g. for
+ *              weact_flush_region()
+ * @return Number of rectangles
+ */
+int ft_text_layout_update(ft_text_context_t *ctx, const ft_text_layout_t *old,
+                          const ft_text_layout_t *layout, int x, int y, uint16_t bg,
+                          weact_rect_t *rects, int max_rects);
+
+/**
+ * Bake glyph atlas for fast startup
+ * @param font_path TTF font to rasterize
+ * @param sizes Pixel sizes to bake
+ * @param size_count Number of sizes
+ * @param ranges Inclusive codepoint ranges as {first, last} pairs
+ * @param range_count Number of ranges
+ * @param output_path Atlas file to write (pass it to ft_text_init())
+ * @param error Buffer for error message (may be NULL)
+ * @param error_size Size of error buffer
+ * @return true on success
  */
-void ft_text_draw_wrapped(ft_text_context_t *ctx, int x, int y,
-                           int max_width, int max_height, const char *text);
+bool ft_text_bake_atlas(const char *font_path, const int *sizes, int size_count,
+                        const uint32_t (*ranges)[2], int range_count,
+                        const char *output_path, char *error, size_t error_size);
 
 /**
  * Check if FreeType is available
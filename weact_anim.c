@@ -0,0 +1,514 @@
+/**
+ * Pre-encoded Delta Animation Implementation
+ */
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "weact_anim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ANIM_MAGIC              "WANM"
+#define ANIM_HEADER_SIZE        20
+#define ANIM_FRAME_HEADER_SIZE  8
+#define ANIM_REGION_HEADER_SIZE 10
+#define ANIM_MAX_DIMENSION      1024
+
+/* Change detection granularity in pixels */
+#define ANIM_TILE 8
+
+/* Tile classes (values >= 0 are solid colours) */
+#define TILE_UNCHANGED (-2)
+#define TILE_MIXED     (-1)
+
+struct weact_anim_encoder {
+    FILE *fp;
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+    uint16_t *prev;             /* Previous frame */
+    bool have_prev;
+    int32_t *tile_class;
+    bool *tile_used;
+    uint8_t *payload;           /* Encoded frame being built */
+    size_t payload_size;
+    size_t payload_capacity;
+    uint32_t duration_ms;
+    weact_anim_stats_t stats;
+    bool failed;
+};
+
+struct weact_anim {
+    uint8_t *data;
+    size_t size;
+    int width;
+    int height;
+    uint32_t frame_count;
+    uint32_t duration_ms;
+};
+
+static void set_error(char *error, size_t error_size, const char *fmt, ...) {
+    if (error && error_size > 0) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(error, error_size, fmt, args);
+        va_end(args);
+    }
+}
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* ===== Encoder ===== */
+
+static uint8_t* payload_reserve(weact_anim_encoder_t *enc, size_t bytes) {
+    if (enc->payload_size + bytes > enc->payload_capacity) {
+        size_t capacity = enc->payload_capacity * 2;
+        if (capacity < enc->payload_size + bytes) capacity = enc->payload_size + bytes;
+        uint8_t *p = realloc(enc->payload, capacity);
+        if (!p) return NULL;
+        enc->payload = p;
+        enc->payload_capacity = capacity;
+    }
+    uint8_t *p = enc->payload + enc->payload_size;
+    enc->payload_size += bytes;
+    return p;
+}
+
+static bool write_header(weact_anim_encoder_t *enc) {
+    uint8_t header[ANIM_HEADER_SIZE];
+    memcpy(header, ANIM_MAGIC, 4);
+    put_le16(header + 4, WEACT_ANIM_VERSION);
+    put_le16(header + 6, (uint16_t)enc->width);
+    put_le16(header + 8, (uint16_t)enc->height);
+    put_le16(header + 10, 0);
+    put_le32(header + 12, (uint32_t)enc->stats.frames);
+    put_le32(header + 16, enc->duration_ms);
+    return fwrite(header, 1, sizeof(header), enc->fp) == sizeof(header);
+}
+
+weact_anim_encoder_t* weact_anim_encoder_create(const char *path, int width, int height,
+                                                char *error, size_t error_size) {
+    if (!path || width <= 0 || height <= 0 ||
+        width > ANIM_MAX_DIMENSION || height > ANIM_MAX_DIMENSION) {
+        set_error(error, error_size, "Invalid animation size %dx%d", width, height);
+        return NULL;
+    }
+
+    weact_anim_encoder_t *enc = calloc(1, sizeof(weact_anim_encoder_t));
+    if (!enc) {
+        set_error(error, error_size, "Out of memory");
+        return NULL;
+    }
+
+    enc->width = width;
+    enc->height = height;
+    enc->tiles_x = (width + ANIM_TILE - 1) / ANIM_TILE;
+    enc->tiles_y = (height + ANIM_TILE - 1) / ANIM_TILE;
+    enc->prev = malloc((size_t)width * height * sizeof(uint16_t));
+    enc->tile_class = malloc((size_t)enc->tiles_x * enc->tiles_y * sizeof(int32_t));
+    enc->tile_used = malloc((size_t)enc->tiles_x * enc->tiles_y * sizeof(bool));
+
+    if (!enc->prev || !enc->tile_class || !enc->tile_used) {
+        set_error(error, error_size, "Out of memory");
+        weact_anim_encoder_finish(enc, NULL);
+        return NULL;
+    }
+
+    enc->fp = fopen(path, "wb");
+    if (!enc->fp) {
+        set_error(error, error_size, "Cannot create %s: %s", path, strerror(errno));
+        weact_anim_encoder_finish(enc, NULL);
+        return NULL;
+    }
+
+    /* Placeholder header, rewritten by weact_anim_encoder_finish() */
+    if (!write_header(enc)) {
+        set_error(error, error_size, "Write error: %s", strerror(errno));
+        weact_anim_encoder_finish(enc, NULL);
+        return NULL;
+    }
+
+    return enc;
+}
+
+/* Classify tile as unchanged, solid colour or mixed */
+static int32_t classify_tile(const weact_anim_encoder_t *enc, const uint16_t *pixels,
+                             int tx, int ty) {
+    int x0 = tx * ANIM_TILE, y0 = ty * ANIM_TILE;
+    int x1 = x0 + ANIM_TILE, y1 = y0 + ANIM_TILE;
+    if (x1 > enc->width) x1 = enc->width;
+    if (y1 > enc->height) y1 = enc->height;
+
+    bool changed = !enc->have_prev;
+    bool solid = true;
+    uint16_t first = pixels[y0 * enc->width + x0];
+
+    for (int y = y0; y < y1; y++) {
+        const uint16_t *row = pixels + y * enc->width;
+        const uint16_t *prev_row = enc->prev + y * enc->width;
+        if (!changed && memcmp(row + x0, prev_row + x0, (size_t)(x1 - x0) * 2) != 0) {
+            changed = true;
+        }
+        for (int x = x0; x < x1 && solid; x++) {
+            if (row[x] != first) solid = false;
+        }
+        if (changed && !solid) break;
+    }
+
+    if (!changed) return TILE_UNCHANGED;
+    return solid ? (int32_t)first : TILE_MIXED;
+}
+
+/* Shrink rectangle to the bounding box of pixels that differ from prev */
+static void tighten_rect(const weact_anim_encoder_t *enc, const uint16_t *pixels,
+                         int *x, int *y, int *w, int *h) {
+    int min_x = *x + *w, min_y = *y + *h, max_x = *x - 1, max_y = *y - 1;
+
+    for (int yy = *y; yy < *y + *h; yy++) {
+        const uint16_t *row = pixels + yy * enc->width;
+        const uint16_t *prev_row = enc->prev + yy * enc->width;
+        for (int xx = *x; xx < *x + *w; xx++) {
+            if (row[xx] != prev_row[xx]) {
+                if (xx < min_x) min_x = xx;
+                if (xx > max_x) max_x = xx;
+                if (yy < min_y) min_y = yy;
+                if (yy > max_y) max_y = yy;
+            }
+        }
+    }
+
+    if (max_x >= min_x) {
+        *x = min_x;
+        *y = min_y;
+        *w = max_x - min_x + 1;
+        *h = max_y - min_y + 1;
+    }
+}
+
+static bool emit_region(weact_anim_encoder_t *enc, const uint16_t *pixels,
+                        int32_t cls, int x, int y, int w, int h) {
+    if (cls == TILE_MIXED && enc->have_prev) {
+        tighten_rect(enc, pixels, &x, &y, &w, &h);
+    }
+
+    size_t data_size = (cls >= 0) ? 2 : (size_t)w * h * 2;
+    uint8_t *p = payload_reserve(enc, ANIM_REGION_HEADER_SIZE + data_size);
+    if (!p) return false;
+
+    p[0] = (cls >= 0) ? WEACT_ANIM_REGION_FILL : WEACT_ANIM_REGION_BITMAP;
+    p[1] = 0;
+    put_le16(p + 2, (uint16_t)x);
+    put_le16(p + 4, (uint16_t)y);
+    put_le16(p + 6, (uint16_t)w);
+    put_le16(p + 8, (uint16_t)h);
+    p += ANIM_REGION_HEADER_SIZE;
+
+    if (cls >= 0) {
+        put_le16(p, (uint16_t)cls);
+        enc->stats.fill_regions++;
+    } else {
+        /* Display byte order: high byte first, same as the back buffer */
+        for (int yy = y; yy < y + h; yy++) {
+            const uint16_t *row = pixels + yy * enc->width;
+            for (int xx = x; xx < x + w; xx++) {
+                *p++ = row[xx] >> 8;
+                *p++ = row[xx] & 0xFF;
+            }
+        }
+        enc->stats.bitmap_regions++;
+    }
+
+    return true;
+}
+
+bool weact_anim_encoder_add_frame(weact_anim_encoder_t *enc, const uint16_t *pixels,
+                                  uint16_t delay_ms) {
+    if (!enc || !pixels || enc->failed) return false;
+
+    int tiles = enc->tiles_x * enc->tiles_y;
+    for (int ty = 0; ty < enc->tiles_y; ty++) {
+        for (int tx = 0; tx < enc->tiles_x; tx++) {
+            enc->tile_class[ty * enc->tiles_x + tx] = classify_tile(enc, pixels, tx, ty);
+        }
+    }
+    memset(enc->tile_used, 0, (size_t)tiles * sizeof(bool));
+
+    enc->payload_size = 0;
+    uint8_t *frame_header = payload_reserve(enc, ANIM_FRAME_HEADER_SIZE);
+    if (!frame_header) {
+        enc->failed = true;
+        return false;
+    }
+
+    /* Greedy merge: extend runs of equal-class tiles right, then down */
+    int regions = 0;
+    for (int ty = 0; ty < enc->tiles_y; ty++) {
+        for (int tx = 0; tx < enc->tiles_x; tx++) {
+            int idx = ty * enc->tiles_x + tx;
+            int32_t cls = enc->tile_class[idx];
+            if (cls == TILE_UNCHANGED || enc->tile_used[idx]) continue;
+
+            int run = 1;
+            while (tx + run < enc->tiles_x &&
+                   enc->tile_class[idx + run] == cls && !enc->tile_used[idx + run]) {
+                run++;
+            }
+
+            int rows = 1;
+            while (ty + rows < enc->tiles_y) {
+                int base = (ty + rows) * enc->tiles_x + tx;
+                bool match = true;
+                for (int i = 0; i < run && match; i++) {
+                    match = enc->tile_class[base + i] == cls && !enc->tile_used[base + i];
+                }
+                if (!match) break;
+                rows++;
+            }
+
+            for (int r = 0; r < rows; r++) {
+                memset(enc->tile_used + (ty + r) * enc->tiles_x + tx, 1, (size_t)run);
+            }
+
+            int x = tx * ANIM_TILE, y = ty * ANIM_TILE;
+            int w = run * ANIM_TILE, h = rows * ANIM_TILE;
+            if (x + w > enc->width) w = enc->width - x;
+            if (y + h > enc->height) h = enc->height - y;
+
+            if (!emit_region(enc, pixels, cls, x, y, w, h)) {
+                enc->failed = true;
+                return false;
+            }
+            regions++;
+        }
+    }
+
+    /* payload may have moved while growing */
+    frame_header = enc->payload;
+    put_le16(frame_header, delay_ms);
+    put_le16(frame_header + 2, (uint16_t)regions);
+    put_le32(frame_header + 4, (uint32_t)(enc->payload_size - ANIM_FRAME_HEADER_SIZE));
+
+    if (fwrite(enc->payload, 1, enc->payload_size, enc->fp) != enc->payload_size) {
+        enc->failed = true;
+        return false;
+    }
+
+    memcpy(enc->prev, pixels, (size_t)enc->width * enc->height * sizeof(uint16_t));
+    enc->have_prev = true;
+    enc->duration_ms += delay_ms;
+    enc->stats.frames++;
+    return true;
+}
+
+bool weact_anim_encoder_finish(weact_anim_encoder_t *enc, weact_anim_stats_t *stats) {
+    if (!enc) return false;
+
+    bool ok = !enc->failed && enc->fp != NULL;
+
+    if (enc->fp) {
+        if (ok) {
+            ok = fseek(enc->fp, 0, SEEK_SET) == 0 && write_header(enc) &&
+                 fseek(enc->fp, 0, SEEK_END) == 0;
+            long size = ftell(enc->fp);
+            enc->stats.file_size = size > 0 ? (size_t)size : 0;
+        }
+        if (fclose(enc->fp) != 0) ok = false;
+    }
+
+    if (stats) *stats = enc->stats;
+
+    free(enc->prev);
+    free(enc->tile_class);
+    free(enc->tile_used);
+    free(enc->payload);
+    free(enc);
+    return ok;
+}
+
+/* ===== Player ===== */
+
+weact_anim_t* weact_anim_open(const char *path, char *error, size_t error_size) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        set_error(error, error_size, "Cannot open %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < ANIM_HEADER_SIZE) {
+        set_error(error, error_size, "Not a .wanim file: %s", path);
+        close(fd);
+        return NULL;
+    }
+
+    uint8_t *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        set_error(error, error_size, "mmap failed: %s", strerror(errno));
+        return NULL;
+    }
+
+    weact_anim_t *anim = calloc(1, sizeof(weact_anim_t));
+    if (!anim) {
+        munmap(data, (size_t)st.st_size);
+        set_error(error, error_size, "Out of memory");
+        return NULL;
+    }
+    anim->data = data;
+    anim->size = (size_t)st.st_size;
+
+    if (memcmp(data, ANIM_MAGIC, 4) != 0 || get_le16(data + 4) != WEACT_ANIM_VERSION) {
+        set_error(error, error_size, "Not a .wanim v%d file: %s", WEACT_ANIM_VERSION, path);
+        weact_anim_close(anim);
+        return NULL;
+    }
+
+    anim->width = get_le16(data + 6);
+    anim->height = get_le16(data + 8);
+    anim->frame_count = get_le32(data + 12);
+    anim->duration_ms = get_le32(data + 16);
+
+    /* Nothing to play: a looping player would spin without sending */
+    if (anim->frame_count == 0) {
+        set_error(error, error_size, "No frames in %s", path);
+        weact_anim_close(anim);
+        return NULL;
+    }
+
+    /* Validate the whole file once so playback needs no bounds checks */
+    size_t pos = ANIM_HEADER_SIZE;
+    for (uint32_t f = 0; f < anim->frame_count; f++) {
+        if (pos + ANIM_FRAME_HEADER_SIZE > anim->size) goto corrupt;
+        int regions = get_le16(data + pos + 2);
+        size_t end = pos + ANIM_FRAME_HEADER_SIZE + get_le32(data + pos + 4);
+        if (end > anim->size) goto corrupt;
+        pos += ANIM_FRAME_HEADER_SIZE;
+
+        for (int r = 0; r < regions; r++) {
+            if (pos + ANIM_REGION_HEADER_SIZE > end) goto corrupt;
+            const uint8_t *p = data + pos;
+            int x = get_le16(p + 2), y = get_le16(p + 4);
+            int w = get_le16(p + 6), h = get_le16(p + 8);
+            if (w == 0 || h == 0 || x + w > anim->width || y + h > anim->height) goto corrupt;
+            pos += ANIM_REGION_HEADER_SIZE;
+            pos += (p[0] == WEACT_ANIM_REGION_FILL) ? 2 : (size_t)w * h * 2;
+            if (pos > end) goto corrupt;
+        }
+        if (pos != end) goto corrupt;
+    }
+
+    return anim;
+
+corrupt:
+    set_error(error, error_size, "Corrupt animation file: %s", path);
+    weact_anim_close(anim);
+    return NULL;
+}
+
+void weact_anim_get_info(const weact_anim_t *anim, int *width, int *height,
+                         int *frame_count, uint32_t *duration_ms) {
+    if (width) *width = anim ? anim->width : 0;
+    if (height) *height = anim ? anim->height : 0;
+    if (frame_count) *frame_count = anim ? (int)anim->frame_count : 0;
+    if (duration_ms) *duration_ms = anim ? anim->duration_ms : 0;
+}
+
+static void timespec_add_ms(struct timespec *ts, unsigned int ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+bool weact_anim_play(weact_display_t *display, const weact_anim_t *anim, int loops) {
+    if (!display || !anim) return false;
+
+    if (anim->width > display->display_width || anim->height > display->display_height) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Animation %dx%d does not fit display %dx%d",
+                 anim->width, anim->height, display->display_width, display->display_height);
+        return false;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    for (int loop = 0; loops <= 0 || loop < loops; loop++) {
+        const uint8_t *p = anim->data + ANIM_HEADER_SIZE;
+
+        for (uint32_t f = 0; f < anim->frame_count; f++) {
+            uint16_t delay_ms = get_le16(p);
+            int regions = get_le16(p + 2);
+            p += ANIM_FRAME_HEADER_SIZE;
+
+            for (int r = 0; r < regions; r++) {
+                int x = get_le16(p + 2), y = get_le16(p + 4);
+                int w = get_le16(p + 6), h = get_le16(p + 8);
+                bool ok;
+
+                if (p[0] == WEACT_ANIM_REGION_FILL) {
+                    ok = weact_fill_rect(display, x, y, w, h,
+                                         get_le16(p + ANIM_REGION_HEADER_SIZE));
+                    p += ANIM_REGION_HEADER_SIZE + 2;
+                } else {
+                    ok = weact_send_bitmap(display, x, y, w, h, p + ANIM_REGION_HEADER_SIZE);
+                    p += ANIM_REGION_HEADER_SIZE + (size_t)w * h * 2;
+                }
+                if (!ok) return false;
+            }
+
+            /* Absolute deadlines keep the timeline from drifting; if the
+             * link could not keep up, restart the timeline from now. */
+            timespec_add_ms(&deadline, delay_ms);
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec > deadline.tv_sec ||
+                (now.tv_sec == deadline.tv_sec && now.tv_nsec > deadline.tv_nsec)) {
+                deadline = now;
+            } else {
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void weact_anim_close(weact_anim_t *anim) {
+    if (!anim) return;
+    if (anim->data) munmap(anim->data, anim->size);
+    free(anim);
+}
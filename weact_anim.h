@@ -0,0 +1,100 @@
+/**
+ * Pre-encoded Delta Animations for WeAct Display (.wanim)
+ *
+ * Each frame stores only the rectangles that changed since the previous
+ * frame. Solid-colour rectangles are stored as FULL (0x04) fills, the
+ * rest as raw SET_BITMAP (0x05) pixel data in display byte order, so the
+ * player can stream them from an mmap without touching the pixels.
+ *
+ * File layout (little-endian):
+ *   header:  "WANM" u16 version, u16 width, u16 height, u16 reserved,
+ *            u32 frame_count, u32 total_duration_ms
+ *   frame:   u16 delay_ms, u16 region_count, u32 payload_size
+ *   region:  u8 type, u8 reserved, u16 x, u16 y, u16 width, u16 height,
+ *            then u16 color (FILL) or width*height*2 pixel bytes (BITMAP)
+ *
+ * The first frame is always a complete key frame, so looping playback
+ * restarts correctly without an extra reset.
+ */
+
+#ifndef WEACT_ANIM_H
+#define WEACT_ANIM_H
+
+#include "weact_display.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WEACT_ANIM_VERSION 1
+
+/* Region types */
+#define WEACT_ANIM_REGION_BITMAP 0
+#define WEACT_ANIM_REGION_FILL   1
+
+/* Encoder statistics */
+typedef struct {
+    int frames;
+    int bitmap_regions;
+    int fill_regions;
+    size_t file_size;
+} weact_anim_stats_t;
+
+typedef struct weact_anim_encoder weact_anim_encoder_t;
+typedef struct weact_anim weact_anim_t;
+
+/**
+ * Create animation file
+ * @param path Output .wanim path
+ * @param width Frame width
+ * @param height Frame height
+ * @param error Buffer for error message (may be NULL)
+ * @param error_size Size of error buffer
+ * @return Encoder or NULL on error
+ */
+weact_anim_encoder_t* weact_anim_encoder_create(const char *path, int width, int height,
+                                                char *error, size_t error_size);
+
+/**
+ * Append frame
+ * @param enc Encoder
+ * @param pixels width * height BRG565 values
+ * @param delay_ms Time the frame stays on screen
+ * @return true on success
+ */
+bool weact_anim_encoder_add_frame(weact_anim_encoder_t *enc, const uint16_t *pixels,
+                                  uint16_t delay_ms);
+
+/**
+ * Finalize header, close file and free encoder
+ * @param enc Encoder
+ * @param stats Filled with encoding statistics (may be NULL)
+ * @return true if the file was written completely
+ */
+bool weact_anim_encoder_finish(weact_anim_encoder_t *enc, weact_anim_stats_t *stats);
+
+/**
+ * Open (mmap) animation file
+ */
+weact_anim_t* weact_anim_open(const char *path, char *error, size_t error_size);
+
+/**
+ * Get animation properties
+ */
+void weact_anim_get_info(const weact_anim_t *anim, int *width, int *height,
+                         int *frame_count, uint32_t *duration_ms);
+
+/**
+ * Play animation with time-correct pacing
+ * @param display WeAct display handle
+ * @param anim Animation
+ * @param loops Number of loops (0 = forever)
+ * @return false on transport error (see display->last_error)
+ */
+bool weact_anim_play(weact_display_t *display, const weact_anim_t *anim, int loops);
+
+/**
+ * Unmap and free animation
+ */
+void weact_anim_close(weact_anim_t *anim);
+
+#endif /* WEACT_ANIM_H */
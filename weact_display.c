@@ -15,6 +15,18 @@
 #include <errno.h>
 #include <time.h>
 
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/* Default palette for indexed mode */
+static const uint16_t default_palette[8] = {
+    WEACT_BLACK, WEACT_WHITE, WEACT_RED, WEACT_GREEN,
+    WEACT_BLUE, WEACT_YELLOW, WEACT_CYAN, WEACT_MAGENTA
+};
+
+static bool write_all(weact_display_t *display, const uint8_t *data, size_t length);
+
 /* Private helper function to send command */
 static bool send_command(weact_display_t *display, const uint8_t *data, size_t length) {
     if (!display->is_connected) {
@@ -23,6 +35,11 @@ static bool send_command(weact_display_t *display, const uint8_t *data, size_t l
         return false;
     }
     
+    if (display->nonblocking) {
+        /* Queued behind any pending pixel data; no settle delay */
+        return write_all(display, data, length);
+    }
+    
     ssize_t written = write(display->fd, data, length);
     if (written < 0) {
         snprintf(display->last_error, sizeof(display->last_error), 
@@ -40,6 +57,209 @@ static bool send_command(weact_display_t *display, const uint8_t *data, size_t l
     return true;
 }
 
+/* Private helper: non-blocking write; what the port does not take now
+ * is appended to the output queue, behind anything already queued */
+static bool queue_write(weact_display_t *display, const uint8_t *data, size_t length) {
+    while (length > 0 && display->tx_head == display->tx_tail) {
+        ssize_t written = write(display->fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            snprintf(display->last_error, sizeof(display->last_error),
+                     "Write error: %s", strerror(errno));
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    
+    if (length == 0) return true;
+    
+    if (display->tx_tail + length > display->tx_capacity) {
+        /* Move pending bytes to the front, then grow if still short */
+        size_t pending = display->tx_tail - display->tx_head;
+        memmove(display->tx_queue, display->tx_queue + display->tx_head, pending);
+        display->tx_head = 0;
+        display->tx_tail = pending;
+        
+        if (pending + length > display->tx_capacity) {
+            size_t capacity = display->tx_capacity ? display->tx_capacity * 2 : WEACT_MAX_BUFFER_SIZE;
+            while (capacity < pending + length) capacity *= 2;
+            uint8_t *queue = realloc(display->tx_queue, capacity);
+            if (!queue) {
+                snprintf(display->last_error, sizeof(display->last_error),
+                         "Out of memory for output queue");
+                return false;
+            }
+            display->tx_queue = queue;
+            display->tx_capacity = capacity;
+        }
+    }
+    
+    memcpy(display->tx_queue + display->tx_tail, data, length);
+    display->tx_tail += length;
+    return true;
+}
+
+/* Private helper: write whole buffer, retrying on short writes */
+static bool write_all(weact_display_t *display, const uint8_t *data, size_t length) {
+    if (display->nonblocking) {
+        return queue_write(display, data, length);
+    }
+    
+    while (length > 0) {
+        ssize_t written = write(display->fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            snprintf(display->last_error, sizeof(display->last_error),
+                     "Write error: %s", strerror(errno));
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+/* Private helper: clip rectangle to display, false if nothing is left */
+static bool clip_rect(const weact_display_t *display, int *x, int *y, int *width, int *height) {
+    if (*x < 0) { *width += *x; *x = 0; }
+    if (*y < 0) { *height += *y; *y = 0; }
+    if (*x + *width > display->display_width) *width = display->display_width - *x;
+    if (*y + *height > display->display_height) *height = display->display_height - *y;
+    return *width > 0 && *height > 0;
+}
+
+/* Private helper: encode rectangle coordinates into command bytes 1-8 */
+static void encode_rect(uint8_t *cmd, int x, int y, int width, int height) {
+    int x_end = x + width - 1;
+    int y_end = y + height - 1;
+    
+    cmd[1] = x & 0xFF;
+    cmd[2] = (x >> 8) & 0xFF;
+    cmd[3] = y & 0xFF;
+    cmd[4] = (y >> 8) & 0xFF;
+    cmd[5] = x_end & 0xFF;
+    cmd[6] = (x_end >> 8) & 0xFF;
+    cmd[7] = y_end & 0xFF;
+    cmd[8] = (y_end >> 8) & 0xFF;
+}
+
+/* Private helper: rebuild index expansion table from palette */
+static void build_index_lut(weact_display_t *display) {
+    int bpp = display->index_bpp;
+    int per_byte = 8 / bpp;
+    int mask = (1 << bpp) - 1;
+    
+    if (bpp == 8) {
+        for (int i = 0; i < 256; i++) {
+            display->index_lut[i * 2] = display->palette[i] >> 8;
+            display->index_lut[i * 2 + 1] = display->palette[i] & 0xFF;
+        }
+        return;
+    }
+    
+    /* One entry per packed byte: per_byte pixels, 2 bytes each */
+    for (int b = 0; b < 256; b++) {
+        uint8_t *entry = display->index_lut + b * per_byte * 2;
+        for (int k = 0; k < per_byte; k++) {
+            uint16_t color = display->palette[(b >> (8 - bpp * (k + 1))) & mask];
+            entry[k * 2] = color >> 8;
+            entry[k * 2 + 1] = color & 0xFF;
+        }
+    }
+}
+
+/* Private helper: read one palette index */
+static inline int get_index(const weact_display_t *display, int x, int y) {
+    int bpp = display->index_bpp;
+    const uint8_t *row = display->index_buffer + y * display->index_stride;
+    int bit = x * bpp;
+    return (row[bit >> 3] >> (8 - bpp - (bit & 7))) & ((1 << bpp) - 1);
+}
+
+#if defined(__SSSE3__)
+/* Private helper: 4bpp -> BRG565 with PSHUFB, 16 pixels per step */
+static int expand_4bpp_ssse3(const weact_display_t *display, const uint8_t *src,
+                             uint8_t *dst, int bytes) {
+    uint8_t pal_hi[16], pal_lo[16];
+    for (int i = 0; i < 16; i++) {
+        pal_hi[i] = display->palette[i] >> 8;
+        pal_lo[i] = display->palette[i] & 0xFF;
+    }
+    
+    const __m128i hi_tab = _mm_loadu_si128((const __m128i *)pal_hi);
+    const __m128i lo_tab = _mm_loadu_si128((const __m128i *)pal_lo);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    int done = 0;
+    
+    for (; done + 8 <= bytes; done += 8) {
+        __m128i in = _mm_loadl_epi64((const __m128i *)(src + done));
+        __m128i first = _mm_and_si128(_mm_srli_epi16(in, 4), nibble);
+        __m128i second = _mm_and_si128(in, nibble);
+        __m128i idx = _mm_unpacklo_epi8(first, second);
+        __m128i hi = _mm_shuffle_epi8(hi_tab, idx);
+        __m128i lo = _mm_shuffle_epi8(lo_tab, idx);
+        _mm_storeu_si128((__m128i *)(dst + done * 4), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + done * 4 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    
+    return done;
+}
+#endif
+
+/* Private helper: expand index row span to BRG565 (display byte order) */
+static void expand_index_row(const weact_display_t *display, int y, int x, int width,
+                             uint8_t *dst) {
+    int bpp = display->index_bpp;
+    int per_byte = 8 / bpp;
+    int end = x + width;
+    
+    /* Leading pixels up to a byte boundary */
+    while (x < end && (x % per_byte) != 0) {
+        uint16_t color = display->palette[get_index(display, x, y)];
+        *dst++ = color >> 8;
+        *dst++ = color & 0xFF;
+        x++;
+    }
+    
+    /* Whole bytes through the LUT */
+    const uint8_t *src = display->index_buffer + y * display->index_stride + x / per_byte;
+    int bytes = (end - x) / per_byte;
+    int done = 0;
+    
+#if defined(__SSSE3__)
+    if (bpp == 4) {
+        done = expand_4bpp_ssse3(display, src, dst, bytes);
+    }
+#endif
+    
+    switch (bpp) {
+        case 8:
+            for (int i = done; i < bytes; i++) memcpy(dst + i * 2, display->index_lut + src[i] * 2, 2);
+            break;
+        case 4:
+            for (int i = done; i < bytes; i++) memcpy(dst + i * 4, display->index_lut + src[i] * 4, 4);
+            break;
+        case 2:
+            for (int i = done; i < bytes; i++) memcpy(dst + i * 8, display->index_lut + src[i] * 8, 8);
+            break;
+        default:
+            for (int i = done; i < bytes; i++) memcpy(dst + i * 16, display->index_lut + src[i] * 16, 16);
+            break;
+    }
+    dst += bytes * per_byte * 2;
+    x += bytes * per_byte;
+    
+    /* Trailing pixels */
+    while (x < end) {
+        uint16_t color = display->palette[get_index(display, x, y)];
+        *dst++ = color >> 8;
+        *dst++ = color & 0xFF;
+        x++;
+    }
+}
+
 /* Color Conversion: RGB888 to BRG565 */
 uint16_t weact_rgb_to_brg565(uint8_t r, uint8_t g, uint8_t b) {
     uint8_t r5 = (r >> 3) & 0x1F;  /* 5 bits red */
@@ -50,6 +270,35 @@ uint16_t weact_rgb_to_brg565(uint8_t r, uint8_t g, uint8_t b) {
     return (b5 << 11) | (r5 << 6) | g6;
 }
 
+/* Private helper: allocate buffers and set default state once fd is open */
+static bool init_state(weact_display_t *display) {
+    display->frame_buffer = (uint8_t *)malloc(WEACT_MAX_BUFFER_SIZE);
+    display->back_buffer = (uint8_t *)malloc(WEACT_MAX_BUFFER_SIZE);
+    
+    if (!display->frame_buffer || !display->back_buffer) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Failed to allocate memory buffers");
+        if (display->frame_buffer) free(display->frame_buffer);
+        if (display->back_buffer) free(display->back_buffer);
+        display->frame_buffer = NULL;
+        display->back_buffer = NULL;
+        close(display->fd);
+        return false;
+    }
+    
+    memset(display->frame_buffer, 0, WEACT_MAX_BUFFER_SIZE);
+    memset(display->back_buffer, 0, WEACT_MAX_BUFFER_SIZE);
+    
+    /* Initialize display state */
+    display->is_connected = true;
+    display->orientation = WEACT_LANDSCAPE;
+    display->brightness = 255;
+    display->display_width = WEACT_DISPLAY_WIDTH;
+    display->display_height = WEACT_DISPLAY_HEIGHT;
+    display->last_error[0] = '\0';
+    return true;
+}
+
 /* Initialize display */
 bool weact_init(weact_display_t *display, const char *port_name) {
     if (!display || !port_name) {
@@ -106,30 +355,10 @@ bool weact_init(weact_display_t *display, const char *port_name) {
         return false;
     }
     
-    /* Allocate buffers */
-    display->frame_buffer = (uint8_t *)malloc(WEACT_MAX_BUFFER_SIZE);
-    display->back_buffer = (uint8_t *)malloc(WEACT_MAX_BUFFER_SIZE);
-    
-    if (!display->frame_buffer || !display->back_buffer) {
-        snprintf(display->last_error, sizeof(display->last_error),
-                 "Failed to allocate memory buffers");
-        if (display->frame_buffer) free(display->frame_buffer);
-        if (display->back_buffer) free(display->back_buffer);
-        close(display->fd);
+    if (!init_state(display)) {
         return false;
     }
     
-    memset(display->frame_buffer, 0, WEACT_MAX_BUFFER_SIZE);
-    memset(display->back_buffer, 0, WEACT_MAX_BUFFER_SIZE);
-    
-    /* Initialize display state */
-    display->is_connected = true;
-    display->orientation = WEACT_LANDSCAPE;
-    display->brightness = 255;
-    display->display_width = WEACT_DISPLAY_WIDTH;
-    display->display_height = WEACT_DISPLAY_HEIGHT;
-    display->last_error[0] = '\0';
-    
     /* Set initial orientation */
     weact_set_orientation(display, WEACT_LANDSCAPE);
     usleep(500000); /* 500ms delay */
@@ -137,11 +366,32 @@ bool weact_init(weact_display_t *display, const char *port_name) {
     return true;
 }
 
+/* Initialize without a panel: everything sent is discarded */
+bool weact_init_null(weact_display_t *display) {
+    if (!display) {
+        return false;
+    }
+    
+    memset(display, 0, sizeof(weact_display_t));
+    strncpy(display->port_name, "/dev/null", sizeof(display->port_name) - 1);
+    
+    display->fd = open("/dev/null", O_WRONLY);
+    if (display->fd < 0) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Failed to open /dev/null: %s", strerror(errno));
+        return false;
+    }
+    
+    return init_state(display);
+}
+
 /* Close display connection */
 void weact_close(weact_display_t *display) {
     if (!display) return;
     
     if (display->is_connected && display->fd >= 0) {
+        /* Finish sending what is queued */
+        weact_set_nonblocking(display, false);
         close(display->fd);
         display->fd = -1;
         display->is_connected = false;
@@ -156,6 +406,16 @@ void weact_close(weact_display_t *display) {
         free(display->back_buffer);
         display->back_buffer = NULL;
     }
+    
+    free(display->tx_queue);
+    display->tx_queue = NULL;
+    display->tx_head = display->tx_tail = display->tx_capacity = 0;
+    
+    free(display->index_buffer);
+    free(display->index_lut);
+    display->index_buffer = NULL;
+    display->index_lut = NULL;
+    display->index_bpp = 0;
 }
 
 /* Cleanup all resources */
@@ -167,6 +427,18 @@ void weact_cleanup(weact_display_t *display) {
 void weact_clear_buffer(weact_display_t *display, uint16_t color) {
     if (!display || !display->back_buffer) return;
     
+    if (display->index_bpp) {
+        /* Replicate index across a byte */
+        int bpp = display->index_bpp;
+        uint8_t pattern = 0;
+        for (int bit = 0; bit < 8; bit += bpp) {
+            pattern = (uint8_t)((pattern << bpp) | (color & ((1 << bpp) - 1)));
+        }
+        memset(display->index_buffer, pattern,
+               (size_t)display->index_stride * display->display_height);
+        return;
+    }
+    
     uint8_t color_l = color >> 8;
     uint8_t color_h = color & 0xFF;
     
@@ -192,6 +464,14 @@ bool weact_flush_buffer(weact_display_t *display) {
         return false;
     }
     
+    /* Indexed mode: expand the whole frame before sending */
+    if (display->index_bpp) {
+        for (int row = 0; row < display->display_height; row++) {
+            expand_index_row(display, row, 0, display->display_width,
+                             display->back_buffer + row * display->display_width * 2);
+        }
+    }
+    
     /* Prepare SET_BITMAP command (0x05) */
     uint8_t cmd[10];
     cmd[0] = 0x05;  /* SET_BITMAP command */
@@ -218,25 +498,15 @@ bool weact_flush_buffer(weact_display_t *display) {
         return false;
     }
     
-    usleep(10000); /* 10ms delay */
+    if (!display->nonblocking) usleep(10000); /* 10ms delay */
     
     /* Send image data */
     size_t bytes_to_send = display->display_width * display->display_height * 2;
-    ssize_t written = write(display->fd, display->back_buffer, bytes_to_send);
-    
-    if (written < 0) {
-        snprintf(display->last_error, sizeof(display->last_error),
-                 "Failed to send image data: %s", strerror(errno));
+    if (!write_all(display, display->back_buffer, bytes_to_send)) {
         return false;
     }
     
-    if ((size_t)written != bytes_to_send) {
-        snprintf(display->last_error, sizeof(display->last_error),
-                 "Incomplete image data write: %zd of %zu bytes", written, bytes_to_send);
-        return false;
-    }
-    
-    usleep(10000); /* 10ms delay */
+    if (!display->nonblocking) usleep(10000); /* 10ms delay */
     return true;
 }
 
@@ -249,6 +519,187 @@ bool weact_update_display(weact_display_t *display) {
     return false;
 }
 
+/* Send raw pixel data (display byte order) for a rectangle */
+bool weact_send_bitmap(weact_display_t *display, int x, int y, int width, int height,
+                       const uint8_t *data) {
+    if (!display || !data || !display->is_connected) {
+        return false;
+    }
+    
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 ||
+        x + width > display->display_width || y + height > display->display_height) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Bitmap region %dx%d at %d,%d outside display", width, height, x, y);
+        return false;
+    }
+    
+    /* SET_BITMAP command (0x05) followed directly by the pixel data.
+     * Pacing comes from tcdrain() instead of fixed sleeps so that
+     * back-to-back regions go out as fast as the link allows; in
+     * non-blocking mode the data is queued and nothing waits. */
+    uint8_t cmd[10];
+    cmd[0] = 0x05;
+    encode_rect(cmd, x, y, width, height);
+    cmd[9] = 0x0A;
+    
+    if (!write_all(display, cmd, sizeof(cmd)) ||
+        !write_all(display, data, (size_t)width * height * 2)) {
+        return false;
+    }
+    
+    if (!display->nonblocking) tcdrain(display->fd);
+    return true;
+}
+
+/* Flush a rectangle of the back buffer (no buffer swap) */
+bool weact_flush_region(weact_display_t *display, int x, int y, int width, int height) {
+    if (!display || !display->back_buffer || !display->is_connected) {
+        return false;
+    }
+    
+    if (!clip_rect(display, &x, &y, &width, &height)) {
+        return true;  /* Nothing to send */
+    }
+    
+    int stride = display->display_width * 2;
+    size_t row_bytes = (size_t)width * 2;
+    const uint8_t *src = display->back_buffer + y * stride + x * 2;
+    bool ok;
+    
+    uint8_t packed[WEACT_MAX_BUFFER_SIZE];
+    
+    if (display->index_bpp) {
+        /* Expand only the rows and columns being sent */
+        for (int row = 0; row < height; row++) {
+            expand_index_row(display, y + row, x, width, packed + row * row_bytes);
+        }
+        src = packed;
+        stride = (int)row_bytes;
+    }
+    
+    if (width == display->display_width || src == packed) {
+        /* Rows are already contiguous */
+        ok = weact_send_bitmap(display, x, y, width, height, src);
+    } else {
+        for (int row = 0; row < height; row++) {
+            memcpy(packed + row * row_bytes, src + row * stride, row_bytes);
+        }
+        ok = weact_send_bitmap(display, x, y, width, height, packed);
+    }
+    
+    if (ok && display->frame_buffer) {
+        /* Keep front buffer mirroring what is on the panel */
+        int fb_stride = display->display_width * 2;
+        for (int row = 0; row < height; row++) {
+            memcpy(display->frame_buffer + (y + row) * fb_stride + x * 2,
+                   src + row * stride, row_bytes);
+        }
+    }
+    
+    return ok;
+}
+
+/* Fill rectangle on the panel directly (FULL command) */
+bool weact_fill_rect(weact_display_t *display, int x, int y, int width, int height,
+                     uint16_t color) {
+    if (!display || !display->is_connected) {
+        if (display) {
+            snprintf(display->last_error, sizeof(display->last_error),
+                     "Display not connected");
+        }
+        return false;
+    }
+    
+    if (!clip_rect(display, &x, &y, &width, &height)) {
+        return true;
+    }
+    
+    /* Send FULL command (0x04) */
+    uint8_t cmd[12];
+    cmd[0] = 0x04;
+    encode_rect(cmd, x, y, width, height);
+    
+    /* Color in RGB565 format */
+    cmd[9] = color & 0xFF;
+    cmd[10] = (color >> 8) & 0xFF;
+    
+    cmd[11] = 0x0A;  /* Terminator */
+    
+    if (!write_all(display, cmd, sizeof(cmd))) {
+        return false;
+    }
+    
+    if (display->frame_buffer) {
+        int stride = display->display_width * 2;
+        for (int row = y; row < y + height; row++) {
+            uint8_t *dst = display->frame_buffer + row * stride + x * 2;
+            for (int col = 0; col < width; col++) {
+                dst[col * 2] = color >> 8;
+                dst[col * 2 + 1] = color & 0xFF;
+            }
+        }
+    }
+    
+    if (!display->nonblocking) tcdrain(display->fd);
+    return true;
+}
+
+/* Switch between blocking writes and the non-blocking output queue */
+bool weact_set_nonblocking(weact_display_t *display, bool enable) {
+    if (!display || !display->is_connected) {
+        return false;
+    }
+    
+    int flags = fcntl(display->fd, F_GETFL);
+    if (flags < 0 ||
+        fcntl(display->fd, F_SETFL, enable ? flags | O_NONBLOCK : flags & ~O_NONBLOCK) < 0) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Failed to set port mode: %s", strerror(errno));
+        return false;
+    }
+    
+    display->nonblocking = enable;
+    if (enable) return true;
+    
+    /* Back to blocking: send the rest of the queue now */
+    size_t head = display->tx_head;
+    size_t pending = display->tx_tail - head;
+    display->tx_head = display->tx_tail = 0;
+    if (pending && !write_all(display, display->tx_queue + head, pending)) {
+        return false;
+    }
+    tcdrain(display->fd);
+    return true;
+}
+
+/* Bytes waiting in the output queue */
+size_t weact_pending_bytes(const weact_display_t *display) {
+    return display ? display->tx_tail - display->tx_head : 0;
+}
+
+/* Send queued bytes until the port would block */
+bool weact_write_pending(weact_display_t *display) {
+    if (!display || !display->is_connected) {
+        return false;
+    }
+    
+    while (display->tx_head < display->tx_tail) {
+        ssize_t written = write(display->fd, display->tx_queue + display->tx_head,
+                                display->tx_tail - display->tx_head);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            snprintf(display->last_error, sizeof(display->last_error),
+                     "Write error: %s", strerror(errno));
+            return false;
+        }
+        display->tx_head += (size_t)written;
+    }
+    
+    display->tx_head = display->tx_tail = 0;
+    return true;
+}
+
 /* Draw pixel in back buffer */
 void weact_draw_pixel(weact_display_t *display, int x, int y, uint16_t color) {
     if (!display || !display->back_buffer) return;
@@ -257,11 +708,53 @@ void weact_draw_pixel(weact_display_t *display, int x, int y, uint16_t color) {
         return;
     }
     
+    if (display->index_bpp) {
+        int bpp = display->index_bpp;
+        int bit = x * bpp;
+        int shift = 8 - bpp - (bit & 7);
+        uint8_t mask = (uint8_t)(((1 << bpp) - 1) << shift);
+        uint8_t *p = display->index_buffer + y * display->index_stride + (bit >> 3);
+        *p = (uint8_t)((*p & ~mask) | ((color << shift) & mask));
+        return;
+    }
+    
     int offset = (y * display->display_width + x) * 2;
     display->back_buffer[offset] = color >> 8;
     display->back_buffer[offset + 1] = color & 0xFF;
 }
 
+/* Draw horizontal span in back buffer (clipped once per span) */
+void weact_draw_hline(weact_display_t *display, int x, int y, int width, uint16_t color) {
+    if (!display || !display->back_buffer) return;
+    if (y < 0 || y >= display->display_height) return;
+    
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (x + width > display->display_width) width = display->display_width - x;
+    if (width <= 0) return;
+    
+    if (display->index_bpp) {
+        int bpp = display->index_bpp;
+        uint8_t *row = display->index_buffer + y * display->index_stride;
+        for (int bit = x * bpp; bit < (x + width) * bpp; bit += bpp) {
+            int shift = 8 - bpp - (bit & 7);
+            uint8_t mask = (uint8_t)(((1 << bpp) - 1) << shift);
+            row[bit >> 3] = (uint8_t)((row[bit >> 3] & ~mask) | ((color << shift) & mask));
+        }
+        return;
+    }
+    
+    uint8_t color_l = color >> 8;
+    uint8_t color_h = color & 0xFF;
+    uint8_t *p = display->back_buffer + (y * display->display_width + x) * 2;
+    for (int i = 0; i < width; i++) {
+        p[i * 2] = color_l;
+        p[i * 2 + 1] = color_h;
+    }
+}
+
 /* Draw line (Bresenham's algorithm) */
 void weact_draw_line(weact_display_t *display, int x1, int y1, int x2, int y2, uint16_t color) {
     int dx = abs(x2 - x1);
@@ -292,13 +785,7 @@ void weact_draw_rect(weact_display_t *display, int x, int y, int width, int heig
                      uint16_t color, bool filled) {
     if (filled) {
         for (int yy = y; yy < y + height; yy++) {
-            if (yy >= 0 && yy < display->display_height) {
-                for (int xx = x; xx < x + width; xx++) {
-                    if (xx >= 0 && xx < display->display_width) {
-                        weact_draw_pixel(display, xx, yy, color);
-                    }
-                }
-            }
+            weact_draw_hline(display, x, yy, width, color);
         }
     } else {
         /* Top and bottom edges */
@@ -406,9 +893,72 @@ bool weact_set_orientation(weact_display_t *display, weact_orientation_t orienta
         memset(display->back_buffer, 0, WEACT_MAX_BUFFER_SIZE);
     }
     
+    if (display->index_bpp) {
+        display->index_stride = (new_width * display->index_bpp + 7) / 8;
+        memset(display->index_buffer, 0, (size_t)display->index_stride * new_height);
+    }
+    
     return true;
 }
 
+/* Enable (bpp 1/2/4/8) or disable (bpp 0) indexed colour mode */
+bool weact_set_indexed_mode(weact_display_t *display, int bpp) {
+    if (!display) return false;
+    
+    if (bpp != 0 && bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Invalid index depth %d. Use 1, 2, 4 or 8 (0 = off)", bpp);
+        return false;
+    }
+    
+    free(display->index_buffer);
+    free(display->index_lut);
+    display->index_buffer = NULL;
+    display->index_lut = NULL;
+    display->index_bpp = 0;
+    
+    if (bpp == 0) return true;
+    
+    /* Sized for either orientation */
+    int max_dim = WEACT_DISPLAY_WIDTH > WEACT_DISPLAY_HEIGHT ?
+                  WEACT_DISPLAY_WIDTH : WEACT_DISPLAY_HEIGHT;
+    size_t buffer_size = (size_t)((max_dim * bpp + 7) / 8) * max_dim;
+    size_t lut_size = (bpp == 8) ? 512 : 256 * (size_t)(8 / bpp) * 2;
+    
+    display->index_buffer = calloc(1, buffer_size);
+    display->index_lut = malloc(lut_size);
+    if (!display->index_buffer || !display->index_lut) {
+        free(display->index_buffer);
+        free(display->index_lut);
+        display->index_buffer = NULL;
+        display->index_lut = NULL;
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Failed to allocate index buffer");
+        return false;
+    }
+    
+    display->index_bpp = bpp;
+    display->index_stride = (display->display_width * bpp + 7) / 8;
+    
+    memset(display->palette, 0, sizeof(display->palette));
+    weact_set_palette(display, default_palette, 8);
+    return true;
+}
+
+/* Set palette entries starting at index 0 */
+void weact_set_palette(weact_display_t *display, const uint16_t *colors, int count) {
+    if (!display || !colors) return;
+    
+    if (count > 256) count = 256;
+    for (int i = 0; i < count; i++) {
+        display->palette[i] = colors[i];
+    }
+    
+    if (display->index_bpp) {
+        build_index_lut(display);
+    }
+}
+
 /* Set brightness */
 bool weact_set_brightness(weact_display_t *display, uint8_t brightness, uint16_t time_ms) {
     if (!display) return false;
@@ -51,6 +51,14 @@ typedef enum {
 #define WEACT_CYAN    0xF81F  /* BRG: 11111 00000 111111 */
 #define WEACT_MAGENTA 0xFFE0  /* BRG: 11111 11111 000000 */
 
+/* Rectangle (used for partial updates and damage tracking) */
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} weact_rect_t;
+
 /* Display Structure */
 typedef struct {
     int fd;                      /* Serial port file descriptor */
@@ -63,6 +71,20 @@ typedef struct {
     uint8_t *frame_buffer;       /* Frame buffer */
     uint8_t *back_buffer;        /* Back buffer (double buffering) */
     char last_error[512];        /* Last error message */
+    
+    /* Indexed colour mode (index_bpp == 0: direct BRG565 drawing) */
+    int index_bpp;               /* Bits per pixel: 0, 1, 2, 4 or 8 */
+    int index_stride;            /* Bytes per index buffer row */
+    uint8_t *index_buffer;       /* Palette indices, MSB-first packing */
+    uint8_t *index_lut;          /* Packed index byte -> BRG565 pixels */
+    uint16_t palette[256];       /* Palette colours (BRG565) */
+    
+    /* Non-blocking output: bytes the port has not taken yet */
+    bool nonblocking;            /* Writes queue instead of waiting */
+    uint8_t *tx_queue;
+    size_t tx_head;              /* Next byte to send */
+    size_t tx_tail;              /* End of queued data */
+    size_t tx_capacity;
 } weact_display_t;
 
 /* Color Conversion */
@@ -70,6 +92,7 @@ uint16_t weact_rgb_to_brg565(uint8_t r, uint8_t g, uint8_t b);
 
 /* Initialization and Cleanup */
 bool weact_init(weact_display_t *display, const char *port_name);
+bool weact_init_null(weact_display_t *display);  /* No panel: output discarded (benchmarks) */
 void weact_close(weact_display_t *display);
 void weact_cleanup(weact_display_t *display);
 
@@ -79,8 +102,32 @@ void weact_swap_buffers(weact_display_t *display);
 bool weact_flush_buffer(weact_display_t *display);
 bool weact_update_display(weact_display_t *display);
 
+/* Partial Updates */
+bool weact_flush_region(weact_display_t *display, int x, int y, int width, int height);
+bool weact_send_bitmap(weact_display_t *display, int x, int y, int width, int height,
+                       const uint8_t *data);
+bool weact_fill_rect(weact_display_t *display, int x, int y, int width, int height,
+                     uint16_t color);
+
+/* Non-blocking Output
+ * With non-blocking mode on, commands and pixel data go out as far as the
+ * port takes them and the rest is queued in order; nothing sleeps or
+ * waits for the link. Poll the fd for writability while
+ * weact_pending_bytes() is non-zero and call weact_write_pending(). */
+bool weact_set_nonblocking(weact_display_t *display, bool enable);
+size_t weact_pending_bytes(const weact_display_t *display);
+bool weact_write_pending(weact_display_t *display);
+
+/* Indexed Colour Mode
+ * In indexed mode the drawing functions below take a palette index
+ * instead of a BRG565 colour. Pixels are expanded to BRG565 only for
+ * the regions that are transmitted. */
+bool weact_set_indexed_mode(weact_display_t *display, int bpp);
+void weact_set_palette(weact_display_t *display, const uint16_t *colors, int count);
+
 /* Drawing Functions */
 void weact_draw_pixel(weact_display_t *display, int x, int y, uint16_t color);
+void weact_draw_hline(weact_display_t *display, int x, int y, int width, uint16_t color);
 void weact_draw_line(weact_display_t *display, int x1, int y1, int x2, int y2, uint16_t color);
 void weact_draw_rect(weact_display_t *display, int x, int y, int width, int height, uint16_t color, bool filled);
 void weact_draw_circle(weact_display_t *display, int cx, int cy, int radius, uint16_t color, bool filled);
@@ -0,0 +1,788 @@
+/**
+ * Image Loader Implementation
+ * Streaming PPM/PGM/BMP decoder with scaling and BRG565 dithering
+ */
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "weact_image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+
+/* Largest source dimension we accept (guards against corrupt headers) */
+#define IMAGE_MAX_DIMENSION 32768
+
+typedef enum {
+    IMAGE_FORMAT_PNM = 0,
+    IMAGE_FORMAT_BMP
+} image_format_t;
+
+/* Streaming reader state */
+struct weact_image_reader {
+    FILE *fp;
+    image_format_t format;
+    int width;
+    int height;
+    int next_row;               /* Next row to be returned (top-down) */
+    uint8_t *raw;               /* One raw file row */
+    size_t raw_size;
+
+    /* PNM */
+    int channels;               /* 1 (PGM) or 3 (PPM) */
+    int maxval;
+    bool plain;                 /* ASCII P2/P3 */
+    uint8_t sample_lut[256];    /* maxval <= 255 -> 8-bit */
+
+    /* BMP */
+    long data_offset;
+    int bpp;
+    bool bottom_up;
+    uint32_t masks[3];          /* R, G, B bitfields */
+    int mask_shift[3];
+    uint32_t mask_max[3];
+    uint8_t palette[256][3];    /* RGB */
+};
+
+/* Row consumer used by the pipeline */
+typedef void (*row_sink_fn)(void *user, int row, const uint16_t *pixels, int width);
+
+/* Precomputed dithering tables */
+static bool luts_ready = false;
+static uint8_t ordered_lut5[16][256];
+static uint8_t ordered_lut6[16][256];
+static uint8_t quant5[768];            /* Indexed by value + 256 */
+static uint8_t quant6[768];
+static uint8_t expand5[32];
+static uint8_t expand6[64];
+
+static const uint8_t bayer4[16] = {
+     0,  8,  2, 10,
+    12,  4, 14,  6,
+     3, 11,  1,  9,
+    15,  7, 13,  5
+};
+
+static void set_error(char *error, size_t error_size, const char *fmt, ...) {
+    if (error && error_size > 0) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(error, error_size, fmt, args);
+        va_end(args);
+    }
+}
+
+/* Build dithering LUTs once */
+static void init_luts(void) {
+    if (luts_ready) return;
+
+    for (int t = 0; t < 16; t++) {
+        /* Threshold offset in (-0.5, 0.5) of one quantization step */
+        float offset = (bayer4[t] + 0.5f) / 16.0f - 0.5f;
+        for (int v = 0; v < 256; v++) {
+            int q5 = (int)(v * 31 / 255.0f + offset + 0.5f);
+            int q6 = (int)(v * 63 / 255.0f + offset + 0.5f);
+            ordered_lut5[t][v] = q5 < 0 ? 0 : (q5 > 31 ? 31 : q5);
+            ordered_lut6[t][v] = q6 < 0 ? 0 : (q6 > 63 ? 63 : q6);
+        }
+    }
+
+    for (int i = 0; i < 768; i++) {
+        int v = i - 256;
+        if (v < 0) v = 0;
+        if (v > 255) v = 255;
+        quant5[i] = (v * 31 + 127) / 255;
+        quant6[i] = (v * 63 + 127) / 255;
+    }
+    for (int i = 0; i < 32; i++) expand5[i] = (i * 255 + 15) / 31;
+    for (int i = 0; i < 64; i++) expand6[i] = (i * 255 + 31) / 63;
+
+    luts_ready = true;
+}
+
+/* ===== PNM ===== */
+
+/* Read next whitespace-separated token, skipping '#' comments */
+static bool pnm_read_int(FILE *fp, int *value) {
+    int c = fgetc(fp);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fgetc(fp);
+        } else if (!isspace(c)) {
+            break;
+        }
+        c = fgetc(fp);
+    }
+    if (c == EOF || !isdigit(c)) return false;
+
+    long v = 0;
+    while (c != EOF && isdigit(c)) {
+        v = v * 10 + (c - '0');
+        if (v > 1000000) return false;
+        c = fgetc(fp);
+    }
+    /* Exactly one whitespace character terminates the header */
+    if (c != EOF && !isspace(c)) ungetc(c, fp);
+
+    *value = (int)v;
+    return true;
+}
+
+static bool pnm_open(weact_image_reader_t *r, int magic, char *error, size_t error_size) {
+    r->format = IMAGE_FORMAT_PNM;
+    r->plain = (magic == '2' || magic == '3');
+    r->channels = (magic == '3' || magic == '6') ? 3 : 1;
+
+    if (!pnm_read_int(r->fp, &r->width) || !pnm_read_int(r->fp, &r->height) ||
+        !pnm_read_int(r->fp, &r->maxval)) {
+        set_error(error, error_size, "Malformed PNM header");
+        return false;
+    }
+
+    if (r->maxval < 1 || r->maxval > 65535) {
+        set_error(error, error_size, "Unsupported PNM maxval");
+        return false;
+    }
+
+    if (r->maxval <= 255) {
+        for (int i = 0; i <= r->maxval; i++) {
+            r->sample_lut[i] = (uint8_t)((i * 255 + r->maxval / 2) / r->maxval);
+        }
+    }
+
+    int bytes_per_sample = (r->maxval > 255) ? 2 : 1;
+    r->raw_size = (size_t)r->width * r->channels * bytes_per_sample;
+    return true;
+}
+
+static bool pnm_read_row(weact_image_reader_t *r, uint8_t *rgb) {
+    int samples = r->width * r->channels;
+
+    if (r->plain) {
+        for (int i = 0; i < samples; i++) {
+            int v;
+            if (!pnm_read_int(r->fp, &v)) return false;
+            if (v > r->maxval) v = r->maxval;
+            r->raw[i] = (r->maxval <= 255) ? r->sample_lut[v]
+                                           : (uint8_t)((v * 255 + r->maxval / 2) / r->maxval);
+        }
+    } else {
+        if (fread(r->raw, 1, r->raw_size, r->fp) != r->raw_size) return false;
+
+        if (r->maxval > 255) {
+            for (int i = 0; i < samples; i++) {
+                uint32_t v = ((uint32_t)r->raw[i * 2] << 8) | r->raw[i * 2 + 1];
+                if (v > (uint32_t)r->maxval) v = r->maxval;
+                r->raw[i] = (uint8_t)((v * 255 + r->maxval / 2) / r->maxval);
+            }
+        } else if (r->maxval != 255) {
+            for (int i = 0; i < samples; i++) {
+                int v = r->raw[i];
+                r->raw[i] = r->sample_lut[v > r->maxval ? r->maxval : v];
+            }
+        }
+    }
+
+    if (r->channels == 3) {
+        memcpy(rgb, r->raw, (size_t)samples);
+    } else {
+        for (int x = 0; x < r->width; x++) {
+            rgb[x * 3] = rgb[x * 3 + 1] = rgb[x * 3 + 2] = r->raw[x];
+        }
+    }
+    return true;
+}
+
+/* ===== BMP ===== */
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static bool bmp_open(weact_image_reader_t *r, char *error, size_t error_size) {
+    uint8_t header[14 + 124];
+
+    r->format = IMAGE_FORMAT_BMP;
+
+    /* Magic "BM" has already been consumed */
+    if (fread(header + 2, 1, 16, r->fp) != 16) {
+        set_error(error, error_size, "Truncated BMP header");
+        return false;
+    }
+
+    r->data_offset = (long)read_le32(header + 10);
+    uint32_t dib_size = read_le32(header + 14);
+    if (dib_size != 40 && dib_size != 52 && dib_size != 56 &&
+        dib_size != 108 && dib_size != 124) {
+        set_error(error, error_size, "Unsupported BMP header version");
+        return false;
+    }
+
+    if (fread(header + 18, 1, dib_size - 4, r->fp) != dib_size - 4) {
+        set_error(error, error_size, "Truncated BMP header");
+        return false;
+    }
+
+    int32_t width = (int32_t)read_le32(header + 18);
+    int32_t height = (int32_t)read_le32(header + 22);
+    uint16_t planes = read_le16(header + 26);
+    uint32_t compression = read_le32(header + 30);
+    uint32_t colors_used = read_le32(header + 46);
+
+    r->bpp = read_le16(header + 28);
+    r->bottom_up = height > 0;
+    r->width = width;
+    r->height = height < 0 ? -height : height;
+
+    if (planes != 1 || (compression != 0 && compression != 3)) {
+        set_error(error, error_size, "Compressed BMP files are not supported");
+        return false;
+    }
+
+    switch (r->bpp) {
+        case 1: case 4: case 8: case 24:
+            if (compression != 0) {
+                set_error(error, error_size, "Invalid BMP bitfields");
+                return false;
+            }
+            break;
+        case 16:
+            r->masks[0] = 0x7C00;
+            r->masks[1] = 0x03E0;
+            r->masks[2] = 0x001F;
+            break;
+        case 32:
+            r->masks[0] = 0x00FF0000;
+            r->masks[1] = 0x0000FF00;
+            r->masks[2] = 0x000000FF;
+            break;
+        default:
+            set_error(error, error_size, "Unsupported BMP bit depth");
+            return false;
+    }
+
+    if (compression == 3) {
+        if (dib_size >= 52) {
+            for (int c = 0; c < 3; c++) r->masks[c] = read_le32(header + 54 + c * 4);
+        } else {
+            uint8_t masks[12];
+            if (fread(masks, 1, 12, r->fp) != 12) {
+                set_error(error, error_size, "Truncated BMP bitfields");
+                return false;
+            }
+            for (int c = 0; c < 3; c++) r->masks[c] = read_le32(masks + c * 4);
+        }
+    }
+
+    for (int c = 0; c < 3; c++) {
+        uint32_t m = r->masks[c];
+        int shift = 0;
+        if (m == 0 && (r->bpp == 16 || r->bpp == 32)) {
+            set_error(error, error_size, "Invalid BMP bitfields");
+            return false;
+        }
+        while (m && !(m & 1)) {
+            m >>= 1;
+            shift++;
+        }
+        r->mask_shift[c] = shift;
+        r->mask_max[c] = m;
+    }
+
+    /* Palette follows the headers */
+    if (r->bpp <= 8) {
+        uint32_t count = colors_used ? colors_used : (1u << r->bpp);
+        if (count > 256) count = 256;
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t bgra[4];
+            if (fread(bgra, 1, 4, r->fp) != 4) {
+                set_error(error, error_size, "Truncated BMP palette");
+                return false;
+            }
+            r->palette[i][0] = bgra[2];
+            r->palette[i][1] = bgra[1];
+            r->palette[i][2] = bgra[0];
+        }
+    }
+
+    r->raw_size = (((size_t)r->width * r->bpp + 31) / 32) * 4;
+    return true;
+}
+
+static bool bmp_read_row(weact_image_reader_t *r, uint8_t *rgb) {
+    int file_row = r->bottom_up ? (r->height - 1 - r->next_row) : r->next_row;
+    long offset = r->data_offset + (long)file_row * (long)r->raw_size;
+
+    if (fseek(r->fp, offset, SEEK_SET) != 0) return false;
+    if (fread(r->raw, 1, r->raw_size, r->fp) != r->raw_size) return false;
+
+    const uint8_t *src = r->raw;
+
+    switch (r->bpp) {
+        case 1: case 4: case 8: {
+            int per_byte = 8 / r->bpp;
+            int mask = (1 << r->bpp) - 1;
+            for (int x = 0; x < r->width; x++) {
+                int shift = (per_byte - 1 - (x % per_byte)) * r->bpp;
+                int index = (src[x / per_byte] >> shift) & mask;
+                memcpy(rgb + x * 3, r->palette[index], 3);
+            }
+            break;
+        }
+        case 24:
+            for (int x = 0; x < r->width; x++) {
+                rgb[x * 3] = src[x * 3 + 2];
+                rgb[x * 3 + 1] = src[x * 3 + 1];
+                rgb[x * 3 + 2] = src[x * 3];
+            }
+            break;
+        case 16: case 32: {
+            int bytes = r->bpp / 8;
+            for (int x = 0; x < r->width; x++) {
+                uint32_t px = (bytes == 2) ? read_le16(src + x * 2) : read_le32(src + x * 4);
+                for (int c = 0; c < 3; c++) {
+                    uint32_t v = (px & r->masks[c]) >> r->mask_shift[c];
+                    rgb[x * 3 + c] = (uint8_t)((v * 255 + r->mask_max[c] / 2) / r->mask_max[c]);
+                }
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+/* ===== Reader API ===== */
+
+weact_image_reader_t* weact_image_open(const char *path, char *error, size_t error_size) {
+    if (!path) return NULL;
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        set_error(error, error_size, "Cannot open image %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    weact_image_reader_t *r = calloc(1, sizeof(weact_image_reader_t));
+    if (!r) {
+        fclose(fp);
+        set_error(error, error_size, "Out of memory");
+        return NULL;
+    }
+    r->fp = fp;
+
+    uint8_t magic[2];
+    bool ok = false;
+
+    if (fread(magic, 1, 2, fp) == 2) {
+        if (magic[0] == 'P' && magic[1] >= '2' && magic[1] <= '6' && magic[1] != '4') {
+            ok = pnm_open(r, magic[1], error, error_size);
+        } else if (magic[0] == 'B' && magic[1] == 'M') {
+            ok = bmp_open(r, error, error_size);
+        } else {
+            set_error(error, error_size, "Unknown image format: %s", path);
+        }
+    } else {
+        set_error(error, error_size, "Empty image file: %s", path);
+    }
+
+    if (ok && (r->width <= 0 || r->height <= 0 ||
+               r->width > IMAGE_MAX_DIMENSION || r->height > IMAGE_MAX_DIMENSION)) {
+        set_error(error, error_size, "Invalid image dimensions");
+        ok = false;
+    }
+
+    if (ok) {
+        r->raw = malloc(r->raw_size);
+        if (!r->raw) {
+            set_error(error, error_size, "Out of memory");
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        weact_image_close(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+void weact_image_get_size(const weact_image_reader_t *reader, int *width, int *height) {
+    if (width) *width = reader ? reader->width : 0;
+    if (height) *height = reader ? reader->height : 0;
+}
+
+bool weact_image_read_row(weact_image_reader_t *reader, uint8_t *rgb) {
+    if (!reader || !rgb || reader->next_row >= reader->height) return false;
+
+    bool ok = (reader->format == IMAGE_FORMAT_PNM) ? pnm_read_row(reader, rgb)
+                                                   : bmp_read_row(reader, rgb);
+    if (ok) reader->next_row++;
+    return ok;
+}
+
+void weact_image_close(weact_image_reader_t *reader) {
+    if (!reader) return;
+    if (reader->fp) fclose(reader->fp);
+    free(reader->raw);
+    free(reader);
+}
+
+void weact_image_default_options(weact_image_options_t *opts) {
+    if (!opts) return;
+    opts->filter = WEACT_SCALE_BOX;
+    opts->dither = WEACT_DITHER_ORDERED;
+    opts->keep_aspect = true;
+}
+
+/* ===== Scaling and dithering pipeline ===== */
+
+/* Quantize one scaled RGB888 row to BRG565 */
+static void dither_row(const weact_image_options_t *opts, const uint8_t *rgb,
+                       uint16_t *out, int width, int row,
+                       int16_t *err_cur, int16_t *err_next) {
+    switch (opts->dither) {
+        case WEACT_DITHER_ORDERED: {
+            const uint8_t *bayer_row = &bayer4[(row & 3) * 4];
+            for (int x = 0; x < width; x++) {
+                int t = bayer_row[x & 3];
+                const uint8_t *p = rgb + x * 3;
+                out[x] = (uint16_t)((ordered_lut5[t][p[2]] << 11) |
+                                    (ordered_lut5[t][p[0]] << 6) |
+                                    ordered_lut6[t][p[1]]);
+            }
+            break;
+        }
+        case WEACT_DITHER_FLOYD_STEINBERG: {
+            /* Errors are stored x16 with one guard pixel on each side */
+            memset(err_next, 0, (size_t)(width + 2) * 3 * sizeof(int16_t));
+            bool reverse = row & 1;
+            int step = reverse ? -1 : 1;
+            int x = reverse ? width - 1 : 0;
+
+            for (int n = 0; n < width; n++, x += step) {
+                const uint8_t *p = rgb + x * 3;
+                int16_t *ec = err_cur + (x + 1) * 3;
+                int16_t *en = err_next + (x + 1) * 3;
+                uint8_t level[3];
+
+                for (int c = 0; c < 3; c++) {
+                    int v = p[c] + ((ec[c] + 8) >> 4);
+                    if (v < -256) v = -256;
+                    if (v > 511) v = 511;
+                    int q, e;
+                    if (c == 1) {
+                        q = quant6[v + 256];
+                        e = v - expand6[q];
+                    } else {
+                        q = quant5[v + 256];
+                        e = v - expand5[q];
+                    }
+                    level[c] = (uint8_t)q;
+
+                    ec[c + step * 3] += (int16_t)(e * 7);
+                    en[c - step * 3] += (int16_t)(e * 3);
+                    en[c] += (int16_t)(e * 5);
+                    en[c + step * 3] += (int16_t)e;
+                }
+                out[x] = (uint16_t)((level[2] << 11) | (level[0] << 6) | level[1]);
+            }
+            break;
+        }
+        default:
+            for (int x = 0; x < width; x++) {
+                const uint8_t *p = rgb + x * 3;
+                out[x] = weact_rgb_to_brg565(p[0], p[1], p[2]);
+            }
+            break;
+    }
+}
+
+/* Stream source rows through the scaler and ditherer, emitting output rows */
+static bool run_pipeline(weact_image_reader_t *r, int dw, int dh,
+                         const weact_image_options_t *opts,
+                         row_sink_fn sink, void *user,
+                         char *error, size_t error_size) {
+    int sw = r->width;
+    int sh = r->height;
+    bool ok = true;
+
+    init_luts();
+
+    uint8_t *src_a = malloc((size_t)sw * 3);
+    uint8_t *src_b = malloc((size_t)sw * 3);
+    uint8_t *scaled = malloc((size_t)dw * 3);
+    uint16_t *out = malloc((size_t)dw * sizeof(uint16_t));
+    int *x0 = malloc((size_t)dw * sizeof(int));
+    int *x1 = malloc((size_t)dw * sizeof(int));
+    uint32_t *accum = calloc((size_t)dw * 3, sizeof(uint32_t));
+    uint32_t *hsum = calloc((size_t)dw * 3, sizeof(uint32_t));
+    int16_t *err_a = calloc((size_t)(dw + 2) * 3, sizeof(int16_t));
+    int16_t *err_b = calloc((size_t)(dw + 2) * 3, sizeof(int16_t));
+
+    if (!src_a || !src_b || !scaled || !out || !x0 || !x1 ||
+        !accum || !hsum || !err_a || !err_b) {
+        set_error(error, error_size, "Out of memory");
+        ok = false;
+        goto done;
+    }
+
+    if (opts->filter == WEACT_SCALE_BILINEAR) {
+        /* x0 = left source pixel, x1 = 8-bit weight of right neighbour */
+        for (int ox = 0; ox < dw; ox++) {
+            long fx = (long)(2 * ox + 1) * sw * 128 / dw - 128;
+            if (fx < 0) fx = 0;
+            x0[ox] = (int)(fx >> 8);
+            x1[ox] = (int)(fx & 0xFF);
+            if (x0[ox] >= sw - 1) {
+                x0[ox] = sw - 1;
+                x1[ox] = 0;
+            }
+        }
+
+        int row_a = -1, row_b = -1;     /* Source rows held in src_a/src_b */
+
+        for (int oy = 0; oy < dh && ok; oy++) {
+            long fy = (long)(2 * oy + 1) * sh * 128 / dh - 128;
+            if (fy < 0) fy = 0;
+            int y0 = (int)(fy >> 8);
+            int wy = (int)(fy & 0xFF);
+            if (y0 >= sh - 1) {
+                y0 = sh - 1;
+                wy = 0;
+            }
+            int y1 = (y0 + 1 < sh) ? y0 + 1 : y0;
+
+            /* Advance the two-row window */
+            while (row_b < y1) {
+                uint8_t *t = src_a;
+                src_a = src_b;
+                src_b = t;
+                row_a = row_b;
+                if (!weact_image_read_row(r, src_b)) {
+                    set_error(error, error_size, "Truncated image data");
+                    ok = false;
+                    break;
+                }
+                row_b++;
+            }
+            if (!ok) break;
+            const uint8_t *top = (row_a == y0) ? src_a : src_b;
+            const uint8_t *bot = src_b;
+
+            for (int ox = 0; ox < dw; ox++) {
+                int wx = x1[ox];
+                int xa = x0[ox] * 3;
+                int xb = (x0[ox] + 1 < sw ? x0[ox] + 1 : x0[ox]) * 3;
+                for (int c = 0; c < 3; c++) {
+                    int t = top[xa + c] * (256 - wx) + top[xb + c] * wx;
+                    int b = bot[xa + c] * (256 - wx) + bot[xb + c] * wx;
+                    scaled[ox * 3 + c] = (uint8_t)((t * (256 - wy) + b * wy + 32768) >> 16);
+                }
+            }
+
+            dither_row(opts, scaled, out, dw, oy, err_a, err_b);
+            int16_t *t = err_a;
+            err_a = err_b;
+            err_b = t;
+            sink(user, oy, out, dw);
+        }
+    } else {
+        /* Box filter: each output pixel averages its source footprint */
+        for (int ox = 0; ox < dw; ox++) {
+            x0[ox] = (int)((long)ox * sw / dw);
+            x1[ox] = (int)((long)(ox + 1) * sw / dw);
+            if (x1[ox] <= x0[ox]) x1[ox] = x0[ox] + 1;
+        }
+
+        int loaded = -1;            /* Source row reduced into hsum */
+
+        for (int oy = 0; oy < dh && ok; oy++) {
+            int y0 = (int)((long)oy * sh / dh);
+            int y1 = (int)((long)(oy + 1) * sh / dh);
+            if (y1 <= y0) y1 = y0 + 1;
+
+            memset(accum, 0, (size_t)dw * 3 * sizeof(uint32_t));
+
+            for (int sy = y0; sy < y1; sy++) {
+                /* Upscaling revisits the previous row - reuse its sums */
+                if (loaded != sy) {
+                    while (loaded < sy) {
+                        if (!weact_image_read_row(r, src_a)) {
+                            set_error(error, error_size, "Truncated image data");
+                            ok = false;
+                            break;
+                        }
+                        loaded++;
+                    }
+                    if (!ok) break;
+
+                    for (int ox = 0; ox < dw; ox++) {
+                        uint32_t s0 = 0, s1 = 0, s2 = 0;
+                        for (int sx = x0[ox]; sx < x1[ox]; sx++) {
+                            s0 += src_a[sx * 3];
+                            s1 += src_a[sx * 3 + 1];
+                            s2 += src_a[sx * 3 + 2];
+                        }
+                        hsum[ox * 3] = s0;
+                        hsum[ox * 3 + 1] = s1;
+                        hsum[ox * 3 + 2] = s2;
+                    }
+                }
+                for (int i = 0; i < dw * 3; i++) accum[i] += hsum[i];
+            }
+            if (!ok) break;
+
+            uint32_t rows = (uint32_t)(y1 - y0);
+            for (int ox = 0; ox < dw; ox++) {
+                uint32_t count = rows * (uint32_t)(x1[ox] - x0[ox]);
+                for (int c = 0; c < 3; c++) {
+                    scaled[ox * 3 + c] = (uint8_t)((accum[ox * 3 + c] + count / 2) / count);
+                }
+            }
+
+            dither_row(opts, scaled, out, dw, oy, err_a, err_b);
+            int16_t *t = err_a;
+            err_a = err_b;
+            err_b = t;
+            sink(user, oy, out, dw);
+        }
+    }
+
+done:
+    free(src_a);
+    free(src_b);
+    free(scaled);
+    free(out);
+    free(x0);
+    free(x1);
+    free(accum);
+    free(hsum);
+    free(err_a);
+    free(err_b);
+    return ok;
+}
+
+/* Fit source aspect ratio inside target rect */
+static void fit_rect(int sw, int sh, int *x, int *y, int *width, int *height) {
+    int w = *width;
+    int h = (int)((long)sh * w / sw);
+    if (h > *height) {
+        h = *height;
+        w = (int)((long)sw * h / sh);
+    }
+    if (w < 1) w = 1;
+    if (h < 1) h = 1;
+    *x += (*width - w) / 2;
+    *y += (*height - h) / 2;
+    *width = w;
+    *height = h;
+}
+
+/* Sink: BRG565 pixel array */
+typedef struct {
+    uint16_t *pixels;
+    int stride;
+    int x;
+    int y;
+} array_sink_t;
+
+static void array_sink(void *user, int row, const uint16_t *pixels, int width) {
+    array_sink_t *s = user;
+    memcpy(s->pixels + (size_t)(s->y + row) * s->stride + s->x, pixels,
+           (size_t)width * sizeof(uint16_t));
+}
+
+/* Sink: display back buffer with clipping */
+typedef struct {
+    weact_display_t *display;
+    int x;
+    int y;
+} display_sink_t;
+
+static void display_sink(void *user, int row, const uint16_t *pixels, int width) {
+    display_sink_t *s = user;
+    weact_display_t *d = s->display;
+    int py = s->y + row;
+
+    if (py < 0 || py >= d->display_height) return;
+
+    for (int i = 0; i < width; i++) {
+        int px = s->x + i;
+        if (px < 0 || px >= d->display_width) continue;
+        uint8_t *dst = d->back_buffer + (py * d->display_width + px) * 2;
+        dst[0] = pixels[i] >> 8;
+        dst[1] = pixels[i] & 0xFF;
+    }
+}
+
+bool weact_image_render(const char *path, uint16_t *pixels, int width, int height,
+                        const weact_image_options_t *opts,
+                        char *error, size_t error_size) {
+    if (!path || !pixels || width <= 0 || height <= 0) return false;
+
+    weact_image_options_t defaults;
+    if (!opts) {
+        weact_image_default_options(&defaults);
+        opts = &defaults;
+    }
+
+    weact_image_reader_t *r = weact_image_open(path, error, error_size);
+    if (!r) return false;
+
+    array_sink_t sink = { pixels, width, 0, 0 };
+    int w = width, h = height;
+
+    if (opts->keep_aspect) {
+        /* Letterbox area is black */
+        memset(pixels, 0, (size_t)width * height * sizeof(uint16_t));
+        fit_rect(r->width, r->height, &sink.x, &sink.y, &w, &h);
+    }
+
+    bool ok = run_pipeline(r, w, h, opts, array_sink, &sink, error, error_size);
+    weact_image_close(r);
+    return ok;
+}
+
+bool weact_image_draw(weact_display_t *display, const char *path,
+                      int x, int y, int width, int height,
+                      const weact_image_options_t *opts) {
+    if (!display || !display->back_buffer || !path) return false;
+
+    weact_image_options_t defaults;
+    if (!opts) {
+        weact_image_default_options(&defaults);
+        opts = &defaults;
+    }
+
+    if (display->index_bpp) {
+        snprintf(display->last_error, sizeof(display->last_error),
+                 "Image drawing requires direct colour mode");
+        return false;
+    }
+
+    if (width <= 0) width = display->display_width;
+    if (height <= 0) height = display->display_height;
+
+    weact_image_reader_t *r = weact_image_open(path, display->last_error,
+                                               sizeof(display->last_error));
+    if (!r) return false;
+
+    if (opts->keep_aspect) {
+        fit_rect(r->width, r->height, &x, &y, &width, &height);
+    }
+
+    display_sink_t sink = { display, x, y };
+    bool ok = run_pipeline(r, width, height, opts, display_sink, &sink,
+                           display->last_error, sizeof(display->last_error));
+    weact_image_close(r);
+    return ok;
+}
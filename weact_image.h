@@ -0,0 +1,103 @@
+/**
+ * Image Loader for WeAct Display
+ * Streaming PPM/PGM/BMP decoder with scaling and BRG565 dithering
+ *
+ * Images are processed one source row at a time, so even very large
+ * inputs (e.g. 4K camera frames) never have to be held in memory.
+ */
+
+#ifndef WEACT_IMAGE_H
+#define WEACT_IMAGE_H
+
+#include "weact_display.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Scaling filter */
+typedef enum {
+    WEACT_SCALE_BOX = 0,        /* Area average - best for downscaling */
+    WEACT_SCALE_BILINEAR        /* Bilinear - best for upscaling */
+} weact_scale_filter_t;
+
+/* Dithering mode used when reducing RGB888 to BRG565 */
+typedef enum {
+    WEACT_DITHER_NONE = 0,      /* Plain truncation */
+    WEACT_DITHER_ORDERED,       /* 4x4 Bayer matrix */
+    WEACT_DITHER_FLOYD_STEINBERG /* Serpentine error diffusion */
+} weact_dither_t;
+
+/* Image processing options */
+typedef struct {
+    weact_scale_filter_t filter;
+    weact_dither_t dither;
+    bool keep_aspect;           /* Fit inside target rect, centered */
+} weact_image_options_t;
+
+/* Streaming image reader */
+typedef struct weact_image_reader weact_image_reader_t;
+
+/**
+ * Open image file for streaming
+ * Supported: PPM/PGM (P2, P3, P5, P6, 8/16-bit), BMP (1/4/8/16/24/32-bit)
+ * @param path Image file path
+ * @param error Buffer for error message (may be NULL)
+ * @param error_size Size of error buffer
+ * @return Reader or NULL on error
+ */
+weact_image_reader_t* weact_image_open(const char *path, char *error, size_t error_size);
+
+/**
+ * Get source image dimensions
+ */
+void weact_image_get_size(const weact_image_reader_t *reader, int *width, int *height);
+
+/**
+ * Read next row (top to bottom) as packed RGB888
+ * @param reader Image reader
+ * @param rgb Output buffer, at least width * 3 bytes
+ * @return false on read error or after the last row
+ */
+bool weact_image_read_row(weact_image_reader_t *reader, uint8_t *rgb);
+
+/**
+ * Close image reader
+ */
+void weact_image_close(weact_image_reader_t *reader);
+
+/**
+ * Get default options (box filter, ordered dither, keep aspect)
+ */
+void weact_image_default_options(weact_image_options_t *opts);
+
+/**
+ * Decode, scale and dither image into a BRG565 pixel array
+ * @param path Image file path
+ * @param pixels Output array of width * height BRG565 values
+ * @param width Output width
+ * @param height Output height
+ * @param opts Options (NULL for defaults)
+ * @param error Buffer for error message (may be NULL)
+ * @param error_size Size of error buffer
+ * @return true on success
+ */
+bool weact_image_render(const char *path, uint16_t *pixels, int width, int height,
+                        const weact_image_options_t *opts,
+                        char *error, size_t error_size);
+
+/**
+ * Decode, scale and dither image into the display back buffer
+ * @param display WeAct display handle
+ * @param path Image file path
+ * @param x Target X coordinate
+ * @param y Target Y coordinate
+ * @param width Target width (0 = display width)
+ * @param height Target height (0 = display height)
+ * @param opts Options (NULL for defaults)
+ * @return true on success (error in display->last_error otherwise)
+ */
+bool weact_image_draw(weact_display_t *display, const char *path,
+                      int x, int y, int width, int height,
+                      const weact_image_options_t *opts);
+
+#endif /* WEACT_IMAGE_H */
@@ -0,0 +1,367 @@
+/**
+ * Offscreen Surfaces and Layered Compositor Implementation
+ */
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "weact_surface.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* ===== Rectangle helpers ===== */
+
+static bool rect_intersect(const weact_rect_t *a, const weact_rect_t *b, weact_rect_t *out) {
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = (a->x + a->width < b->x + b->width) ? a->x + a->width : b->x + b->width;
+    int y1 = (a->y + a->height < b->y + b->height) ? a->y + a->height : b->y + b->height;
+
+    if (x1 <= x0 || y1 <= y0) return false;
+    if (out) {
+        out->x = x0;
+        out->y = y0;
+        out->width = x1 - x0;
+        out->height = y1 - y0;
+    }
+    return true;
+}
+
+/* Overlapping or edge-adjacent */
+static bool rect_touches(const weact_rect_t *a, const weact_rect_t *b) {
+    return a->x <= b->x + b->width && b->x <= a->x + a->width &&
+           a->y <= b->y + b->height && b->y <= a->y + a->height;
+}
+
+static weact_rect_t rect_union(const weact_rect_t *a, const weact_rect_t *b) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = (a->x + a->width > b->x + b->width) ? a->x + a->width : b->x + b->width;
+    int y1 = (a->y + a->height > b->y + b->height) ? a->y + a->height : b->y + b->height;
+    weact_rect_t r = { x0, y0, x1 - x0, y1 - y0 };
+    return r;
+}
+
+static bool rect_contains(const weact_rect_t *outer, const weact_rect_t *inner) {
+    return inner->x >= outer->x && inner->y >= outer->y &&
+           inner->x + inner->width <= outer->x + outer->width &&
+           inner->y + inner->height <= outer->y + outer->height;
+}
+
+static weact_rect_t surface_bounds(const weact_surface_t *s) {
+    weact_rect_t r = { s->x, s->y, s->target.display_width, s->target.display_height };
+    return r;
+}
+
+/* ===== Surfaces ===== */
+
+weact_surface_t* weact_surface_create(int width, int height, bool with_alpha) {
+    if (width <= 0 || height <= 0) return NULL;
+
+    weact_surface_t *s = calloc(1, sizeof(weact_surface_t));
+    if (!s) return NULL;
+
+    size_t pixels = (size_t)width * height;
+    s->target.fd = -1;
+    s->target.is_connected = false;
+    s->target.orientation = WEACT_LANDSCAPE;
+    s->target.display_width = width;
+    s->target.display_height = height;
+    s->target.back_buffer = calloc(pixels, 2);
+    if (with_alpha) {
+        s->alpha = malloc(pixels);
+        if (s->alpha) memset(s->alpha, 0xFF, pixels);
+    }
+
+    if (!s->target.back_buffer || (with_alpha && !s->alpha)) {
+        free(s->target.back_buffer);
+        free(s->alpha);
+        free(s);
+        return NULL;
+    }
+
+    s->visible = true;
+    weact_surface_damage_all(s);
+    return s;
+}
+
+void weact_surface_destroy(weact_surface_t *surface) {
+    if (!surface) return;
+    if (surface->owner) weact_compositor_remove(surface->owner, surface);
+    free(surface->target.back_buffer);
+    free(surface->alpha);
+    free(surface);
+}
+
+weact_display_t* weact_surface_target(weact_surface_t *surface) {
+    return surface ? &surface->target : NULL;
+}
+
+void weact_surface_damage(weact_surface_t *surface, int x, int y, int width, int height) {
+    if (!surface) return;
+
+    weact_rect_t r = { x, y, width, height };
+    weact_rect_t all = { 0, 0, surface->target.display_width, surface->target.display_height };
+    if (!rect_intersect(&r, &all, &r)) return;
+
+    surface->damage = surface->damaged ? rect_union(&surface->damage, &r) : r;
+    surface->damaged = true;
+}
+
+void weact_surface_damage_all(weact_surface_t *surface) {
+    if (!surface) return;
+    weact_surface_damage(surface, 0, 0, surface->target.display_width,
+                         surface->target.display_height);
+}
+
+void weact_surface_fill_alpha(weact_surface_t *surface, int x, int y,
+                              int width, int height, uint8_t alpha) {
+    if (!surface || !surface->alpha) return;
+
+    weact_rect_t r = { x, y, width, height };
+    weact_rect_t all = { 0, 0, surface->target.display_width, surface->target.display_height };
+    if (!rect_intersect(&r, &all, &r)) return;
+
+    for (int row = r.y; row < r.y + r.height; row++) {
+        memset(surface->alpha + row * surface->target.display_width + r.x, alpha,
+               (size_t)r.width);
+    }
+    weact_surface_damage(surface, r.x, r.y, r.width, r.height);
+}
+
+/* Damage the panel area currently covered by the surface */
+static void damage_surface_area(weact_surface_t *surface) {
+    if (surface->owner && surface->visible) {
+        weact_rect_t r = surface_bounds(surface);
+        weact_compositor_damage(surface->owner, r.x, r.y, r.width, r.height);
+    }
+}
+
+void weact_surface_move(weact_surface_t *surface, int x, int y) {
+    if (!surface || (surface->x == x && surface->y == y)) return;
+    damage_surface_area(surface);
+    surface->x = x;
+    surface->y = y;
+    damage_surface_area(surface);
+}
+
+void weact_surface_set_visible(weact_surface_t *surface, bool visible) {
+    if (!surface || surface->visible == visible) return;
+    damage_surface_area(surface);
+    surface->visible = visible;
+    damage_surface_area(surface);
+}
+
+/* Insertion sort by z (stable, so equal z keeps insertion order) */
+static void sort_layers(weact_compositor_t *comp) {
+    for (int i = 1; i < comp->layer_count; i++) {
+        weact_surface_t *s = comp->layers[i];
+        int j = i - 1;
+        while (j >= 0 && comp->layers[j]->z > s->z) {
+            comp->layers[j + 1] = comp->layers[j];
+            j--;
+        }
+        comp->layers[j + 1] = s;
+    }
+}
+
+void weact_surface_set_z(weact_surface_t *surface, int z) {
+    if (!surface || surface->z == z) return;
+    surface->z = z;
+    if (surface->owner) {
+        sort_layers(surface->owner);
+        damage_surface_area(surface);
+    }
+}
+
+/* ===== Compositor ===== */
+
+void weact_compositor_init(weact_compositor_t *comp, weact_display_t *display,
+                           uint16_t background) {
+    if (!comp) return;
+    memset(comp, 0, sizeof(weact_compositor_t));
+    comp->display = display;
+    comp->background = background;
+    if (display) {
+        weact_compositor_damage(comp, 0, 0, display->display_width, display->display_height);
+    }
+}
+
+bool weact_compositor_add(weact_compositor_t *comp, weact_surface_t *surface) {
+    if (!comp || !surface || surface->owner) return false;
+    if (comp->layer_count >= WEACT_MAX_LAYERS) return false;
+
+    comp->layers[comp->layer_count++] = surface;
+    surface->owner = comp;
+    sort_layers(comp);
+    damage_surface_area(surface);
+    return true;
+}
+
+void weact_compositor_remove(weact_compositor_t *comp, weact_surface_t *surface) {
+    if (!comp || !surface || surface->owner != comp) return;
+
+    damage_surface_area(surface);
+    for (int i = 0; i < comp->layer_count; i++) {
+        if (comp->layers[i] == surface) {
+            memmove(&comp->layers[i], &comp->layers[i + 1],
+                    (size_t)(comp->layer_count - i - 1) * sizeof(weact_surface_t *));
+            comp->layer_count--;
+            break;
+        }
+    }
+    surface->owner = NULL;
+}
+
+void weact_compositor_damage(weact_compositor_t *comp, int x, int y, int width, int height) {
+    if (!comp || !comp->display) return;
+
+    weact_rect_t r = { x, y, width, height };
+    weact_rect_t panel = { 0, 0, comp->display->display_width, comp->display->display_height };
+    if (!rect_intersect(&r, &panel, &r)) return;
+
+    /* Absorb every rectangle the new one touches */
+    for (int i = 0; i < comp->damage_count; ) {
+        if (rect_touches(&comp->damage[i], &r)) {
+            r = rect_union(&comp->damage[i], &r);
+            comp->damage[i] = comp->damage[--comp->damage_count];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (comp->damage_count < WEACT_MAX_DAMAGE) {
+        comp->damage[comp->damage_count++] = r;
+        return;
+    }
+
+    /* List full: merge into the rectangle that grows least */
+    int best = 0;
+    long best_growth = -1;
+    for (int i = 0; i < comp->damage_count; i++) {
+        weact_rect_t u = rect_union(&comp->damage[i], &r);
+        long growth = (long)u.width * u.height -
+                      (long)comp->damage[i].width * comp->damage[i].height;
+        if (best_growth < 0 || growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    comp->damage[best] = rect_union(&comp->damage[best], &r);
+}
+
+/* Blend two BRG565 colours, alpha 0-255 */
+static uint16_t blend_brg565(uint16_t src, uint16_t dst, uint8_t alpha) {
+    unsigned int a = alpha + (alpha >> 7);  /* 0-256 */
+    unsigned int b = ((src >> 11) * a + (dst >> 11) * (256 - a)) >> 8;
+    unsigned int r = (((src >> 6) & 0x1F) * a + ((dst >> 6) & 0x1F) * (256 - a)) >> 8;
+    unsigned int g = ((src & 0x3F) * a + (dst & 0x3F) * (256 - a)) >> 8;
+    return (uint16_t)((b << 11) | (r << 6) | g);
+}
+
+/* Copy or blend the part of a layer that falls inside rect */
+static void blit_layer(weact_display_t *display, const weact_surface_t *s,
+                       const weact_rect_t *rect) {
+    weact_rect_t bounds = surface_bounds(s);
+    weact_rect_t r;
+    if (!rect_intersect(rect, &bounds, &r)) return;
+
+    int sw = s->target.display_width;
+    int dw = display->display_width;
+
+    for (int row = r.y; row < r.y + r.height; row++) {
+        int sy = row - s->y;
+        int sx = r.x - s->x;
+        const uint8_t *src = s->target.back_buffer + (sy * sw + sx) * 2;
+        uint8_t *dst = display->back_buffer + (row * dw + r.x) * 2;
+
+        if (!s->alpha) {
+            memcpy(dst, src, (size_t)r.width * 2);
+            continue;
+        }
+
+        const uint8_t *alpha = s->alpha + sy * sw + sx;
+        for (int i = 0; i < r.width; i++) {
+            uint8_t a = alpha[i];
+            if (a == 0) continue;
+            if (a == 255) {
+                dst[i * 2] = src[i * 2];
+                dst[i * 2 + 1] = src[i * 2 + 1];
+            } else {
+                uint16_t sc = (uint16_t)((src[i * 2] << 8) | src[i * 2 + 1]);
+                uint16_t dc = (uint16_t)((dst[i * 2] << 8) | dst[i * 2 + 1]);
+                uint16_t c = blend_brg565(sc, dc, a);
+                dst[i * 2] = c >> 8;
+                dst[i * 2 + 1] = c & 0xFF;
+            }
+        }
+    }
+}
+
+static void composite_rect(weact_compositor_t *comp, const weact_rect_t *r) {
+    weact_display_t *display = comp->display;
+
+    /* Skip everything under the topmost opaque layer covering the rect */
+    int start = -1;
+    for (int i = comp->layer_count - 1; i >= 0; i--) {
+        const weact_surface_t *s = comp->layers[i];
+        weact_rect_t bounds = surface_bounds(s);
+        if (s->visible && !s->alpha && rect_contains(&bounds, r)) {
+            start = i;
+            break;
+        }
+    }
+
+    if (start < 0) {
+        uint8_t hi = comp->background >> 8;
+        uint8_t lo = comp->background & 0xFF;
+        for (int row = r->y; row < r->y + r->height; row++) {
+            uint8_t *dst = display->back_buffer + (row * display->display_width + r->x) * 2;
+            for (int i = 0; i < r->width; i++) {
+                dst[i * 2] = hi;
+                dst[i * 2 + 1] = lo;
+            }
+        }
+        start = 0;
+    }
+
+    for (int i = start; i < comp->layer_count; i++) {
+        if (comp->layers[i]->visible) {
+            blit_layer(display, comp->layers[i], r);
+        }
+    }
+}
+
+bool weact_compositor_update(weact_compositor_t *comp) {
+    if (!comp || !comp->display || !comp->display->back_buffer) return false;
+
+    if (comp->display->index_bpp) {
+        snprintf(comp->display->last_error, sizeof(comp->display->last_error),
+                 "Compositor requires direct colour mode");
+        return false;
+    }
+
+    /* Collect per-layer damage */
+    for (int i = 0; i < comp->layer_count; i++) {
+        weact_surface_t *s = comp->layers[i];
+        if (s->damaged && s->visible) {
+            weact_compositor_damage(comp, s->x + s->damage.x, s->y + s->damage.y,
+                                    s->damage.width, s->damage.height);
+        }
+        s->damaged = false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < comp->damage_count; i++) {
+        composite_rect(comp, &comp->damage[i]);
+        if (ok && !weact_flush_region(comp->display, comp->damage[i].x, comp->damage[i].y,
+                                      comp->damage[i].width, comp->damage[i].height)) {
+            ok = false;
+        }
+    }
+
+    comp->damage_count = 0;
+    return ok;
+}
@@ -0,0 +1,127 @@
+/**
+ * Offscreen Surfaces and Layered Compositor for WeAct Display
+ *
+ * A surface is an offscreen pixel buffer with its own size and an
+ * optional per-pixel alpha plane. Every surface embeds a weact_display_t
+ * drawing target, so all weact_draw_*() primitives and ft_text_init()
+ * work on it unchanged.
+ *
+ * The compositor stacks surfaces in z-order on the panel and, on update,
+ * re-composites and uploads only the areas that were damaged.
+ */
+
+#ifndef WEACT_SURFACE_H
+#define WEACT_SURFACE_H
+
+#include "weact_display.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WEACT_MAX_LAYERS 16
+#define WEACT_MAX_DAMAGE 16
+
+typedef struct weact_compositor weact_compositor_t;
+
+/* Offscreen surface */
+typedef struct {
+    weact_display_t target;      /* Drawing target (not connected) */
+    uint8_t *alpha;              /* Per-pixel alpha 0-255, NULL = opaque */
+    int x;                       /* Position on panel */
+    int y;
+    int z;                       /* Stacking order (higher = on top) */
+    bool visible;
+    bool damaged;
+    weact_rect_t damage;         /* Pending damage in surface coordinates */
+    weact_compositor_t *owner;
+} weact_surface_t;
+
+/* Compositor */
+struct weact_compositor {
+    weact_display_t *display;
+    uint16_t background;         /* Colour under the lowest layer */
+    weact_surface_t *layers[WEACT_MAX_LAYERS];  /* Sorted by z */
+    int layer_count;
+    weact_rect_t damage[WEACT_MAX_DAMAGE];      /* Panel coordinates */
+    int damage_count;
+};
+
+/**
+ * Create offscreen surface (cleared to black, alpha fully opaque)
+ * @param width Surface width
+ * @param height Surface height
+ * @param with_alpha Allocate per-pixel alpha plane
+ * @return Surface or NULL on error
+ */
+weact_surface_t* weact_surface_create(int width, int height, bool with_alpha);
+
+/**
+ * Destroy surface (removes it from its compositor)
+ */
+void weact_surface_destroy(weact_surface_t *surface);
+
+/**
+ * Get drawing target for weact_draw_*() and ft_text_init()
+ */
+weact_display_t* weact_surface_target(weact_surface_t *surface);
+
+/**
+ * Mark area as changed (surface coordinates)
+ * Call after drawing; the compositor only re-composites damaged areas.
+ */
+void weact_surface_damage(weact_surface_t *surface, int x, int y, int width, int height);
+
+/**
+ * Mark whole surface as changed
+ */
+void weact_surface_damage_all(weact_surface_t *surface);
+
+/**
+ * Set alpha for a rectangle (surface coordinates)
+ */
+void weact_surface_fill_alpha(weact_surface_t *surface, int x, int y,
+                              int width, int height, uint8_t alpha);
+
+/**
+ * Move surface on panel
+ */
+void weact_surface_move(weact_surface_t *surface, int x, int y);
+
+/**
+ * Show or hide surface
+ */
+void weact_surface_set_visible(weact_surface_t *surface, bool visible);
+
+/**
+ * Change stacking order
+ */
+void weact_surface_set_z(weact_surface_t *surface, int z);
+
+/**
+ * Initialize compositor for display
+ */
+void weact_compositor_init(weact_compositor_t *comp, weact_display_t *display,
+                           uint16_t background);
+
+/**
+ * Add surface as layer
+ * @return false if the layer limit is reached
+ */
+bool weact_compositor_add(weact_compositor_t *comp, weact_surface_t *surface);
+
+/**
+ * Remove surface (its area is re-composited on next update)
+ */
+void weact_compositor_remove(weact_compositor_t *comp, weact_surface_t *surface);
+
+/**
+ * Mark panel area for re-composition (panel coordinates)
+ */
+void weact_compositor_damage(weact_compositor_t *comp, int x, int y, int width, int height);
+
+/**
+ * Re-composite damaged areas into the back buffer and upload them
+ * @return false on transport error
+ */
+bool weact_compositor_update(weact_compositor_t *comp);
+
+#endif /* WEACT_SURFACE_H */
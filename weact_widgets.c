@@ -0,0 +1,311 @@
+/**
+ * Incremental Metric Widgets Implementation
+ */
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "weact_widgets.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ===== Common ===== */
+
+static void widget_mark(weact_widget_t *w, int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) return;
+
+    if (!w->has_dirty) {
+        w->dirty.x = x;
+        w->dirty.y = y;
+        w->dirty.width = width;
+        w->dirty.height = height;
+        w->has_dirty = true;
+        return;
+    }
+
+    int x0 = x < w->dirty.x ? x : w->dirty.x;
+    int y0 = y < w->dirty.y ? y : w->dirty.y;
+    int x1 = (x + width > w->dirty.x + w->dirty.width) ? x + width : w->dirty.x + w->dirty.width;
+    int y1 = (y + height > w->dirty.y + w->dirty.height) ? y + height : w->dirty.y + w->dirty.height;
+    w->dirty.x = x0;
+    w->dirty.y = y0;
+    w->dirty.width = x1 - x0;
+    w->dirty.height = y1 - y0;
+}
+
+static void widget_init(weact_widget_t *w, weact_display_t *display,
+                        int x, int y, int width, int height) {
+    memset(w, 0, sizeof(weact_widget_t));
+    w->display = display;
+    w->x = x;
+    w->y = y;
+    w->width = width;
+    w->height = height;
+    w->fg = WEACT_GREEN;
+    w->bg = WEACT_BLACK;
+}
+
+bool weact_widget_take_dirty(weact_widget_t *widget, weact_rect_t *rect) {
+    if (!widget || !widget->has_dirty) return false;
+    if (rect) *rect = widget->dirty;
+    widget->has_dirty = false;
+    return true;
+}
+
+bool weact_widget_flush(weact_widget_t *widget) {
+    weact_rect_t r;
+    if (!weact_widget_take_dirty(widget, &r)) return true;
+    return weact_flush_region(widget->display, r.x, r.y, r.width, r.height);
+}
+
+/* Map value to row inside widget (0 = top) */
+static int value_to_row(float value, float min, float max, int height) {
+    if (max <= min || height <= 1) return height - 1;
+    float t = (value - min) / (max - min);
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (height - 1) - (int)(t * (height - 1) + 0.5f);
+}
+
+/* ===== Chart ===== */
+
+bool weact_chart_init(weact_chart_t *chart, weact_display_t *display,
+                      int x, int y, int width, int height, float min, float max,
+                      weact_chart_style_t style, weact_chart_mode_t mode) {
+    if (!chart || !display || width <= 0 || height <= 0) return false;
+
+    memset(chart, 0, sizeof(weact_chart_t));
+    widget_init(&chart->base, display, x, y, width, height);
+    chart->style = style;
+    chart->mode = mode;
+    chart->min = min;
+    chart->max = max;
+    chart->samples = calloc((size_t)width, sizeof(float));
+    chart->col_top = malloc((size_t)width * sizeof(int16_t));
+    chart->col_bottom = malloc((size_t)width * sizeof(int16_t));
+
+    if (!chart->samples || !chart->col_top || !chart->col_bottom) {
+        weact_chart_free(chart);
+        return false;
+    }
+
+    weact_chart_redraw(chart);
+    return true;
+}
+
+bool weact_sparkline_init(weact_chart_t *chart, weact_display_t *display,
+                          int x, int y, int width, int height, float min, float max) {
+    return weact_chart_init(chart, display, x, y, width, height, min, max,
+                            WEACT_CHART_LINE, WEACT_CHART_SCROLL);
+}
+
+void weact_chart_free(weact_chart_t *chart) {
+    if (!chart) return;
+    free(chart->samples);
+    free(chart->col_top);
+    free(chart->col_bottom);
+    chart->samples = NULL;
+    chart->col_top = NULL;
+    chart->col_bottom = NULL;
+}
+
+/* Sample n steps back from the newest (0 = newest) */
+static float chart_sample(const weact_chart_t *chart, int back) {
+    int w = chart->base.width;
+    return chart->samples[((chart->head - 1 - back) % w + w) % w];
+}
+
+/* Draw column span, touching only the rows that actually change */
+static void chart_set_column(weact_chart_t *chart, int col, int top, int bottom) {
+    int old_top = chart->col_top[col];
+    int old_bottom = chart->col_bottom[col];
+    if (old_top == top && old_bottom == bottom) return;
+
+    weact_widget_t *w = &chart->base;
+    int px = w->x + col;
+
+    if (old_top <= old_bottom) {
+        weact_draw_line(w->display, px, w->y + old_top, px, w->y + old_bottom, w->bg);
+    }
+    if (top <= bottom) {
+        weact_draw_line(w->display, px, w->y + top, px, w->y + bottom, w->fg);
+    }
+
+    /* Changed rows = union of old and new spans */
+    int y0 = w->height, y1 = -1;
+    if (old_top <= old_bottom) {
+        y0 = old_top;
+        y1 = old_bottom;
+    }
+    if (top <= bottom) {
+        if (top < y0) y0 = top;
+        if (bottom > y1) y1 = bottom;
+    }
+    widget_mark(w, px, w->y + y0, 1, y1 - y0 + 1);
+
+    chart->col_top[col] = (int16_t)top;
+    chart->col_bottom[col] = (int16_t)bottom;
+}
+
+/* Compute span for a sample, given the previous sample for line style */
+static void chart_span(const weact_chart_t *chart, float value, bool has_prev, float prev,
+                       int *top, int *bottom) {
+    int h = chart->base.height;
+    int row = value_to_row(value, chart->min, chart->max, h);
+
+    if (chart->style == WEACT_CHART_AREA) {
+        *top = row;
+        *bottom = h - 1;
+    } else if (has_prev) {
+        int prev_row = value_to_row(prev, chart->min, chart->max, h);
+        *top = row < prev_row ? row : prev_row;
+        *bottom = row < prev_row ? prev_row : row;
+    } else {
+        *top = *bottom = row;
+    }
+}
+
+/* Scroll layout: column c shows sample (count - w + c), oldest on the left */
+static void chart_layout_scroll(weact_chart_t *chart) {
+    int w = chart->base.width;
+
+    for (int col = 0; col < w; col++) {
+        int back = w - 1 - col;
+        if (back >= chart->count) {
+            chart_set_column(chart, col, 1, 0);
+            continue;
+        }
+        bool has_prev = back + 1 < chart->count;
+        int top, bottom;
+        chart_span(chart, chart_sample(chart, back), has_prev,
+                   has_prev ? chart_sample(chart, back + 1) : 0.0f, &top, &bottom);
+        chart_set_column(chart, col, top, bottom);
+    }
+}
+
+void weact_chart_push(weact_chart_t *chart, float value) {
+    if (!chart || !chart->samples) return;
+
+    int w = chart->base.width;
+    bool has_prev = chart->count > 0;
+    float prev = has_prev ? chart_sample(chart, 0) : 0.0f;
+
+    chart->samples[chart->head] = value;
+    chart->head = (chart->head + 1) % w;
+    if (chart->count < w) chart->count++;
+
+    if (chart->mode == WEACT_CHART_SWEEP) {
+        /* Line segments never connect across the wrap */
+        int col = chart->sweep_x;
+        int top, bottom;
+        chart_span(chart, value, has_prev && col > 0, prev, &top, &bottom);
+        chart_set_column(chart, col, top, bottom);
+
+        chart->sweep_x = (col + 1) % w;
+        /* Blank column ahead of the cursor marks where the sweep is */
+        if (w > 2) chart_set_column(chart, chart->sweep_x, 1, 0);
+        return;
+    }
+
+    chart_layout_scroll(chart);
+}
+
+void weact_chart_redraw(weact_chart_t *chart) {
+    if (!chart || !chart->samples) return;
+
+    weact_widget_t *w = &chart->base;
+    weact_draw_rect(w->display, w->x, w->y, w->width, w->height, w->bg, true);
+    for (int col = 0; col < w->width; col++) {
+        chart->col_top[col] = 1;
+        chart->col_bottom[col] = 0;
+    }
+
+    if (chart->mode == WEACT_CHART_SWEEP) {
+        /* Replay history into the columns it was swept into */
+        int start = chart->sweep_x - chart->count;
+        for (int i = 0; i < chart->count; i++) {
+            int col = ((start + i) % w->width + w->width) % w->width;
+            int back = chart->count - 1 - i;
+            bool has_prev = i > 0 && col > 0;
+            int top, bottom;
+            chart_span(chart, chart_sample(chart, back), has_prev,
+                       has_prev ? chart_sample(chart, back + 1) : 0.0f, &top, &bottom);
+            chart_set_column(chart, col, top, bottom);
+        }
+        if (w->width > 2) chart_set_column(chart, chart->sweep_x, 1, 0);
+    } else {
+        chart_layout_scroll(chart);
+    }
+
+    widget_mark(w, w->x, w->y, w->width, w->height);
+}
+
+void weact_chart_set_colors(weact_chart_t *chart, uint16_t fg, uint16_t bg) {
+    if (!chart) return;
+    chart->base.fg = fg;
+    chart->base.bg = bg;
+    weact_chart_redraw(chart);
+}
+
+/* ===== Gauge ===== */
+
+static int gauge_length(const weact_gauge_t *g) {
+    int span = g->vertical ? g->base.height : g->base.width;
+    if (g->max <= g->min) return 0;
+    float t = (g->value - g->min) / (g->max - g->min);
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (int)(t * span + 0.5f);
+}
+
+/* Fill part of the gauge track [from, to) along its axis */
+static void gauge_fill(weact_gauge_t *g, int from, int to, uint16_t color) {
+    weact_widget_t *w = &g->base;
+    if (to <= from) return;
+
+    if (g->vertical) {
+        int y0 = w->y + w->height - to;
+        weact_draw_rect(w->display, w->x, y0, w->width, to - from, color, true);
+        widget_mark(w, w->x, y0, w->width, to - from);
+    } else {
+        weact_draw_rect(w->display, w->x + from, w->y, to - from, w->height, color, true);
+        widget_mark(w, w->x + from, w->y, to - from, w->height);
+    }
+}
+
+void weact_gauge_init(weact_gauge_t *gauge, weact_display_t *display,
+                      int x, int y, int width, int height,
+                      float min, float max, bool vertical) {
+    if (!gauge) return;
+
+    memset(gauge, 0, sizeof(weact_gauge_t));
+    widget_init(&gauge->base, display, x, y, width, height);
+    gauge->min = min;
+    gauge->max = max;
+    gauge->value = min;
+    gauge->vertical = vertical;
+    weact_gauge_redraw(gauge);
+}
+
+void weact_gauge_set(weact_gauge_t *gauge, float value) {
+    if (!gauge) return;
+
+    gauge->value = value;
+    int length = gauge_length(gauge);
+
+    if (length > gauge->filled) {
+        gauge_fill(gauge, gauge->filled, length, gauge->base.fg);
+    } else if (length < gauge->filled) {
+        gauge_fill(gauge, length, gauge->filled, gauge->base.bg);
+    }
+    gauge->filled = length;
+}
+
+void weact_gauge_redraw(weact_gauge_t *gauge) {
+    if (!gauge) return;
+
+    int span = gauge->vertical ? gauge->base.height : gauge->base.width;
+    gauge->filled = gauge_length(gauge);
+    gauge_fill(gauge, 0, gauge->filled, gauge->base.fg);
+    gauge_fill(gauge, gauge->filled, span, gauge->base.bg);
+}
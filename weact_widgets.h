@@ -0,0 +1,141 @@
+/**
+ * Incremental Metric Widgets for WeAct Display
+ * Strip chart, sparkline and bar gauge
+ *
+ * Widgets draw with the regular weact_draw_*() primitives into any
+ * drawing target (the display or a surface) and track the smallest
+ * rectangle that changed, so a new sample costs only a few columns of
+ * serial traffic instead of a full frame.
+ */
+
+#ifndef WEACT_WIDGETS_H
+#define WEACT_WIDGETS_H
+
+#include "weact_display.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Chart drawing style */
+typedef enum {
+    WEACT_CHART_AREA = 0,       /* Filled columns (strip chart) */
+    WEACT_CHART_LINE            /* Connected 1px line (sparkline) */
+} weact_chart_style_t;
+
+/* Chart update mode */
+typedef enum {
+    WEACT_CHART_SCROLL = 0,     /* Newest sample on the right, history scrolls */
+    WEACT_CHART_SWEEP           /* One column appended in place, wraps around */
+} weact_chart_mode_t;
+
+/* Common widget state */
+typedef struct {
+    weact_display_t *display;   /* Drawing target */
+    int x;
+    int y;
+    int width;
+    int height;
+    uint16_t fg;
+    uint16_t bg;
+    weact_rect_t dirty;         /* Changed area since last flush */
+    bool has_dirty;
+} weact_widget_t;
+
+/* Strip chart / sparkline */
+typedef struct {
+    weact_widget_t base;
+    weact_chart_style_t style;
+    weact_chart_mode_t mode;
+    float min;
+    float max;
+    float *samples;             /* Ring buffer, one sample per column */
+    int head;                   /* Index of next write */
+    int count;                  /* Samples stored (<= width) */
+    int sweep_x;                /* Next column in sweep mode */
+    int16_t *col_top;           /* Foreground span currently drawn */
+    int16_t *col_bottom;        /* (top > bottom = empty column) */
+} weact_chart_t;
+
+/* Bar gauge */
+typedef struct {
+    weact_widget_t base;
+    float min;
+    float max;
+    float value;
+    bool vertical;              /* Fills bottom-up instead of left-right */
+    int filled;                 /* Pixels currently filled */
+} weact_gauge_t;
+
+/**
+ * Initialize chart
+ * @param chart Chart to initialize
+ * @param display Drawing target
+ * @param x Chart X coordinate
+ * @param y Chart Y coordinate
+ * @param width Chart width (also history length)
+ * @param height Chart height
+ * @param min Value mapped to the bottom row
+ * @param max Value mapped to the top row
+ * @param style Area or line
+ * @param mode Scroll or sweep
+ * @return false on allocation error
+ */
+bool weact_chart_init(weact_chart_t *chart, weact_display_t *display,
+                      int x, int y, int width, int height, float min, float max,
+                      weact_chart_style_t style, weact_chart_mode_t mode);
+
+/**
+ * Initialize sparkline (line style, scrolling)
+ */
+bool weact_sparkline_init(weact_chart_t *chart, weact_display_t *display,
+                          int x, int y, int width, int height, float min, float max);
+
+/**
+ * Free chart history
+ */
+void weact_chart_free(weact_chart_t *chart);
+
+/**
+ * Set chart colors (forces full redraw)
+ */
+void weact_chart_set_colors(weact_chart_t *chart, uint16_t fg, uint16_t bg);
+
+/**
+ * Append sample and redraw only the columns that change
+ */
+void weact_chart_push(weact_chart_t *chart, float value);
+
+/**
+ * Redraw whole chart (marks whole area dirty)
+ */
+void weact_chart_redraw(weact_chart_t *chart);
+
+/**
+ * Initialize bar gauge
+ */
+void weact_gauge_init(weact_gauge_t *gauge, weact_display_t *display,
+                      int x, int y, int width, int height,
+                      float min, float max, bool vertical);
+
+/**
+ * Set gauge value, redrawing only the span between old and new level
+ */
+void weact_gauge_set(weact_gauge_t *gauge, float value);
+
+/**
+ * Redraw whole gauge
+ */
+void weact_gauge_redraw(weact_gauge_t *gauge);
+
+/**
+ * Take and clear the changed area (e.g. to damage a surface)
+ * @return false if nothing changed
+ */
+bool weact_widget_take_dirty(weact_widget_t *widget, weact_rect_t *rect);
+
+/**
+ * Upload the changed area to the panel and clear it
+ * @return false on transport error
+ */
+bool weact_widget_flush(weact_widget_t *widget);
+
+#endif /* WEACT_WIDGETS_H */
@@ -0,0 +1,255 @@
+/**
+ * WeActAnim - Delta Animation Encoder and Player for WeAct Display
+ *
+ * Usage:
+ *   weactanim encode -o splash.wanim [-d 100] frame001.ppm frame002.ppm ...
+ *   weactanim play -p /dev/ttyACM0 [-l 0] splash.wanim
+ *   weactanim info splash.wanim
+ *
+ * Frames are stored as changed rectangles only, so playback runs at the
+ * rate the serial link allows with almost no CPU use.
+ */
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "weact_display.h"
+#include "weact_image.h"
+#include "weact_anim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <getopt.h>
+
+/* Display help */
+static void show_help(const char *prog_name) {
+    printf("WeActAnim - Delta Animation Encoder and Player for WeAct Display FS\n");
+    printf("\n");
+    printf("USAGE:\n");
+    printf("  %s encode -o FILE [options] FRAME...\n", prog_name);
+    printf("  %s play -p PORT [options] FILE\n", prog_name);
+    printf("  %s info FILE\n", prog_name);
+    printf("\n");
+    printf("ENCODE OPTIONS:\n");
+    printf("  -o, --output FILE     Output .wanim file (required)\n");
+    printf("  -d, --delay MS        Frame delay in milliseconds (default: 100)\n");
+    printf("  -W, --width N         Frame width (default: 160)\n");
+    printf("  -H, --height N        Frame height (default: 80)\n");
+    printf("  --dither MODE         none, ordered, fs (default: ordered)\n");
+    printf("  Frames may be PPM, PGM or BMP files and are scaled to fit.\n");
+    printf("\n");
+    printf("PLAY OPTIONS:\n");
+    printf("  -p, --port PORT       Serial port (required)\n");
+    printf("  -l, --loops N         Number of loops, 0 = forever (default: 1)\n");
+    printf("  -r, --rotate ORIENT   Orientation 0-3 (default: 2, landscape)\n");
+    printf("\n");
+    printf("  -v, --verbose         Verbose output\n");
+    printf("  -h, --help            Show this help\n");
+    printf("\n");
+    printf("EXAMPLES:\n");
+    printf("  %s encode -o boot.wanim -d 40 boot/*.ppm\n", prog_name);
+    printf("  %s play -p /dev/ttyACM0 -l 0 boot.wanim\n", prog_name);
+    printf("\n");
+}
+
+static int cmd_encode(int argc, char *argv[]) {
+    static struct option long_options[] = {
+        {"output",  required_argument, 0, 'o'},
+        {"delay",   required_argument, 0, 'd'},
+        {"width",   required_argument, 0, 'W'},
+        {"height",  required_argument, 0, 'H'},
+        {"dither",  required_argument, 0, 'D'},
+        {"verbose", no_argument,       0, 'v'},
+        {0, 0, 0, 0}
+    };
+
+    const char *output = NULL;
+    int delay = 100;
+    int width = WEACT_DISPLAY_WIDTH;
+    int height = WEACT_DISPLAY_HEIGHT;
+    bool verbose = false;
+    weact_image_options_t opts;
+    weact_image_default_options(&opts);
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:d:W:H:v", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            case 'd': delay = atoi(optarg); break;
+            case 'W': width = atoi(optarg); break;
+            case 'H': height = atoi(optarg); break;
+            case 'v': verbose = true; break;
+            case 'D':
+                if (strcasecmp(optarg, "none") == 0) {
+                    opts.dither = WEACT_DITHER_NONE;
+                } else if (strcasecmp(optarg, "fs") == 0) {
+                    opts.dither = WEACT_DITHER_FLOYD_STEINBERG;
+                } else {
+                    opts.dither = WEACT_DITHER_ORDERED;
+                }
+                break;
+            default:
+                return 1;
+        }
+    }
+
+    if (!output || optind >= argc) {
+        fprintf(stderr, "Error: encode needs -o FILE and at least one frame\n");
+        return 1;
+    }
+
+    if (delay < 0 || delay > 65535) {
+        fprintf(stderr, "Warning: Delay %d out of range, using 100\n", delay);
+        delay = 100;
+    }
+
+    char error[256];
+    weact_anim_encoder_t *enc = weact_anim_encoder_create(output, width, height,
+                                                          error, sizeof(error));
+    if (!enc) {
+        fprintf(stderr, "Error: %s\n", error);
+        return 1;
+    }
+
+    uint16_t *pixels = malloc((size_t)width * height * sizeof(uint16_t));
+    if (!pixels) {
+        fprintf(stderr, "Error: Out of memory\n");
+        weact_anim_encoder_finish(enc, NULL);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = optind; i < argc && ok; i++) {
+        if (!weact_image_render(argv[i], pixels, width, height, &opts, error, sizeof(error))) {
+            fprintf(stderr, "Error: %s\n", error);
+            ok = false;
+        } else if (!weact_anim_encoder_add_frame(enc, pixels, (uint16_t)delay)) {
+            fprintf(stderr, "Error: Failed to write frame %s\n", argv[i]);
+            ok = false;
+        } else if (verbose) {
+            printf("Encoded frame: %s\n", argv[i]);
+        }
+    }
+    free(pixels);
+
+    weact_anim_stats_t stats;
+    if (!weact_anim_encoder_finish(enc, &stats) || !ok) {
+        fprintf(stderr, "Error: Failed to write %s\n", output);
+        return 1;
+    }
+
+    printf("%s: %d frames, %d bitmap + %d fill regions, %zu bytes\n",
+           output, stats.frames, stats.bitmap_regions, stats.fill_regions, stats.file_size);
+    return 0;
+}
+
+static int cmd_play(int argc, char *argv[]) {
+    static struct option long_options[] = {
+        {"port",    required_argument, 0, 'p'},
+        {"loops",   required_argument, 0, 'l'},
+        {"rotate",  required_argument, 0, 'r'},
+        {"verbose", no_argument,       0, 'v'},
+        {0, 0, 0, 0}
+    };
+
+    const char *port = NULL;
+    int loops = 1;
+    int orientation = -1;
+    bool verbose = false;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:l:r:v", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': port = optarg; break;
+            case 'l': loops = atoi(optarg); break;
+            case 'r': orientation = atoi(optarg); break;
+            case 'v': verbose = true; break;
+            default:
+                return 1;
+        }
+    }
+
+    if (!port || optind >= argc) {
+        fprintf(stderr, "Error: play needs -p PORT and an animation file\n");
+        return 1;
+    }
+
+    char error[256];
+    weact_anim_t *anim = weact_anim_open(argv[optind], error, sizeof(error));
+    if (!anim) {
+        fprintf(stderr, "Error: %s\n", error);
+        return 1;
+    }
+
+    weact_display_t display;
+    if (!weact_init(&display, port)) {
+        fprintf(stderr, "Error: Failed to initialize display\n");
+        fprintf(stderr, "Details: %s\n", weact_get_last_error(&display));
+        weact_anim_close(anim);
+        return 1;
+    }
+
+    if (orientation >= 0 && orientation <= 3) {
+        weact_set_orientation(&display, (weact_orientation_t)orientation);
+    }
+
+    if (verbose) {
+        int w, h, frames;
+        uint32_t duration;
+        weact_anim_get_info(anim, &w, &h, &frames, &duration);
+        printf("Playing %s: %dx%d, %d frames, %u ms\n", argv[optind], w, h, frames, duration);
+    }
+
+    bool ok = weact_anim_play(&display, anim, loops);
+    if (!ok) {
+        fprintf(stderr, "Error: %s\n", weact_get_last_error(&display));
+    }
+
+    weact_anim_close(anim);
+    weact_cleanup(&display);
+    return ok ? 0 : 1;
+}
+
+static int cmd_info(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Error: info needs an animation file\n");
+        return 1;
+    }
+
+    char error[256];
+    weact_anim_t *anim = weact_anim_open(argv[1], error, sizeof(error));
+    if (!anim) {
+        fprintf(stderr, "Error: %s\n", error);
+        return 1;
+    }
+
+    int w, h, frames;
+    uint32_t duration;
+    weact_anim_get_info(anim, &w, &h, &frames, &duration);
+    printf("File: %s\n", argv[1]);
+    printf("Size: %dx%d\n", w, h);
+    printf("Frames: %d\n", frames);
+    printf("Duration: %u ms\n", duration);
+
+    weact_anim_close(anim);
+    return 0;
+}
+
+/* Main program */
+int main(int argc, char *argv[]) {
+    if (argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        show_help(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    /* Subcommand parses the remaining arguments */
+    if (strcmp(argv[1], "encode") == 0) return cmd_encode(argc - 1, argv + 1);
+    if (strcmp(argv[1], "play") == 0) return cmd_play(argc - 1, argv + 1);
+    if (strcmp(argv[1], "info") == 0) return cmd_info(argc - 1, argv + 1);
+
+    fprintf(stderr, "Error: Unknown command '%s'\n\n", argv[1]);
+    show_help(argv[0]);
+    return 1;
+}
@@ -0,0 +1,172 @@
+/**
+ * WeActAtlas - Glyph Atlas Baker for WeAct Display
+ *
+ * Usage:
+ *   weactatlas -o dejavu.watlas [-f font.ttf] [-s 8,12,16] [-r latin,cyrillic]
+ *
+ * The atlas holds pre-rasterized glyphs and is passed to weactcli (-a) or
+ * ft_text_init() in place of the font path. It is mapped at startup, so
+ * one-shot runs skip loading FreeType and rasterizing glyphs entirely.
+ */
+
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include "text_freetype.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#define MAX_SIZES  32
+#define MAX_RANGES 64
+
+/* Named codepoint ranges */
+static const struct {
+    const char *name;
+    uint32_t first;
+    uint32_t last;
+} named_ranges[] = {
+    {"latin",    0x0020, 0x007E},
+    {"latin",    0x00A0, 0x017F},   /* Latin-1 Supplement, Latin Extended-A */
+    {"cyrillic", 0x0400, 0x04FF},
+    {"box",      0x2500, 0x259F},   /* Box drawing and block elements */
+    {NULL, 0, 0}
+};
+
+/* Display help */
+static void show_help(const char *prog_name) {
+    printf("WeActAtlas - Glyph Atlas Baker for WeAct Display FS\n");
+    printf("\n");
+    printf("USAGE:\n");
+    printf("  %s -o FILE [options]\n", prog_name);
+    printf("\n");
+    printf("OPTIONS:\n");
+    printf("  -o, --output FILE     Output .watlas file (required)\n");
+    printf("  -f, --font FILE       TTF font (default: DejaVu Sans)\n");
+    printf("  -s, --sizes LIST      Pixel sizes, e.g. 8,12,16 (default: 8,12,16)\n");
+    printf("  -r, --ranges LIST     latin, cyrillic, box or FIRST-LAST in hex,\n");
+    printf("                        e.g. latin,0x2190-0x21FF (default: latin,cyrillic)\n");
+    printf("  -h, --help            Show this help\n");
+    printf("\n");
+    printf("Codepoints missing from the atlas are still rendered from the\n");
+    printf("font with FreeType when needed.\n");
+    printf("\n");
+    printf("EXAMPLES:\n");
+    printf("  %s -o ~/.local/share/weact/sans.watlas\n", prog_name);
+    printf("  %s -f DejaVuSansMono.ttf -s 10,12 -r latin,cyrillic,box -o mono.watlas\n", prog_name);
+    printf("  weactcli -p /dev/ttyACM0 -a mono.watlas -z 12 \"Hello\"\n");
+    printf("\n");
+}
+
+/* Parse comma-separated sizes */
+static int parse_sizes(char *list, int *sizes) {
+    int count = 0;
+    for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+        int size = atoi(tok);
+        if (size <= 0 || size > 255 || count >= MAX_SIZES) {
+            fprintf(stderr, "Error: Invalid size '%s'\n", tok);
+            return -1;
+        }
+        sizes[count++] = size;
+    }
+    return count;
+}
+
+/* Parse comma-separated range names and FIRST-LAST pairs */
+static int parse_ranges(char *list, uint32_t (*ranges)[2]) {
+    int count = 0;
+    for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+        bool named = false;
+        for (int i = 0; named_ranges[i].name; i++) {
+            if (strcasecmp(tok, named_ranges[i].name) == 0 && count < MAX_RANGES) {
+                ranges[count][0] = named_ranges[i].first;
+                ranges[count][1] = named_ranges[i].last;
+                count++;
+                named = true;
+            }
+        }
+        if (named) continue;
+
+        char *end;
+        unsigned long first = strtoul(tok, &end, 16);
+        unsigned long last = first;
+        if (*end == '-') last = strtoul(end + 1, &end, 16);
+        if (*end != '\0' || first > last || last > 0x10FFFF || count >= MAX_RANGES) {
+            fprintf(stderr, "Error: Invalid range '%s'\n", tok);
+            return -1;
+        }
+        ranges[count][0] = (uint32_t)first;
+        ranges[count][1] = (uint32_t)last;
+        count++;
+    }
+    return count;
+}
+
+/* Main program */
+int main(int argc, char *argv[]) {
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"font",   required_argument, 0, 'f'},
+        {"sizes",  required_argument, 0, 's'},
+        {"ranges", required_argument, 0, 'r'},
+        {"help",   no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    const char *output = NULL;
+    const char *font = NULL;
+    char size_list[256] = "8,12,16";
+    char range_list[256] = "latin,cyrillic";
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:f:s:r:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            case 'f': font = optarg; break;
+            case 's': snprintf(size_list, sizeof(size_list), "%s", optarg); break;
+            case 'r': snprintf(range_list, sizeof(range_list), "%s", optarg); break;
+            case 'h':
+                show_help(argv[0]);
+                return 0;
+            default:
+                return 1;
+        }
+    }
+
+    if (!output) {
+        show_help(argv[0]);
+        return 1;
+    }
+
+    if (!font) {
+        font = ft_text_get_default_font();
+        if (!font) {
+            fprintf(stderr, "Error: Could not find suitable font, use -f\n");
+            return 1;
+        }
+    }
+
+    int sizes[MAX_SIZES];
+    uint32_t ranges[MAX_RANGES][2];
+    int size_count = parse_sizes(size_list, sizes);
+    int range_count = parse_ranges(range_list, ranges);
+    if (size_count <= 0 || range_count <= 0) {
+        return 1;
+    }
+
+    char error[256];
+    if (!ft_text_bake_atlas(font, sizes, size_count, (const uint32_t (*)[2])ranges, range_count,
+                            output, error, sizeof(error))) {
+        fprintf(stderr, "Error: %s\n", error);
+        return 1;
+    }
+
+    struct stat st;
+    long bytes = stat(output, &st) == 0 ? (long)st.st_size : 0;
+    printf("%s: %s, %d sizes, %ld bytes\n", output, font, size_count, bytes);
+    return 0;
+}
@@ -12,6 +12,7 @@
 
 #include "weact_display.h"
 #include "text_freetype.h"
+#include "weact_image.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -69,6 +70,7 @@ typedef struct {
     char port[256];
     char text[8192];
     char file_path[512];
+    char image_path[512];
     char font_path[512];
     font_type_t font_type;
     uint16_t color;
@@ -81,6 +83,8 @@ typedef struct {
     float scroll_speed;
     weact_scroll_dir_t scroll_direction;
     bool read_stdin;
+    weact_scale_filter_t image_filter;
+    weact_dither_t image_dither;
 } cli_config_t;
 
 /* Global config */
@@ -88,6 +92,7 @@ static cli_config_t config = {
     .port = "/dev/ttyUSB0",
     .text = "",
     .file_path = "",
+    .image_path = "",
     .font_path = "",
     .font_type = FONT_SANS,  /* Default to Sans for compatibility */
     .color = WEACT_WHITE,
@@ -99,7 +104,9 @@ static cli_config_t config = {
     .scroll = false,
     .scroll_speed = 30.0f,
     .scroll_direction = SCROLL_UP,
-    .read_stdin = false
+    .read_stdin = false,
+    .image_filter = WEACT_SCALE_BOX,
+    .image_dither = WEACT_DITHER_ORDERED
 };
 
 /* Color name to BRG565 */
@@ -160,6 +167,27 @@ static bool parse_scroll(const char *scroll_str) {
     return true;
 }
 
+/* Parse image dither mode */
+static weact_dither_t parse_dither(const char *mode) {
+    if (strcasecmp(mode, "none") == 0) return WEACT_DITHER_NONE;
+    if (strcasecmp(mode, "ordered") == 0) return WEACT_DITHER_ORDERED;
+    if (strcasecmp(mode, "fs") == 0 || strcasecmp(mode, "floyd") == 0) {
+        return WEACT_DITHER_FLOYD_STEINBERG;
+    }
+    
+    fprintf(stderr, "Warning: Unknown dither mode '%s', using ordered\n", mode);
+    return WEACT_DITHER_ORDERED;
+}
+
+/* Parse image scaling filter */
+static weact_scale_filter_t parse_filter(const char *filter) {
+    if (strcasecmp(filter, "box") == 0) return WEACT_SCALE_BOX;
+    if (strcasecmp(filter, "bilinear") == 0) return WEACT_SCALE_BILINEAR;
+    
+    fprintf(stderr, "Warning: Unknown filter '%s', using box\n", filter);
+    return WEACT_SCALE_BOX;
+}
+
 /* Read text from stdin */
 static bool read_from_stdin(char *buffer, size_t max_size) {
     if (!buffer || max_size == 0) return false;
@@ -220,6 +248,7 @@ static void show_help(const char *prog_name) {
     printf("  3. Pipe:          echo \"Hello\" | %s -p /dev/ttyUSB0\n", prog_name);
     printf("  4. Redirection:   %s -p /dev/ttyUSB0 < log.txt\n", prog_name);
     printf("  5. Clear screen:  %s -p /dev/ttyUSB0 --cls\n", prog_name);
+    printf("  6. Image:         %s -p /dev/ttyUSB0 -I photo.ppm\n", prog_name);
     printf("\n");
     printf("OPTIONS:\n");
     printf("  -p, --port PORT       Serial port (required, e.g., /dev/ttyUSB0)\n");
@@ -234,6 +263,7 @@ static void show_help(const char *prog_name) {
     printf("                        Example: -s 25.5:u or -s 40:d\n");
     printf("  -z, --size SIZE       Font size: 8 (small), 12 (medium), 16 (large)\n");
     printf("                        Default: 12\n");
+    printf("  -a, --atlas FILE      Use pre-baked glyph atlas (see weactatlas)\n");
     printf("  -r, --rotate ORIENT   Rotate display:\n");
     printf("                        0 = Portrait (80x160)\n");
     printf("                        1 = Reverse Portrait (80x160, upside down)\n");
@@ -241,6 +271,9 @@ static void show_help(const char *prog_name) {
     printf("                        3 = Reverse Landscape (160x80, upside down)\n");
     printf("  -f, --file FILE       Load text from file\n");
     printf("  -i, --stdin           Read from stdin (auto-detected with pipes)\n");
+    printf("  -I, --image FILE      Show image (PPM/PGM/BMP), scaled to fit\n");
+    printf("  --dither MODE         Image dithering: none, ordered, fs (default: ordered)\n");
+    printf("  --filter FILTER       Image scaling: box, bilinear (default: box)\n");
     printf("  --center              Center text horizontally\n");
     printf("  --cls                 Clear screen only\n");
     printf("  -v, --verbose         Verbose output\n");
@@ -268,6 +301,9 @@ static void show_help(const char *prog_name) {
     printf("  # Clear screen\n");
     printf("  %s -p /dev/ttyUSB0 --cls\n", prog_name);
     printf("\n");
+    printf("  # Camera thumbnail with error diffusion\n");
+    printf("  %s -p /dev/ttyUSB0 -I snapshot.ppm --dither fs\n", prog_name);
+    printf("\n");
     printf("NOTES:\n");
     printf("  - Port is always required\n");
     printf("  - File input has priority over stdin\n");
@@ -284,8 +320,20 @@ static void display_scrolling_text(weact_display_t *display, ft_text_context_t *
     int display_width = weact_get_display_width(display);
     int display_height = weact_get_display_height(display);
     
+    /* Lay out once as a single line; every frame only redraws the same
+     * glyphs at a new offset */
+    ft_text_set_alignment(text_ctx, config.center ? FT_TEXT_ALIGN_CENTER : FT_TEXT_ALIGN_LEFT);
+    ft_text_layout_t *layout = ft_text_layout_create(text_ctx, text, 0, 0);
+    if (!layout) {
+        fprintf(stderr, "Error: Failed to lay out text\n");
+        return;
+    }
+    
+    ft_text_wrap_info_t info;
+    ft_text_layout_get_info(layout, &info, NULL);
+    int text_height = info.height;
     int text_width = ft_text_get_width(text_ctx, text);
-    int text_height = ft_text_get_height(text_ctx);
+    int x = config.center ? (display_width - text_width) / 2 : 5;
     
     /* Starting positions based on direction */
     float position;
@@ -336,16 +384,15 @@ static void display_scrolling_text(weact_display_t *display, ft_text_context_t *
         /* Render frame */
         weact_clear_buffer(display, WEACT_BLACK);
         
-        int y = (int)position;
-        int x = config.center ? (display_width - text_width) / 2 : 5;
-        
-        ft_text_draw(text_ctx, x, y, text);
+        ft_text_layout_draw(text_ctx, layout, x, (int)position);
         
         weact_update_display(display);
         
         usleep(33000); /* ~30 FPS */
     }
     
+    ft_text_layout_destroy(layout);
+    
     /* Clear at end */
     weact_clear_buffer(display, WEACT_BLACK);
     weact_update_display(display);
@@ -368,9 +415,6 @@ static void display_static_text(weact_display_t *display, ft_text_context_t *tex
         printf("Display dimensions: %dx%d pixels\n", display_width, display_height);
     }
     
-    /* Always use LEFT alignment and calculate X manually */
-    ft_text_set_alignment(text_ctx, FT_TEXT_ALIGN_LEFT);
-    
     if (config.center) {
         if (text_width <= display_width - 10) {
             /* Text fits on one line - calculate center position */
@@ -384,18 +428,25 @@ static void display_static_text(weact_display_t *display, ft_text_context_t *tex
                 printf("Single line centered at: x=%d, y=%d\n", x, y);
             }
             
+            ft_text_set_alignment(text_ctx, FT_TEXT_ALIGN_LEFT);
             ft_text_draw(text_ctx, x, y, text);
         } else {
-            /* Text too long - need word wrapping with manual centering */
+            /* Text too long - word wrap with every line centered */
+            ft_text_wrap_info_t info;
+            ft_text_measure_wrapped(text_ctx, display_width - 10, display_height - 10,
+                                    text, &info);
+            int y = (display_height - info.height) / 2;
+            if (y < 5) y = 5;
+            
             if (config.verbose) {
-                printf("Text too long (%d > %d), using word wrap\n", 
-                       text_width, display_width - 10);
+                printf("Text too long (%d > %d), wrapped into %d lines%s\n", 
+                       text_width, display_width - 10, info.lines,
+                       info.overflow ? " (truncated)" : "");
             }
             
-            /* For now, just use left-aligned word wrap */
-            /* TODO: Implement per-line centering in ft_text_draw_wrapped */
-            ft_text_draw_wrapped(text_ctx, 5, 5, display_width - 10, 
-                             display_height - 10, text);
+            ft_text_set_alignment(text_ctx, FT_TEXT_ALIGN_CENTER);
+            ft_text_draw_wrapped(text_ctx, 5, y, display_width - 10, 
+                                 display_height - 10, text);
         }
     } else {
         /* Normal left-aligned text */
@@ -403,12 +454,14 @@ static void display_static_text(weact_display_t *display, ft_text_context_t *tex
             printf("Drawing left-aligned text\n");
         }
         
+        ft_text_set_alignment(text_ctx, FT_TEXT_ALIGN_LEFT);
+        
         /* Simple case - just draw at 5,5 */
         if (text_width <= display_width - 10) {
             ft_text_draw(text_ctx, 5, 5, text);
-        } else {
-            ft_text_draw_wrapped(text_ctx, 5, 5, display_width - 10, 
-                             display_height - 10, text);
+        } else if (!ft_text_draw_wrapped(text_ctx, 5, 5, display_width - 10, 
+                                         display_height - 10, text) && config.verbose) {
+            printf("Text truncated to fit display\n");
         }
     }
     
@@ -421,6 +474,27 @@ static void display_static_text(weact_display_t *display, ft_text_context_t *tex
     sleep(2); /* Show for 2 seconds */
 }
 
+/* Display image file */
+static bool display_image(weact_display_t *display, const char *path) {
+    weact_image_options_t opts;
+    weact_image_default_options(&opts);
+    opts.filter = config.image_filter;
+    opts.dither = config.image_dither;
+    
+    weact_clear_buffer(display, WEACT_BLACK);
+    
+    if (!weact_image_draw(display, path, 0, 0, 0, 0, &opts)) {
+        fprintf(stderr, "Error: %s\n", weact_get_last_error(display));
+        return false;
+    }
+    
+    if (config.verbose) {
+        printf("Image drawn: %s\n", path);
+    }
+    
+    return weact_update_display(display);
+}
+
 /* Main program */
 int main(int argc, char *argv[]) {
     /* Check if stdin is a pipe/redirect */
@@ -435,9 +509,13 @@ int main(int argc, char *argv[]) {
         {"font",    required_argument, 0, 't'},
         {"scroll",  required_argument, 0, 's'},
         {"size",    required_argument, 0, 'z'},
+        {"atlas",   required_argument, 0, 'a'},
         {"rotate",  required_argument, 0, 'r'},
         {"file",    required_argument, 0, 'f'},
         {"stdin",   no_argument,       0, 'i'},
+        {"image",   required_argument, 0, 'I'},
+        {"dither",  required_argument, 0, 'D'},
+        {"filter",  required_argument, 0, 'F'},
         {"center",  no_argument,       0, 'C'},
         {"cls",     no_argument,       0, 'L'},
         {"verbose", no_argument,       0, 'v'},
@@ -449,7 +527,7 @@ int main(int argc, char *argv[]) {
     int option_index = 0;
     bool port_specified = false;
     
-    while ((opt = getopt_long(argc, argv, "p:c:t:s:z:r:f:iCLvh", 
+    while ((opt = getopt_long(argc, argv, "p:c:t:s:z:a:r:f:iI:CLvh", 
                               long_options, &option_index)) != -1) {
         switch (opt) {
             case 'p':
@@ -478,6 +556,9 @@ int main(int argc, char *argv[]) {
             case 'z':
                 config.font_size = parse_font_size(optarg);
                 break;
+            case 'a':
+                strncpy(config.font_path, optarg, sizeof(config.font_path) - 1);
+                break;
             case 'r':
                 /* Rotation/orientation */
                 config.orientation = atoi(optarg);
@@ -493,6 +574,15 @@ int main(int argc, char *argv[]) {
             case 'i':
                 config.read_stdin = true;
                 break;
+            case 'I':
+                strncpy(config.image_path, optarg, sizeof(config.image_path) - 1);
+                break;
+            case 'D':
+                config.image_dither = parse_dither(optarg);
+                break;
+            case 'F':
+                config.image_filter = parse_filter(optarg);
+                break;
             case 'C':
                 config.center = true;
                 break;
@@ -528,8 +618,10 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    /* Priority: file > stdin > command line */
-    if (config.file_path[0] != '\0') {
+    /* Priority: image > file > stdin > command line */
+    if (config.image_path[0] != '\0') {
+        /* Image mode - no text needed */
+    } else if (config.file_path[0] != '\0') {
         if (!load_from_file(config.file_path, config.text, sizeof(config.text))) {
             return 1;
         }
@@ -628,8 +720,16 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
-    /* Find font file */
-    const char *font_path = find_font_path(config.font_type);
+    /* Image mode */
+    if (config.image_path[0] != '\0') {
+        bool ok = display_image(&display, config.image_path);
+        weact_cleanup(&display);
+        return ok ? 0 : 1;
+    }
+    
+    /* Find font file (a glyph atlas replaces it) */
+    const char *font_path = config.font_path[0] != '\0' ?
+                            config.font_path : find_font_path(config.font_type);
     if (!font_path) {
         fprintf(stderr, "Error: Could not find suitable font\n");
         fprintf(stderr, "Please install fonts-dejavu or fonts-liberation:\n");
@@ -654,6 +754,12 @@ int main(int argc, char *argv[]) {
     
     ft_text_set_color(text_ctx, config.color);
     
+    /* Characters missing from the font come from fallback fonts */
+    int fallbacks = ft_text_add_default_fallbacks(text_ctx);
+    if (config.verbose) {
+        printf("Fallback fonts: %d\n", fallbacks);
+    }
+    
     if (config.center) {
         ft_text_set_alignment(text_ctx, FT_TEXT_ALIGN_CENTER);
     }
@@ -10,7 +10,8 @@
  * - PTY-based terminal emulation
  * - Scrollback buffer
  * - Cyrillic support
- * - Basic ANSI escape sequence support
+ * - VT100/xterm escape sequences: cursor control, erase, scroll regions,
+ *   colours, insert/delete line, alternate screen (see term_emu.h)
  */
 
 #define _XOPEN_SOURCE 600
@@ -19,6 +20,9 @@
 
 #include "weact_display.h"
 #include "text_freetype.h"
+#include "term_emu.h"
+#include "term_vcsa.h"
+#include "term_cast.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,21 +31,42 @@
 #include <fcntl.h>
 #include <termios.h>
 #include <signal.h>
-#include <sys/select.h>
+#include <time.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
 #include <errno.h>
 #include <pty.h>
 
 /* Terminal configuration */
-#define SCROLLBACK_LINES 100
 #define INPUT_BUFFER_SIZE 1024
 #define DISPLAY_WIDTH 160
 #define DISPLAY_HEIGHT 80
 
-/* Font size presets */
-#define FONT_SMALL 8
+/* Renderer-only cell attribute: drawn as the cursor */
+#define CELL_CURSOR 0x80
+
+/* Scroll mode indicator (top-right corner) */
+#define INDICATOR_X (DISPLAY_WIDTH - 10)
+#define INDICATOR_Y 2
+#define INDICATOR_W 8
+#define INDICATOR_H 6
+
+/* Frame scheduling: at most one render per frame budget, which follows
+ * how long renders take (serial transfer included) */
+#define FRAME_MIN_US 16000
+#define FRAME_MAX_US 250000
+#define PTY_DRAIN_LIMIT (256 * 1024)  /* Parsed per wakeup before keys are checked */
+
+/* Font size (pixels) */
 #define FONT_MEDIUM 10
-#define FONT_LARGE 12
+#define FONT_SIZE_MIN 6
+#define FONT_SIZE_MAX 32
+
+#define MAX_CONSOLES 9              /* Alt+1 .. Alt+9 */
+#define MIRROR_POLL_US 100000       /* Re-read interval when the source cannot be polled */
 
 /* Font types */
 typedef enum {
@@ -72,28 +97,111 @@ static const char *font_paths[][3] = {
     }
 };
 
-/* Global state */
+/* Characters pre-rendered into cell bitmaps: printable ASCII and Cyrillic */
+static const uint32_t cell_ranges[][2] = {
+    { 0x0020, 0x007E },
+    { 0x0400, 0x045F }
+};
+
+/* Virtual console: a program on its own PTY with its own terminal model */
 typedef struct {
-    weact_display_t display;
-    ft_text_context_t *text_ctx;
-    
-    /* PTY */
     int master_fd;
-    int slave_fd;
     pid_t child_pid;
+    const char *command;    /* Run with $SHELL -c, NULL for a shell */
     
-    /* Terminal state */
-    char screen_buffer[SCROLLBACK_LINES][81];  /* Max 80 chars + null */
-    int current_line;
-    int total_lines;
-    int scroll_offset;
-    int cursor_x;
-    int cursor_y;
+    /* Terminal model (screen, cursor, scrollback) */
+    term_emu_t *term;
     
     /* Scroll mode */
     bool scroll_mode;       /* ScrollLock enabled */
     int view_offset;        /* How many lines scrolled back */
     
+    bool recorded;          /* Output and keys go to the recording (-r) */
+} console_t;
+
+/* Latency samples in microseconds */
+typedef struct {
+    long long *values;
+    size_t count;
+    size_t capacity;
+} latency_log_t;
+
+/* Replay benchmark measurements */
+typedef struct {
+    size_t bytes_fed;
+    long long parse_us;         /* Time spent in the parser */
+    int frames;                 /* Renders that uploaded something */
+    uint64_t bytes_uploaded;    /* Commands and pixel data */
+    latency_log_t output;       /* Output fed -> first byte of the frame showing it */
+    latency_log_t keystroke;    /* Same, for the echo of replayed input */
+    latency_log_t waiting;      /* Feed times of output not on the wire yet */
+    latency_log_t waiting_keys;
+} replay_stats_t;
+
+/* Global state */
+typedef struct {
+    weact_display_t display;
+    ft_text_context_t *text_ctx;
+    ft_text_cells_t *cells;     /* Pre-rendered ASCII and Cyrillic cells */
+    
+    /* Virtual consoles; background ones parse output but are not rendered */
+    console_t consoles[MAX_CONSOLES];
+    int console_count;
+    int active;
+    
+    /* Linux console mirror (-m): one console without a PTY whose model
+     * follows /dev/vcsaN through a viewport */
+    const char *mirror_path;
+    term_vcsa_t *vcsa;
+    int view_x;             /* Viewport origin on the mirrored screen */
+    int view_y;
+    bool view_follow;       /* Keep the cursor inside the viewport */
+    int mirror_timer_fd;    /* Periodic re-read, -1 when change notification works */
+    
+    /* Recording (-r) and replay benchmark (-R): a replay is the only
+     * console, fed from the recording instead of a PTY */
+    term_cast_writer_t *recorder;
+    const char *record_path;
+    const char *replay_path;
+    term_cast_t *replay;
+    bool replay_realtime;       /* Keep recorded timing instead of full speed */
+    int replay_next;            /* Next event to feed */
+    long long replay_start_us;
+    bool replay_echo;           /* Input replayed: the next output is its echo */
+    bool frame_on_wire;         /* The render in progress has sent something */
+    replay_stats_t stats;
+    
+    /* What is on the panel: one cell per visible position */
+    term_cell_t *rendered;
+    term_cell_t *history_row;   /* Scrollback line being drawn */
+    bool render_valid;      /* false: clear and send the whole frame */
+    int rendered_offset;    /* View offset of the last render */
+    uint64_t rendered_history_end;  /* Scrollback it was drawn from */
+    int rendered_history_count;
+    int rendered_cursor;    /* Screen row holding the drawn cursor, -1 none */
+    bool rendered_scroll;   /* Scroll indicator is on the panel */
+    int rendered_console;   /* Console of the last render, -1 none */
+    
+    /* Damage of the render in progress, in cells */
+    weact_rect_t pending;
+    bool has_pending;
+    
+    /* Frame scheduling */
+    bool render_pending;        /* Model or view changed since the last render */
+    long long next_frame_us;    /* Earliest start of the next render */
+    long long frame_budget_us;
+    
+    /* Event loop */
+    int epoll_fd;
+    int timer_fd;               /* Frame deadline */
+    int signal_fd;              /* SIGCHLD, SIGWINCH, SIGTERM, SIGINT */
+    long long timer_deadline_us;    /* Armed deadline, 0 when disarmed */
+    bool display_polled;        /* Uploads queue; sent as the port drains */
+    bool display_watch;         /* Waiting for the display to take more */
+    sigset_t saved_mask;
+    
+    int scrollback_lines;   /* Scrollback depth */
+    
     /* Display settings - dynamic based on font size */
     int font_size;
     font_type_t font_type;
@@ -127,62 +235,30 @@ static const char* find_font_path(font_type_t type) {
     return NULL;
 }
 
-/* Calculate terminal dimensions based on font size */
+/* Calculate terminal dimensions from the font metrics */
 static void calculate_terminal_dimensions(void) {
-    /* Character dimensions based on font size and type */
-    /* Monospace fonts have fixed width, proportional vary */
-    
-    if (term_state.font_type == FONT_MONO) {
-        /* Monospace - all characters same width */
-        switch (term_state.font_size) {
-            case FONT_SMALL:   /* 8pt */
-                term_state.char_width = 5;
-                term_state.char_height = 10;
-                break;
-            case FONT_MEDIUM:  /* 10pt */
-                term_state.char_width = 6;
-                term_state.char_height = 12;
-                break;
-            case FONT_LARGE:   /* 12pt */
-                term_state.char_width = 7;
-                term_state.char_height = 14;
-                break;
-            default:
-                term_state.char_width = 6;
-                term_state.char_height = 12;
-        }
-    } else {
-        /* Proportional fonts - use average width */
-        switch (term_state.font_size) {
-            case FONT_SMALL:
-                term_state.char_width = 5;
-                term_state.char_height = 9;
-                break;
-            case FONT_MEDIUM:
-                term_state.char_width = 6;
-                term_state.char_height = 11;
-                break;
-            case FONT_LARGE:
-                term_state.char_width = 7;
-                term_state.char_height = 13;
-                break;
-            default:
-                term_state.char_width = 6;
-                term_state.char_height = 11;
-        }
-    }
+    /* Cells are as wide as the widest ASCII advance, so glyphs placed by
+     * the grid never drift from where the font would put them */
+    ft_text_get_cell_size(term_state.text_ctx, &term_state.char_width,
+                          &term_state.char_height);
     
     /* Calculate how many columns and rows fit */
     /* Leave 4px margins (2px on each side) */
     term_state.term_cols = (DISPLAY_WIDTH - 4) / term_state.char_width;
     term_state.term_rows = (DISPLAY_HEIGHT - 4) / term_state.char_height;
     
-    /* Sanity limits */
-    if (term_state.term_cols < 10) term_state.term_cols = 10;
+    /* Sanity limits; never a grid larger than the panel, or the prompt
+     * and cursor end up below its bottom edge */
+    if (term_state.term_cols < 1) term_state.term_cols = 1;
     if (term_state.term_cols > 80) term_state.term_cols = 80;
-    if (term_state.term_rows < 4) term_state.term_rows = 4;
+    if (term_state.term_rows < 1) term_state.term_rows = 1;
     if (term_state.term_rows > 20) term_state.term_rows = 20;
     
+    if (term_state.term_cols < 10 || term_state.term_rows < 4) {
+        fprintf(stderr, "Warning: %dpt font leaves only %dx%d chars\n",
+                term_state.font_size, term_state.term_cols, term_state.term_rows);
+    }
+    
     if (term_state.verbose) {
         fprintf(stderr, "Terminal dimensions: %dx%d chars (%dx%d px per char)\n",
                 term_state.term_cols, term_state.term_rows,
@@ -236,171 +312,361 @@ static bool set_raw_mode(void) {
     return true;
 }
 
-/* Initialize screen buffer */
-static void init_screen_buffer(void) {
-    for (int i = 0; i < SCROLLBACK_LINES; i++) {
-        memset(term_state.screen_buffer[i], 0, 81);
+/* Console shown on the panel */
+static console_t* active_console(void) {
+    return &term_state.consoles[term_state.active];
+}
+
+/* Process output from a console's PTY */
+static void process_pty_output(console_t *con, const char *data, ssize_t len) {
+    term_emu_feed(con->term, data, (size_t)len);
+    
+    if (con->recorded) {
+        term_cast_write(term_state.recorder, 'o', data, (size_t)len);
     }
-    term_state.current_line = 0;
-    term_state.total_lines = 1;  /* Start with 1 line available */
-    term_state.scroll_offset = 0;
-    term_state.cursor_x = 0;
-    term_state.cursor_y = 0;
+    
+    /* Answer status requests (cursor position, device attributes) */
+    if (con->term->reply_len > 0 && con->master_fd >= 0) {
+        if (write(con->master_fd, con->term->reply, con->term->reply_len) < 0 &&
+            term_state.verbose) {
+            perror("write");
+        }
+    }
+    con->term->reply_len = 0;
 }
 
-/* Add character to screen buffer */
-static void add_char_to_buffer(char c) {
-    if (c == '\n' || c == '\r') {
-        /* Move to next line */
-        term_state.cursor_x = 0;
-        term_state.cursor_y++;
+/* Draw one cell (two for a wide character) at its grid position,
+ * background included */
+static void draw_cell(const term_cell_t *cell, int col, int row, int width) {
+    weact_rect_t box = {
+        2 + col * term_state.char_width,
+        2 + row * term_state.char_height,
+        term_state.char_width * width,
+        term_state.char_height
+    };
+    uint16_t fg = cell->fg;
+    uint16_t bg = cell->bg;
+    
+    if (cell->attr & TERM_ATTR_REVERSE) {
+        fg = cell->bg;
+        bg = cell->fg;
+    }
+    if (cell->attr & CELL_CURSOR) {
+        fg = WEACT_BLACK;
+        bg = WEACT_GREEN;
+    }
+    
+    uint32_t codepoint = (cell->attr & TERM_ATTR_INVISIBLE) ? ' ' : cell->codepoint;
+    
+    /* Common characters: one blit of the pre-rendered cell */
+    if (width > 1 || !ft_text_cells_draw(term_state.cells, box.x, box.y, codepoint, fg, bg)) {
+        weact_draw_rect(&term_state.display, box.x, box.y, box.width, box.height, bg, true);
         
-        /* Make sure we have a line to write to */
-        if (term_state.cursor_y >= SCROLLBACK_LINES) {
-            /* Shift buffer up */
-            memmove(term_state.screen_buffer[0], 
-                   term_state.screen_buffer[1],
-                   (SCROLLBACK_LINES - 1) * 81);
-            term_state.cursor_y = SCROLLBACK_LINES - 1;
-            memset(term_state.screen_buffer[term_state.cursor_y], 0, 81);
-        } else {
-            /* Clear new line */
-            memset(term_state.screen_buffer[term_state.cursor_y], 0, 81);
+        if (codepoint != ' ' && codepoint != TERM_WIDE_CONTINUATION) {
+            ft_text_set_color(term_state.text_ctx, fg);
+            ft_text_draw_char(term_state.text_ctx, box.x, box.y, codepoint, &box);
         }
-        
-    } else if (c == '\b' || c == 127) {
-        /* Backspace */
-        if (term_state.cursor_x > 0) {
-            term_state.cursor_x--;
-            term_state.screen_buffer[term_state.cursor_y][term_state.cursor_x] = ' ';
+    }
+    
+    if (cell->attr & TERM_ATTR_UNDERLINE) {
+        weact_draw_hline(&term_state.display, box.x, box.y + box.height - 1, box.width, fg);
+    }
+}
+
+static bool cells_equal(const term_cell_t *a, const term_cell_t *b) {
+    return a->codepoint == b->codepoint && a->fg == b->fg &&
+           a->bg == b->bg && a->attr == b->attr;
+}
+
+static long long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void log_latency(latency_log_t *log, long long value) {
+    if (log->count == log->capacity) {
+        size_t capacity = log->capacity ? log->capacity * 2 : 1024;
+        long long *values = realloc(log->values, capacity * sizeof(long long));
+        if (!values) return;
+        log->values = values;
+        log->capacity = capacity;
+    }
+    log->values[log->count++] = value;
+}
+
+/* Send a rectangle of the back buffer; the first one of a frame is when
+ * the output it shows reaches the wire */
+static void send_region(int x, int y, int width, int height) {
+    replay_stats_t *stats = &term_state.stats;
+    
+    if (!term_state.frame_on_wire) {
+        long long now = now_us();
+        for (size_t i = 0; i < stats->waiting.count; i++) {
+            log_latency(&stats->output, now - stats->waiting.values[i]);
         }
-        
-    } else if (c >= 32 && c < 127) {
-        /* Printable ASCII */
-        if (term_state.cursor_x < term_state.term_cols && 
-            term_state.cursor_x < 80) {  /* Hard limit for buffer */
-            term_state.screen_buffer[term_state.cursor_y][term_state.cursor_x] = c;
-            term_state.cursor_x++;
-            
-            if (term_state.cursor_x >= term_state.term_cols) {
-                /* Auto wrap to next line */
-                term_state.cursor_x = 0;
-                term_state.cursor_y++;
-                
-                if (term_state.cursor_y >= SCROLLBACK_LINES) {
-                    /* Shift buffer up */
-                    memmove(term_state.screen_buffer[0], 
-                           term_state.screen_buffer[1],
-                           (SCROLLBACK_LINES - 1) * 81);
-                    term_state.cursor_y = SCROLLBACK_LINES - 1;
-                    memset(term_state.screen_buffer[term_state.cursor_y], 0, 81);
-                }
-            }
+        for (size_t i = 0; i < stats->waiting_keys.count; i++) {
+            log_latency(&stats->output, now - stats->waiting_keys.values[i]);
+            log_latency(&stats->keystroke, now - stats->waiting_keys.values[i]);
         }
+        stats->waiting.count = 0;
+        stats->waiting_keys.count = 0;
+        term_state.frame_on_wire = true;
     }
+    
+    stats->bytes_uploaded += 10 + (uint64_t)width * height * 2;
+    weact_flush_region(&term_state.display, x, y, width, height);
 }
 
-/* Simple ANSI escape sequence parser */
-static void process_ansi_sequence(const char *seq, int len) {
-    (void)seq;
-    (void)len;
-    /* Basic implementation - just ignore for now */
-    /* Can be extended to support colors, cursor movement, etc. */
+/* Send a rectangle of cells to the panel */
+static void flush_cells(const weact_rect_t *r) {
+    send_region(2 + r->x * term_state.char_width,
+                2 + r->y * term_state.char_height,
+                r->width * term_state.char_width,
+                r->height * term_state.char_height);
 }
 
-/* Process output from PTY */
-static void process_pty_output(const char *data, ssize_t len) {
-    static char escape_buffer[64];
-    static int escape_len = 0;
-    static bool in_escape = false;
+/* Queue changed cells on one row; rows below each other are merged while
+ * the merged rectangle wastes less than one row of cells */
+static void add_damage(int first, int last, int row) {
+    weact_rect_t r = { first, row, last - first + 1, 1 };
+    weact_rect_t *p = &term_state.pending;
     
-    for (ssize_t i = 0; i < len; i++) {
-        char c = data[i];
+    if (term_state.has_pending && p->y + p->height == row) {
+        int x0 = p->x < r.x ? p->x : r.x;
+        int x1 = p->x + p->width > r.x + r.width ? p->x + p->width : r.x + r.width;
+        int waste = (x1 - x0) * (p->height + 1) - p->width * p->height - r.width;
         
-        if (in_escape) {
-            escape_buffer[escape_len++] = c;
-            
-            /* Check for end of escape sequence */
-            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || escape_len >= 63) {
-                process_ansi_sequence(escape_buffer, escape_len);
-                in_escape = false;
-                escape_len = 0;
-            }
-        } else if (c == 27) { /* ESC */
-            in_escape = true;
-            escape_buffer[0] = c;
-            escape_len = 1;
-        } else {
-            add_char_to_buffer(c);
+        if (waste <= term_state.term_cols) {
+            p->x = x0;
+            p->width = x1 - x0;
+            p->height++;
+            return;
         }
     }
+    
+    if (term_state.has_pending) flush_cells(p);
+    *p = r;
+    term_state.has_pending = true;
 }
 
-/* Render screen to display */
+/* Render active console to display: repaint and send only cells that changed */
 static void render_screen(void) {
-    weact_clear_buffer(&term_state.display, WEACT_BLACK);
+    console_t *con = active_console();
+    term_emu_t *term = con->term;
+    int cols = term->cols;
     
-    /* Calculate which lines to show based on scroll mode */
-    int display_start_line;
+    /* First frame or scroll mode toggled: clear margins too and send everything */
+    bool full = !term_state.render_valid || con->scroll_mode != term_state.rendered_scroll;
+    if (full) {
+        weact_clear_buffer(&term_state.display, WEACT_BLACK);
+    }
     
-    if (term_state.scroll_mode) {
-        /* Scroll mode - show from view_offset */
-        display_start_line = term_state.cursor_y - term_state.term_rows + 1 - term_state.view_offset;
-        if (display_start_line < 0) display_start_line = 0;
-    } else {
-        /* Normal mode - show last lines */
-        if (term_state.cursor_y < term_state.term_rows) {
-            display_start_line = 0;
-        } else {
-            display_start_line = term_state.cursor_y - term_state.term_rows + 1;
-        }
+    /* In scroll mode the view starts view_offset lines back in history.
+     * After a console switch every row is compared with the panel, so
+     * only cells that differ between the two consoles are sent. The
+     * ring may have dropped lines, or CSI 3 J cleared them, since the
+     * offset was set. */
+    if (con->view_offset > term->history_count) {
+        con->view_offset = term->history_count;
     }
+    int offset = con->scroll_mode ? con->view_offset : 0;
+    bool moved = full || offset != term_state.rendered_offset ||
+                 term_state.active != term_state.rendered_console;
+    int cursor_row = (!con->scroll_mode && term->cursor_visible) ? term->cursor_y : -1;
     
-    int visible_lines = term_state.term_rows;
-    int y = 2;  /* Small top margin */
+    /* Lines pushed into scrollback shift what every history row shows */
+    bool history_moved = offset > 0 &&
+                         (term->history_end != term_state.rendered_history_end ||
+                          term->history_count != term_state.rendered_history_count);
     
-    for (int row = 0; row < visible_lines; row++) {
-        int line_idx = display_start_line + row;
+    term_state.has_pending = false;
+    
+    for (int row = 0; row < term->rows; row++) {
+        int line = row - offset;
+        
+        /* Rows untouched by output, view and cursor are already on the panel */
+        if (!moved && row != cursor_row && row != term_state.rendered_cursor &&
+            (line < 0 ? !history_moved : !term_emu_row_dirty(term, line))) {
+            continue;
+        }
+        
+        const term_cell_t *cells;
+        if (line < 0) {
+            if (!term_emu_history_line(term, -line - 1, term_state.history_row, cols)) {
+                term_cell_t blank = { ' ', WEACT_WHITE, WEACT_BLACK, 0 };
+                for (int col = 0; col < cols; col++) term_state.history_row[col] = blank;
+            }
+            cells = term_state.history_row;
+        } else {
+            cells = term_emu_row(term, line);
+        }
         
-        if (line_idx >= 0 && line_idx <= term_state.cursor_y && line_idx < SCROLLBACK_LINES) {
-            char *line = term_state.screen_buffer[line_idx];
-            if (line[0] != '\0') {
-                if (term_state.verbose && !term_state.scroll_mode) {
-                    fprintf(stderr, "Drawing line %d at y=%d: '%s'\n", line_idx, y, line);
+        term_cell_t *shown = term_state.rendered + (size_t)row * cols;
+        int first = -1;
+        int last = -1;
+        
+        for (int col = 0; col < cols; col++) {
+            term_cell_t cell = cells[col];
+            bool cursor = row == cursor_row && col == term->cursor_x;
+            
+            /* Both halves of a wide character are compared and drawn as one */
+            int width = 1;
+            term_cell_t right;
+            if ((cell.attr & TERM_ATTR_WIDE) && col + 1 < cols &&
+                cells[col + 1].codepoint == TERM_WIDE_CONTINUATION) {
+                width = 2;
+                right = cells[col + 1];
+                if (row == cursor_row && col + 1 == term->cursor_x) {
+                    right.attr |= CELL_CURSOR;
+                    cursor = true;
                 }
-                ft_text_draw(term_state.text_ctx, 2, y, line);
             }
+            if (cursor) cell.attr |= CELL_CURSOR;
+            
+            bool changed = full || !cells_equal(&cell, &shown[col]) ||
+                           (width == 2 && !cells_equal(&right, &shown[col + 1]));
+            
+            if (changed) {
+                draw_cell(&cell, col, row, width);
+                shown[col] = cell;
+                if (width == 2) shown[col + 1] = right;
+                if (first < 0) first = col;
+                last = col + width - 1;
+            }
+            col += width - 1;
         }
         
-        y += term_state.char_height;
+        if (first >= 0 && !full) add_damage(first, last, row);
+    }
+    
+    term_emu_clear_damage(term);
+    term_state.rendered_offset = offset;
+    term_state.rendered_history_end = term->history_end;
+    term_state.rendered_history_count = term->history_count;
+    term_state.rendered_cursor = cursor_row;
+    term_state.rendered_console = term_state.active;
+    
+    if (con->scroll_mode) {
+        /* In scroll mode - show indicator in top-right corner */
+        weact_draw_rect(&term_state.display, INDICATOR_X, INDICATOR_Y,
+                        INDICATOR_W, INDICATOR_H, WEACT_YELLOW, true);
+    }
+    
+    if (full) {
+        /* No buffer swap: the back buffer stays what the panel shows */
+        send_region(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        term_state.render_valid = true;
+        term_state.rendered_scroll = con->scroll_mode;
+        return;
     }
     
-    /* Draw cursor only in normal mode (not when scrolling) */
-    if (!term_state.scroll_mode) {
-        int cursor_screen_row = (term_state.cursor_y < term_state.term_rows) ? 
-                                term_state.cursor_y : term_state.term_rows - 1;
+    if (term_state.has_pending) {
+        flush_cells(&term_state.pending);
         
-        if (cursor_screen_row >= 0 && cursor_screen_row < term_state.term_rows) {
-            int cursor_pixel_x = 2 + (term_state.cursor_x * term_state.char_width);
-            int cursor_pixel_y = 2 + (cursor_screen_row * term_state.char_height);
-            
-            /* Draw cursor as filled rectangle */
-            weact_draw_rect(&term_state.display, cursor_pixel_x, cursor_pixel_y, 
-                           term_state.char_width, term_state.char_height, 
-                           WEACT_GREEN, true);
+        /* The indicator overlaps the top row and may have been painted over */
+        if (con->scroll_mode) {
+            send_region(INDICATOR_X, INDICATOR_Y, INDICATOR_W, INDICATOR_H);
         }
+    }
+}
+
+/* Render the latest state and schedule the next frame */
+static void render_frame(void) {
+    long long start = now_us();
+    term_state.frame_on_wire = false;
+    render_screen();
+    long long spent = now_us() - start;
+    
+    if (term_state.frame_on_wire) {
+        term_state.stats.frames++;
     } else {
-        /* In scroll mode - show indicator in top-right corner */
-        /* Draw "SCROLL" text or indicator */
-        weact_draw_rect(&term_state.display, DISPLAY_WIDTH - 10, 2, 8, 6, 
-                       WEACT_YELLOW, true);
+        /* Output that changed nothing visible has no latency to measure */
+        term_state.stats.waiting.count = 0;
+        term_state.stats.waiting_keys.count = 0;
     }
     
-    weact_update_display(&term_state.display);
+    /* Twice the render time leaves at least half of it for parsing;
+     * smoothed so one slow frame does not stall the next ones */
+    long long budget = spent * 2;
+    if (budget < FRAME_MIN_US) budget = FRAME_MIN_US;
+    if (budget > FRAME_MAX_US) budget = FRAME_MAX_US;
+    term_state.frame_budget_us = (term_state.frame_budget_us * 3 + budget) / 4;
+    
+    term_state.next_frame_us = start + term_state.frame_budget_us;
+    term_state.render_pending = false;
+}
+
+/* Read everything a console's program has written so far into its model
+ * @return false when the program has exited */
+static bool drain_pty(console_t *con) {
+    char buffer[4096];
+    size_t total = 0;
+    
+    while (total < PTY_DRAIN_LIMIT) {
+        ssize_t n = read(con->master_fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            process_pty_output(con, buffer, n);
+            total += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        
+        /* EOF, or EIO once the slave side is closed */
+        return false;
+    }
+    
+    /* Background consoles only update their model */
+    if (total > 0 && con == active_console()) term_state.render_pending = true;
+    return true;
+}
+
+/* Close a console; the ones after it move down. The program ends with
+ * SIGHUP when its PTY closes. */
+static void close_console(int index) {
+    console_t *con = &term_state.consoles[index];
+    
+    if (term_state.verbose) {
+        fprintf(stderr, "\nConsole %d exited\n", index + 1);
+    }
+    
+    close(con->master_fd);
+    term_emu_destroy(con->term);
+    
+    term_state.console_count--;
+    memmove(con, con + 1, (size_t)(term_state.console_count - index) * sizeof(console_t));
+    
+    if (term_state.console_count == 0) {
+        term_state.running = false;
+        return;
+    }
+    
+    /* Indices shifted: compare the next render with the panel */
+    if (term_state.active > index ||
+        (term_state.active == index && index == term_state.console_count)) {
+        term_state.active--;
+    }
+    term_state.rendered_console = -1;
+    term_state.render_pending = true;
+}
+
+/* Show another console */
+static void switch_console(int index) {
+    if (index < 0 || index >= term_state.console_count || index == term_state.active) {
+        return;
+    }
+    
+    term_state.active = index;
+    term_state.render_pending = true;
+    
+    if (term_state.verbose) {
+        fprintf(stderr, "\nConsole %d\n", index + 1);
+    }
 }
 
-/* Create PTY and spawn shell */
-static bool create_pty_shell(void) {
+/* Create PTY and spawn the console's shell or command */
+static bool create_pty_shell(console_t *con) {
     struct winsize ws = {
         .ws_row = term_state.term_rows,
         .ws_col = term_state.term_cols,
@@ -408,143 +674,555 @@ static bool create_pty_shell(void) {
         .ws_ypixel = DISPLAY_HEIGHT
     };
     
-    term_state.child_pid = forkpty(&term_state.master_fd, NULL, NULL, &ws);
+    con->child_pid = forkpty(&con->master_fd, NULL, NULL, &ws);
     
-    if (term_state.child_pid < 0) {
+    if (con->child_pid < 0) {
         perror("forkpty");
         return false;
     }
     
-    if (term_state.child_pid == 0) {
+    if (con->child_pid == 0) {
         /* Child process - execute shell */
-        setenv("TERM", "vt100", 1);
+        setenv("TERM", "xterm-256color", 1);
         setenv("PS1", "\\$ ", 1);
         
         char *shell = getenv("SHELL");
         if (!shell) shell = "/bin/bash";
         
-        execlp(shell, shell, NULL);
+        if (con->command) {
+            execlp(shell, shell, "-c", con->command, (char *)NULL);
+        } else {
+            execlp(shell, shell, (char *)NULL);
+        }
         perror("execlp");
         exit(1);
     }
     
-    /* Parent process */
+    /* Parent process: output is drained until EAGAIN */
+    int flags = fcntl(con->master_fd, F_GETFL);
+    fcntl(con->master_fd, F_SETFL, flags | O_NONBLOCK);
+    
     if (term_state.verbose) {
-        fprintf(stderr, "PTY shell started (PID: %d)\n", term_state.child_pid);
+        fprintf(stderr, "PTY %s started (PID: %d)\n",
+                con->command ? con->command : "shell", con->child_pid);
     }
     
     return true;
 }
 
-/* Main terminal loop */
-static void terminal_loop(void) {
-    char pty_buffer[4096];
+/* Feed recorded events that are due into the replay console
+ * @return Microseconds until the next event, 0 if more are due now,
+ *         -1 when the recording is exhausted */
+static long long feed_replay(void) {
+    term_cast_t *cast = term_state.replay;
+    console_t *con = &term_state.consoles[0];
+    replay_stats_t *stats = &term_state.stats;
+    size_t fed = 0;
+    long long now = now_us();
+    
+    while (term_state.replay_next < cast->count) {
+        const term_cast_event_t *ev = &cast->events[term_state.replay_next];
+        
+        if (term_state.replay_realtime) {
+            long long due = term_state.replay_start_us + (long long)(ev->time * 1e6);
+            if (due > now) return due - now;
+        }
+        
+        /* Same per-wakeup limit as a PTY, so rendering keeps up */
+        if (fed >= PTY_DRAIN_LIMIT) return 0;
+        term_state.replay_next++;
+        
+        if (ev->type == 'i') {
+            term_state.replay_echo = true;
+            continue;
+        }
+        
+        process_pty_output(con, cast->data + ev->offset, (ssize_t)ev->length);
+        long long end = now_us();
+        
+        log_latency(term_state.replay_echo ? &stats->waiting_keys : &stats->waiting, now);
+        stats->parse_us += end - now;
+        stats->bytes_fed += ev->length;
+        fed += ev->length;
+        term_state.replay_echo = false;
+        term_state.render_pending = true;
+        now = end;
+    }
+    
+    return -1;
+}
+
+static int compare_latency(const void *a, const void *b) {
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+/* Print p50 / p99 of a latency log in milliseconds */
+static void print_latency(const char *label, latency_log_t *log, const char *unit) {
+    if (log->count == 0) {
+        printf("  %-11s no %s\n", label, unit);
+        return;
+    }
+    qsort(log->values, log->count, sizeof(long long), compare_latency);
+    printf("  %-11s p50 %.2f ms, p99 %.2f ms (%zu %s)\n", label,
+           log->values[(log->count - 1) / 2] / 1000.0,
+           log->values[(log->count - 1) * 99 / 100] / 1000.0,
+           log->count, unit);
+}
+
+/* Report replay benchmark results */
+static void report_replay(long long elapsed_us) {
+    replay_stats_t *stats = &term_state.stats;
+    double mb = stats->bytes_fed / 1e6;
+    double parse_s = stats->parse_us / 1e6;
+    
+    printf("Replay: %s (%s, %s)\n", term_state.replay_path,
+           term_state.replay_realtime ? "real time" : "full speed",
+           term_state.display.port_name);
+    printf("  Output:     %.2f MB in %.3f s\n", mb, elapsed_us / 1e6);
+    printf("  Parsed:     %.1f MB/s (parser time %.3f s)\n",
+           parse_s > 0 ? mb / parse_s : 0.0, parse_s);
+    printf("  Frames:     %d rendered, %.2f MB uploaded\n",
+           stats->frames, stats->bytes_uploaded / 1e6);
+    print_latency("To wire:", &stats->output, "output chunks");
+    print_latency("Keystroke:", &stats->keystroke, "keystrokes");
+}
+
+/* Copy the viewport of the mirrored screen into the console model
+ * @param all Compare every cell, not only those changed by the last read */
+static void mirror_to_model(bool all) {
+    term_vcsa_t *vcsa = term_state.vcsa;
+    term_emu_t *term = term_state.consoles[0].term;
+    int cols = term->cols;
+    int rows = term->rows;
+    int old_x = term_state.view_x;
+    int old_y = term_state.view_y;
+    
+    if (term_state.view_follow) {
+        /* Move the viewport as little as possible to show the cursor */
+        if (vcsa->cursor_x < term_state.view_x) term_state.view_x = vcsa->cursor_x;
+        if (vcsa->cursor_x >= term_state.view_x + cols) term_state.view_x = vcsa->cursor_x - cols + 1;
+        if (vcsa->cursor_y < term_state.view_y) term_state.view_y = vcsa->cursor_y;
+        if (vcsa->cursor_y >= term_state.view_y + rows) term_state.view_y = vcsa->cursor_y - rows + 1;
+    }
+    
+    int max_x = vcsa->cols > cols ? vcsa->cols - cols : 0;
+    int max_y = vcsa->lines > rows ? vcsa->lines - rows : 0;
+    if (term_state.view_x > max_x) term_state.view_x = max_x;
+    if (term_state.view_y > max_y) term_state.view_y = max_y;
+    if (term_state.view_x < 0) term_state.view_x = 0;
+    if (term_state.view_y < 0) term_state.view_y = 0;
+    
+    /* A moved viewport puts other console cells under every model cell */
+    if (term_state.view_x != old_x || term_state.view_y != old_y) all = true;
+    
+    term_cell_t blank = { ' ', term_emu_color(7), term_emu_color(0), 0 };
+    bool changed = false;
+    
+    for (int row = 0; row < rows; row++) {
+        int y = term_state.view_y + row;
+        for (int col = 0; col < cols; col++) {
+            int x = term_state.view_x + col;
+            term_cell_t cell = blank;
+            
+            if (x < vcsa->cols && y < vcsa->lines) {
+                if (!all && !term_vcsa_changed(vcsa, x, y)) continue;
+                term_vcsa_cell(vcsa, x, y, &cell);
+            }
+            changed |= term_emu_set_cell(term, col, row, &cell);
+        }
+    }
+    
+    int cursor_x = vcsa->cursor_x - term_state.view_x;
+    int cursor_y = vcsa->cursor_y - term_state.view_y;
+    bool visible = cursor_x >= 0 && cursor_x < cols && cursor_y >= 0 && cursor_y < rows;
+    if (visible != term->cursor_visible ||
+        (visible && (cursor_x != term->cursor_x || cursor_y != term->cursor_y))) {
+        term_emu_set_cursor(term, cursor_x, cursor_y, visible);
+        changed = true;
+    }
+    
+    if (changed) term_state.render_pending = true;
+}
+
+/* Re-read the mirrored console after a change notification */
+static void update_mirror(void) {
+    if (!term_state.vcsa) return;
+    
+    if (!term_vcsa_read(term_state.vcsa)) {
+        fprintf(stderr, "Cannot read %s: %s\n", term_state.mirror_path, strerror(errno));
+        term_state.running = false;
+        return;
+    }
+    mirror_to_model(false);
+}
+
+/* Keys in mirror mode pan the viewport; nothing is sent to the console */
+static void handle_mirror_keys(const char *keys, ssize_t n) {
+    int cols = term_state.term_cols;
+    int rows = term_state.term_rows;
+    int dx = 0;
+    int dy = 0;
+    
+    if (n == 3 && keys[0] == 27 && keys[1] == '[') {
+        switch (keys[2]) {
+        case 'A': dy = -1; break;
+        case 'B': dy = 1; break;
+        case 'C': dx = 1; break;
+        case 'D': dx = -1; break;
+        case 'H': term_state.view_follow = true; break;  /* Home */
+        }
+    } else if (n == 4 && keys[0] == 27 && keys[1] == '[' && keys[3] == '~') {
+        if (keys[2] == '5') dy = -rows;             /* Page Up */
+        if (keys[2] == '6') dy = rows;              /* Page Down */
+        if (keys[2] == '1') term_state.view_follow = true;
+    } else if (n == 1 && keys[0] == 'f') {
+        term_state.view_follow = true;
+    }
+    
+    if (dx || dy) {
+        /* Half a screen sideways: wide consoles are mostly panned across */
+        term_state.view_x += dx * (cols / 2 > 0 ? cols / 2 : 1);
+        term_state.view_y += dy;
+        term_state.view_follow = false;
+    }
+    mirror_to_model(true);
+}
+
+/* Handle keys typed on the controlling terminal */
+static void handle_keyboard(void) {
     char kbd_buffer[256];
     
-    fd_set readfds;
-    struct timeval timeout;
+    ssize_t n = read(STDIN_FILENO, kbd_buffer, sizeof(kbd_buffer));
+    if (n == 0) {
+        /* No more input: keep showing the shell's output */
+        epoll_ctl(term_state.epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);
+        return;
+    }
+    if (n < 0) return;
+    
+    /* Check for special keys */
+    console_t *con = active_console();
+    bool handled = false;
+    
+    /* Check for Ctrl+C */
+    if (kbd_buffer[0] == 3) { /* Ctrl+C */
+        term_state.running = false;
+        return;
+    }
+    
+    if (term_state.vcsa) {
+        handle_mirror_keys(kbd_buffer, n);
+        return;
+    }
+    
+    /* Alt+1 .. Alt+9: switch console */
+    if (n == 2 && kbd_buffer[0] == 27 && kbd_buffer[1] >= '1' && kbd_buffer[1] <= '9') {
+        switch_console(kbd_buffer[1] - '1');
+        return;
+    }
+    
+    /* Alt+Left / Alt+Right: previous / next console */
+    if (n == 6 && memcmp(kbd_buffer, "\033[1;3", 5) == 0 &&
+        (kbd_buffer[5] == 'C' || kbd_buffer[5] == 'D')) {
+        int step = kbd_buffer[5] == 'C' ? 1 : term_state.console_count - 1;
+        switch_console((term_state.active + step) % term_state.console_count);
+        return;
+    }
+    
+    /* Check for escape sequences (arrow keys, Page Up/Down, etc) */
+    if (n >= 3 && kbd_buffer[0] == 27 && kbd_buffer[1] == '[') {
+        /* ESC [ sequences */
+        
+        /* Page Up: ESC[5~ */
+        if (n >= 4 && kbd_buffer[2] == '5' && kbd_buffer[3] == '~') {
+            if (!con->scroll_mode) {
+                con->scroll_mode = true;
+                con->view_offset = 0;
+            }
+            /* Scroll up one page */
+            con->view_offset += term_state.term_rows;
+            if (con->view_offset > con->term->history_count) {
+                con->view_offset = con->term->history_count;
+            }
+            term_state.render_pending = true;
+            handled = true;
+        }
+        /* Page Down: ESC[6~ */
+        else if (n >= 4 && kbd_buffer[2] == '6' && kbd_buffer[3] == '~') {
+            if (con->scroll_mode) {
+                /* Scroll down one page */
+                con->view_offset -= term_state.term_rows;
+                if (con->view_offset < 0) {
+                    con->view_offset = 0;
+                    con->scroll_mode = false;  /* Exit scroll mode at bottom */
+                }
+                term_state.render_pending = true;
+                handled = true;
+            }
+        }
+    }
+    /* ScrollLock (sent as Ctrl+Q or special sequence depending on terminal) */
+    /* Also handle 'q' in scroll mode to exit */
+    else if (kbd_buffer[0] == 'q' && con->scroll_mode) {
+        /* Exit scroll mode */
+        con->scroll_mode = false;
+        con->view_offset = 0;
+        term_state.render_pending = true;
+        handled = true;
+    }
+    
+    /* Application cursor keys mode: arrows as ESC O x */
+    if (!handled && con->term->app_cursor_keys && n == 3 &&
+        kbd_buffer[0] == 27 && kbd_buffer[1] == '[' &&
+        kbd_buffer[2] >= 'A' && kbd_buffer[2] <= 'D') {
+        kbd_buffer[1] = 'O';
+    }
+    
+    /* If not in scroll mode, send to the console's PTY */
+    if (!handled && !con->scroll_mode) {
+        if (write(con->master_fd, kbd_buffer, n) < 0 && term_state.verbose) {
+            perror("write");
+        }
+        if (con->recorded) {
+            term_cast_write(term_state.recorder, 'i', kbd_buffer, (size_t)n);
+        }
+    }
+}
+
+/* Handle a signal delivered through the signalfd */
+static void handle_signal(void) {
+    struct signalfd_siginfo info;
+    
+    if (read(term_state.signal_fd, &info, sizeof(info)) != sizeof(info)) return;
+    
+    switch (info.ssi_signo) {
+    case SIGCHLD: {
+        /* A console closes when its program exits, even if something
+         * else still holds the PTY open */
+        pid_t pid;
+        while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+            for (int i = 0; i < term_state.console_count; i++) {
+                if (term_state.consoles[i].child_pid == pid) {
+                    drain_pty(&term_state.consoles[i]);
+                    close_console(i);
+                    break;
+                }
+            }
+        }
+        break;
+    }
+    case SIGWINCH:
+        /* The panel grid is fixed; take it as a request to repaint it */
+        term_state.render_valid = false;
+        term_state.render_pending = true;
+        break;
+    default:
+        term_state.running = false;
+        break;
+    }
+}
+
+/* Arm the frame timer for a render that is waiting on its deadline, and
+ * watch the display only while it has queued bytes */
+static void update_wakeups(void) {
+    bool sending = weact_pending_bytes(&term_state.display) > 0;
+    long long deadline = 0;
+    
+    if (term_state.render_pending && !sending) {
+        deadline = term_state.next_frame_us;
+    }
+    
+    if (deadline != term_state.timer_deadline_us) {
+        struct itimerspec its = {0};
+        its.it_value.tv_sec = deadline / 1000000;
+        its.it_value.tv_nsec = (deadline % 1000000) * 1000;
+        timerfd_settime(term_state.timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+        term_state.timer_deadline_us = deadline;
+    }
+    
+    if (term_state.display_polled && sending != term_state.display_watch) {
+        struct epoll_event ev = { .events = sending ? EPOLLOUT : 0,
+                                  .data.fd = term_state.display.fd };
+        epoll_ctl(term_state.epoll_fd, EPOLL_CTL_MOD, term_state.display.fd, &ev);
+        term_state.display_watch = sending;
+    }
+}
+
+/* Register an fd for input events */
+static bool watch_fd(int fd) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    return epoll_ctl(term_state.epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+/* Create epoll set, frame timer and signalfd */
+static bool setup_event_loop(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGWINCH);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigprocmask(SIG_BLOCK, &mask, &term_state.saved_mask);
+    
+    term_state.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    term_state.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    term_state.signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    term_state.timer_deadline_us = 0;
+    term_state.mirror_timer_fd = -1;
+    
+    if (term_state.epoll_fd < 0 || term_state.timer_fd < 0 || term_state.signal_fd < 0 ||
+        !watch_fd(term_state.timer_fd) || !watch_fd(term_state.signal_fd)) {
+        perror("event loop");
+        return false;
+    }
+    
+    /* Without a keyboard (e.g. a kiosk mirror started from a service) the
+     * panel still follows its source; a replay takes no input */
+    if (!term_state.replay && !watch_fd(STDIN_FILENO) && term_state.verbose) {
+        fprintf(stderr, "No keyboard input\n");
+    }
+    
+    for (int i = 0; i < term_state.console_count; i++) {
+        if (term_state.consoles[i].master_fd >= 0 && !watch_fd(term_state.consoles[i].master_fd)) {
+            perror("event loop");
+            return false;
+        }
+    }
+    
+    if (term_state.vcsa) {
+        /* vcs devices signal changes with POLLPRI; anything else (such as
+         * a regular file standing in for one) is re-read periodically */
+        struct epoll_event ev = { .events = EPOLLPRI, .data.fd = term_state.vcsa->fd };
+        if (!term_state.vcsa->pollable ||
+            epoll_ctl(term_state.epoll_fd, EPOLL_CTL_ADD, term_state.vcsa->fd, &ev) < 0) {
+            struct itimerspec its = {
+                .it_interval = { 0, MIRROR_POLL_US * 1000 },
+                .it_value = { 0, MIRROR_POLL_US * 1000 }
+            };
+            term_state.mirror_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            if (term_state.mirror_timer_fd < 0 ||
+                timerfd_settime(term_state.mirror_timer_fd, 0, &its, NULL) < 0 ||
+                !watch_fd(term_state.mirror_timer_fd)) {
+                perror("event loop");
+                return false;
+            }
+        }
+    }
+    
+    /* Uploads overlap with parsing when the port can be polled; otherwise
+     * (e.g. a regular file) writes stay blocking */
+    struct epoll_event ev = { .events = 0, .data.fd = term_state.display.fd };
+    term_state.display_polled =
+        epoll_ctl(term_state.epoll_fd, EPOLL_CTL_ADD, term_state.display.fd, &ev) == 0 &&
+        weact_set_nonblocking(&term_state.display, true);
+    term_state.display_watch = false;
+    
+    if (term_state.verbose && !term_state.display_polled) {
+        fprintf(stderr, "Display port cannot be polled, using blocking writes\n");
+    }
+    
+    return true;
+}
+
+/* Release event loop resources and send what is still queued */
+static void teardown_event_loop(void) {
+    if (term_state.display_polled) {
+        weact_set_nonblocking(&term_state.display, false);
+    }
+    
+    if (term_state.mirror_timer_fd >= 0) close(term_state.mirror_timer_fd);
+    term_state.mirror_timer_fd = -1;
+    if (term_state.signal_fd >= 0) close(term_state.signal_fd);
+    if (term_state.timer_fd >= 0) close(term_state.timer_fd);
+    if (term_state.epoll_fd >= 0) close(term_state.epoll_fd);
+    term_state.signal_fd = term_state.timer_fd = term_state.epoll_fd = -1;
+    
+    sigprocmask(SIG_SETMASK, &term_state.saved_mask, NULL);
+}
+
+/* Main terminal loop: sleeps in epoll_wait until keys, shell output, a
+ * frame deadline, a signal or room on the display port */
+static void terminal_loop(void) {
+    struct epoll_event events[8];
+    
+    if (!setup_event_loop()) {
+        teardown_event_loop();
+        return;
+    }
     
     term_state.running = true;
     
     /* Initial render */
-    render_screen();
+    term_state.frame_budget_us = FRAME_MIN_US;
+    render_frame();
+    term_state.replay_start_us = now_us();
     
     while (term_state.running) {
-        FD_ZERO(&readfds);
-        FD_SET(STDIN_FILENO, &readfds);
-        FD_SET(term_state.master_fd, &readfds);
+        long long replay_wait = term_state.replay ? feed_replay() : -1;
+        int timeout = replay_wait >= 0 ? (int)((replay_wait + 999) / 1000) : -1;
         
-        int max_fd = (term_state.master_fd > STDIN_FILENO) ? 
-                     term_state.master_fd : STDIN_FILENO;
+        /* Latest state wins: intermediate states are never drawn, and a
+         * new frame waits until the previous one has left the queue */
+        if (term_state.render_pending && weact_pending_bytes(&term_state.display) == 0 &&
+            now_us() >= term_state.next_frame_us) {
+            render_frame();
+        }
         
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 100000; /* 100ms */
+        if (term_state.replay && replay_wait < 0 && !term_state.render_pending &&
+            weact_pending_bytes(&term_state.display) == 0) {
+            break;              /* Recording played and on the wire */
+        }
         
-        int ret = select(max_fd + 1, &readfds, NULL, NULL, &timeout);
+        update_wakeups();
         
-        if (ret < 0) {
+        int count = epoll_wait(term_state.epoll_fd, events, 8, timeout);
+        if (count < 0) {
             if (errno == EINTR) continue;
-            perror("select");
+            perror("epoll_wait");
             break;
         }
         
-        /* Read from keyboard */
-        if (FD_ISSET(STDIN_FILENO, &readfds)) {
-            ssize_t n = read(STDIN_FILENO, kbd_buffer, sizeof(kbd_buffer));
-            if (n > 0) {
-                /* Check for special keys */
-                bool handled = false;
-                
-                /* Check for Ctrl+C */
-                if (kbd_buffer[0] == 3) { /* Ctrl+C */
-                    term_state.running = false;
-                    break;
-                }
-                
-                /* Check for escape sequences (arrow keys, Page Up/Down, etc) */
-                if (n >= 3 && kbd_buffer[0] == 27 && kbd_buffer[1] == '[') {
-                    /* ESC [ sequences */
-                    
-                    /* Page Up: ESC[5~ */
-                    if (n >= 4 && kbd_buffer[2] == '5' && kbd_buffer[3] == '~') {
-                        if (!term_state.scroll_mode) {
-                            term_state.scroll_mode = true;
-                            term_state.view_offset = 0;
-                        }
-                        /* Scroll up one page */
-                        term_state.view_offset += term_state.term_rows;
-                        if (term_state.view_offset > term_state.cursor_y) {
-                            term_state.view_offset = term_state.cursor_y;
-                        }
-                        render_screen();
-                        handled = true;
-                    }
-                    /* Page Down: ESC[6~ */
-                    else if (n >= 4 && kbd_buffer[2] == '6' && kbd_buffer[3] == '~') {
-                        if (term_state.scroll_mode) {
-                            /* Scroll down one page */
-                            term_state.view_offset -= term_state.term_rows;
-                            if (term_state.view_offset < 0) {
-                                term_state.view_offset = 0;
-                                term_state.scroll_mode = false;  /* Exit scroll mode at bottom */
-                            }
-                            render_screen();
-                            handled = true;
-                        }
-                    }
+        for (int i = 0; i < count && term_state.running; i++) {
+            int fd = events[i].data.fd;
+            
+            if (fd == STDIN_FILENO) {
+                handle_keyboard();
+            } else if (fd == term_state.timer_fd) {
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    term_state.timer_deadline_us = 0;
                 }
-                /* ScrollLock (sent as Ctrl+Q or special sequence depending on terminal) */
-                /* Also handle 'q' in scroll mode to exit */
-                else if (kbd_buffer[0] == 'q' && term_state.scroll_mode) {
-                    /* Exit scroll mode */
-                    term_state.scroll_mode = false;
-                    term_state.view_offset = 0;
-                    render_screen();
-                    handled = true;
+            } else if (fd == term_state.signal_fd) {
+                handle_signal();
+            } else if (term_state.vcsa && fd == term_state.vcsa->fd) {
+                update_mirror();
+            } else if (fd == term_state.mirror_timer_fd) {
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                    update_mirror();
                 }
-                
-                /* If not in scroll mode, send to PTY */
-                if (!handled && !term_state.scroll_mode) {
-                    write(term_state.master_fd, kbd_buffer, n);
+            } else if (fd == term_state.display.fd) {
+                if ((events[i].events & (EPOLLERR | EPOLLHUP)) ||
+                    !weact_write_pending(&term_state.display)) {
+                    fprintf(stderr, "Display write failed: %s\n",
+                            weact_get_last_error(&term_state.display));
+                    term_state.running = false;
                 }
-            }
-        }
-        
-        /* Read from PTY */
-        if (FD_ISSET(term_state.master_fd, &readfds)) {
-            ssize_t n = read(term_state.master_fd, pty_buffer, sizeof(pty_buffer));
-            if (n > 0) {
-                process_pty_output(pty_buffer, n);
-                render_screen();
-            } else if (n == 0) {
-                /* PTY closed */
-                if (term_state.verbose) {
-                    fprintf(stderr, "\nShell exited\n");
+            } else {
+                /* Console output: everything available, rendered once at the top */
+                for (int c = 0; c < term_state.console_count; c++) {
+                    if (term_state.consoles[c].master_fd == fd) {
+                        if (!drain_pty(&term_state.consoles[c])) close_console(c);
+                        break;
+                    }
                 }
-                break;
             }
         }
     }
+    
+    teardown_event_loop();
 }
 
 /* Show help */
@@ -555,15 +1233,28 @@ static void show_help(const char *prog_name) {
     printf("  %s -p /dev/ttyACM0 [options]\n", prog_name);
     printf("\n");
     printf("OPTIONS:\n");
-    printf("  -p, --port PORT    Serial port for display (required)\n");
+    printf("  -p, --port PORT    Serial port for display (required); 'null' discards\n");
+    printf("                     output, for benchmarks without a panel\n");
     printf("  -f, --font TYPE    Font type: mono, sans, serif (default: mono)\n");
     printf("                     mono  = Monospace (best for terminal, fixed width)\n");
     printf("                     sans  = Sans-serif (proportional width)\n");
     printf("                     serif = Serif (proportional width)\n");
-    printf("  -z, --size SIZE    Font size: 8, 10, 12 (default: 10)\n");
-    printf("                     8  = ~26 cols × 8 rows  (small, more text)\n");
-    printf("                     10 = ~25 cols × 7 rows  (medium, readable)\n");
-    printf("                     12 = ~22 cols × 6 rows  (large, very readable)\n");
+    printf("  -z, --size SIZE    Font size in pixels, %d-%d (default: 10)\n",
+           FONT_SIZE_MIN, FONT_SIZE_MAX);
+    printf("                     Cell size comes from the font, e.g. DejaVu Sans Mono:\n");
+    printf("                     8  = 31 cols × 7 rows  (small, more text)\n");
+    printf("                     10 = 26 cols × 5 rows  (medium, readable)\n");
+    printf("                     12 = 22 cols × 5 rows  (large, very readable)\n");
+    printf("  -b, --scrollback N Scrollback depth in lines (default: %d, max: %d)\n",
+           TERM_SCROLLBACK_LINES, TERM_SCROLLBACK_MAX);
+    printf("  -n, --consoles N   Number of shell consoles (default: 1, max: %d)\n", MAX_CONSOLES);
+    printf("  -e, --exec CMD     Add a console running CMD (repeatable)\n");
+    printf("  -m, --mirror DEV   Show a Linux console (/dev/vcsaN) instead of a shell;\n");
+    printf("                     arrows / PgUp / PgDn pan, Home or f follows the cursor\n");
+    printf("  -r, --record FILE  Record the first console as an asciicast v2 file\n");
+    printf("  -R, --replay FILE  Replay a recording as fast as possible and report\n");
+    printf("                     parser throughput, frames and output-to-wire latency\n");
+    printf("      --realtime     Replay with the recorded timing\n");
     printf("  -l, --flip         Flip display 180° (reverse landscape)\n");
     printf("                     Useful if display is mounted upside-down\n");
     printf("  -v, --verbose      Verbose output\n");
@@ -574,12 +1265,14 @@ static void show_help(const char *prog_name) {
     printf("  Page Up            Scroll back (enter scroll mode)\n");
     printf("  Page Down          Scroll forward\n");
     printf("  q (in scroll mode) Exit scroll mode\n");
+    printf("  Alt+1 .. Alt+9     Switch to console 1-9\n");
+    printf("  Alt+Left/Right     Previous / next console\n");
     printf("\n");
     printf("FEATURES:\n");
     printf("  - Monospace font for perfect alignment (default)\n");
     printf("  - Scroll back through output with Page Up/Down\n");
     printf("  - Yellow indicator when in scroll mode\n");
-    printf("  - Up to 100 lines of scrollback buffer\n");
+    printf("  - Scrollback of %d lines by default (-b to change)\n", TERM_SCROLLBACK_LINES);
     printf("  - Flip mode for upside-down mounting\n");
     printf("\n");
     printf("RECOMMENDED:\n");
@@ -592,6 +1285,11 @@ static void show_help(const char *prog_name) {
     printf("  %s -p /dev/ttyACM0 -f mono -z 12  # Best settings\n", prog_name);
     printf("  %s -p /dev/ttyACM0 --flip       # Upside-down mount\n", prog_name);
     printf("  %s -p /dev/ttyUSB0 -v           # Verbose mode\n", prog_name);
+    printf("  %s -p /dev/ttyACM0 -e 'tail -f /var/log/syslog' -e top\n", prog_name);
+    printf("                                   # Shell, log tail and top\n");
+    printf("  %s -p /dev/ttyACM0 -m /dev/vcsa1 # Mirror tty1 (boot, getty)\n", prog_name);
+    printf("  %s -p /dev/ttyACM0 -r build.cast # Record a session\n", prog_name);
+    printf("  %s -p null -R build.cast       # Benchmark its replay\n", prog_name);
     printf("\n");
     printf("NOTES:\n");
     printf("  - Use monospace font for proper cursor alignment\n");
@@ -604,26 +1302,44 @@ static void show_help(const char *prog_name) {
 
 /* Cleanup */
 static void cleanup(void) {
+    ft_text_cells_destroy(term_state.cells);
+    
     if (term_state.text_ctx) {
         ft_text_cleanup(term_state.text_ctx);
     }
     
-    if (term_state.master_fd > 0) {
-        close(term_state.master_fd);
+    for (int i = 0; i < term_state.console_count; i++) {
+        console_t *con = &term_state.consoles[i];
+        if (con->master_fd > 0) {
+            close(con->master_fd);
+        }
+        term_emu_destroy(con->term);
     }
     
+    free(term_state.rendered);
+    free(term_state.history_row);
+    term_vcsa_close(term_state.vcsa);
+    term_cast_close(term_state.recorder);
+    term_cast_free(term_state.replay);
+    free(term_state.stats.output.values);
+    free(term_state.stats.keystroke.values);
+    free(term_state.stats.waiting.values);
+    free(term_state.stats.waiting_keys.values);
+    
     weact_cleanup(&term_state.display);
 }
 
 /* Main */
 int main(int argc, char *argv[]) {
     bool port_specified = false;
+    int shells = 1;
+    const char *commands[MAX_CONSOLES];
+    int command_count = 0;
     
     /* Set defaults */
     term_state.font_size = FONT_MEDIUM;  /* 10pt by default */
     term_state.font_type = FONT_MONO;    /* Monospace by default - best for terminal! */
-    term_state.scroll_mode = false;
-    term_state.view_offset = 0;
+    term_state.scrollback_lines = TERM_SCROLLBACK_LINES;
     term_state.flip_mode = false;        /* Normal orientation by default */
     
     /* Parse arguments */
@@ -650,17 +1366,55 @@ int main(int argc, char *argv[]) {
         } else if (strcmp(argv[i], "-z") == 0 || strcmp(argv[i], "--size") == 0) {
             if (i + 1 < argc) {
                 int size = atoi(argv[++i]);
-                if (size == 8) {
-                    term_state.font_size = FONT_SMALL;
-                } else if (size == 10) {
-                    term_state.font_size = FONT_MEDIUM;
-                } else if (size == 12) {
-                    term_state.font_size = FONT_LARGE;
+                if (size >= FONT_SIZE_MIN && size <= FONT_SIZE_MAX) {
+                    term_state.font_size = size;
                 } else {
                     fprintf(stderr, "Warning: Invalid font size %d, using default (10)\n", size);
                     term_state.font_size = FONT_MEDIUM;
                 }
             }
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--scrollback") == 0) {
+            if (i + 1 < argc) {
+                int lines = atoi(argv[++i]);
+                if (lines < 0 || lines > TERM_SCROLLBACK_MAX) {
+                    fprintf(stderr, "Warning: Invalid scrollback %d, using default (%d)\n",
+                            lines, TERM_SCROLLBACK_LINES);
+                    lines = TERM_SCROLLBACK_LINES;
+                }
+                term_state.scrollback_lines = lines;
+            }
+        } else if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--consoles") == 0) {
+            if (i + 1 < argc) {
+                shells = atoi(argv[++i]);
+                if (shells < 0 || shells > MAX_CONSOLES) {
+                    fprintf(stderr, "Warning: Invalid console count %d, using 1\n", shells);
+                    shells = 1;
+                }
+            }
+        } else if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--exec") == 0) {
+            if (i + 1 < argc) {
+                i++;
+                if (command_count < MAX_CONSOLES) {
+                    commands[command_count++] = argv[i];
+                } else {
+                    fprintf(stderr, "Warning: At most %d consoles, ignoring '%s'\n",
+                            MAX_CONSOLES, argv[i]);
+                }
+            }
+        } else if (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--mirror") == 0) {
+            if (i + 1 < argc) {
+                term_state.mirror_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--record") == 0) {
+            if (i + 1 < argc) {
+                term_state.record_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "-R") == 0 || strcmp(argv[i], "--replay") == 0) {
+            if (i + 1 < argc) {
+                term_state.replay_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            term_state.replay_realtime = true;
         } else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--flip") == 0) {
             term_state.flip_mode = true;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
@@ -677,6 +1431,35 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    /* Shells first, then one console per -e command; a mirror or a replay
+     * is the only console */
+    if (term_state.mirror_path && term_state.replay_path) {
+        fprintf(stderr, "Warning: --replay is ignored with --mirror\n");
+        term_state.replay_path = NULL;
+    }
+    if (term_state.record_path && (term_state.mirror_path || term_state.replay_path)) {
+        fprintf(stderr, "Warning: --record is ignored with --%s\n",
+                term_state.mirror_path ? "mirror" : "replay");
+        term_state.record_path = NULL;
+    }
+    if (term_state.mirror_path || term_state.replay_path) {
+        if (shells != 1 || command_count > 0) {
+            fprintf(stderr, "Warning: -n and -e are ignored with --%s\n",
+                    term_state.mirror_path ? "mirror" : "replay");
+        }
+        shells = 1;
+        command_count = 0;
+    } else if (shells + command_count > MAX_CONSOLES) {
+        shells = MAX_CONSOLES - command_count;
+    }
+    if (shells + command_count == 0) {
+        shells = 1;
+    }
+    term_state.console_count = shells + command_count;
+    for (int i = 0; i < command_count; i++) {
+        term_state.consoles[shells + i].command = commands[i];
+    }
+    
     /* Find font file */
     const char *font_path = find_font_path(term_state.font_type);
     if (!font_path) {
@@ -687,9 +1470,6 @@ int main(int argc, char *argv[]) {
     }
     strncpy(term_state.font_path, font_path, sizeof(term_state.font_path) - 1);
     
-    /* Calculate terminal dimensions based on font size and type */
-    calculate_terminal_dimensions();
-    
     /* Setup signal handlers */
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -701,15 +1481,17 @@ int main(int argc, char *argv[]) {
                 term_state.font_type == FONT_SANS ? "Sans" : "Serif",
                 term_state.font_size);
         fprintf(stderr, "Font file: %s\n", term_state.font_path);
-        fprintf(stderr, "Display: %dx%d chars on %s\n", 
-                term_state.term_cols, term_state.term_rows, term_state.port);
+        fprintf(stderr, "Display: %s\n", term_state.port);
         if (term_state.flip_mode) {
             fprintf(stderr, "Flip mode: enabled (reverse landscape)\n");
         }
     }
     
-    /* Initialize display */
-    if (!weact_init(&term_state.display, term_state.port)) {
+    /* Initialize display; "null" measures everything but the link */
+    bool display_ok = strcmp(term_state.port, "null") == 0 ?
+                      weact_init_null(&term_state.display) :
+                      weact_init(&term_state.display, term_state.port);
+    if (!display_ok) {
         fprintf(stderr, "Error: Failed to initialize display\n");
         fprintf(stderr, "Details: %s\n", weact_get_last_error(&term_state.display));
         return 1;
@@ -740,24 +1522,107 @@ int main(int argc, char *argv[]) {
     }
     
     ft_text_set_color(term_state.text_ctx, WEACT_WHITE);
+    ft_text_set_render_mode(term_state.text_ctx, FT_TEXT_RENDER_MONO);
     
-    /* Initialize screen buffer */
-    init_screen_buffer();
+    /* Symbols and CJK in program output come from fallback fonts */
+    ft_text_add_default_fallbacks(term_state.text_ctx);
     
-    /* Set terminal to raw mode */
-    if (!set_raw_mode()) {
-        fprintf(stderr, "Error: Failed to set raw mode\n");
+    /* Grid from the font metrics; ASCII and Cyrillic drawn as ready cells */
+    calculate_terminal_dimensions();
+    term_state.cells = ft_text_cells_create(term_state.text_ctx, term_state.char_width,
+                                            term_state.char_height, cell_ranges,
+                                            (int)(sizeof(cell_ranges) / sizeof(cell_ranges[0])));
+    
+    /* Initialize terminal models, one per console */
+    bool models_ok = true;
+    for (int i = 0; i < term_state.console_count; i++) {
+        console_t *con = &term_state.consoles[i];
+        con->term = term_emu_create(term_state.term_cols, term_state.term_rows);
+        if (!con->term || !term_emu_set_scrollback(con->term, term_state.scrollback_lines)) {
+            models_ok = false;
+        }
+    }
+    term_state.rendered = calloc((size_t)term_state.term_cols * term_state.term_rows,
+                                 sizeof(term_cell_t));
+    term_state.history_row = calloc((size_t)term_state.term_cols, sizeof(term_cell_t));
+    term_state.rendered_cursor = -1;
+    term_state.rendered_console = -1;
+    if (!term_state.cells || !models_ok || !term_state.rendered || !term_state.history_row) {
+        fprintf(stderr, "Error: Out of memory\n");
         cleanup();
         return 1;
     }
     
-    /* Create PTY and shell */
-    if (!create_pty_shell()) {
-        fprintf(stderr, "Error: Failed to create PTY shell\n");
+    /* Mirror mode: the console model follows the virtual console */
+    if (term_state.mirror_path) {
+        term_state.vcsa = term_vcsa_open(term_state.mirror_path);
+        if (!term_state.vcsa) {
+            fprintf(stderr, "Error: Cannot open %s: %s\n", term_state.mirror_path, strerror(errno));
+            cleanup();
+            return 1;
+        }
+        term_state.consoles[0].master_fd = -1;
+        term_state.view_follow = true;
+        mirror_to_model(true);
+        
+        if (term_state.verbose) {
+            fprintf(stderr, "Mirroring %s (%dx%d%s)\n", term_state.mirror_path,
+                    term_state.vcsa->cols, term_state.vcsa->lines,
+                    term_state.vcsa->pollable ? "" : ", re-read every 100 ms");
+        }
+    }
+    
+    /* Replay mode: recorded output is fed to the console instead of a PTY */
+    if (term_state.replay_path) {
+        term_state.replay = term_cast_load(term_state.replay_path);
+        if (!term_state.replay) {
+            fprintf(stderr, "Error: Cannot load %s: %s\n", term_state.replay_path, strerror(errno));
+            cleanup();
+            return 1;
+        }
+        term_state.consoles[0].master_fd = -1;
+        
+        if (term_state.replay->width && (term_state.replay->width != term_state.term_cols ||
+                                         term_state.replay->height != term_state.term_rows)) {
+            fprintf(stderr, "Warning: Recorded at %dx%d, replaying at %dx%d\n",
+                    term_state.replay->width, term_state.replay->height,
+                    term_state.term_cols, term_state.term_rows);
+        }
+        
+        terminal_loop();
+        report_replay(now_us() - term_state.replay_start_us);
+        cleanup();
+        return 0;
+    }
+    
+    /* Set terminal to raw mode; a mirror also runs without a keyboard */
+    if (!set_raw_mode() && !term_state.vcsa) {
+        fprintf(stderr, "Error: Failed to set raw mode\n");
         cleanup();
         return 1;
     }
     
+    /* Create PTY and shell for every console */
+    for (int i = 0; i < term_state.console_count && !term_state.vcsa; i++) {
+        if (!create_pty_shell(&term_state.consoles[i])) {
+            fprintf(stderr, "Error: Failed to create PTY shell\n");
+            cleanup();
+            return 1;
+        }
+    }
+    
+    /* Record the first console at the grid size it runs with */
+    if (term_state.record_path) {
+        term_state.recorder = term_cast_create(term_state.record_path,
+                                               term_state.term_cols, term_state.term_rows);
+        if (!term_state.recorder) {
+            fprintf(stderr, "Error: Cannot create %s: %s\n", term_state.record_path, strerror(errno));
+            cleanup();
+            return 1;
+        }
+        term_state.consoles[0].recorded = true;
+    }
+    
     /* Show initial message on display */
     weact_clear_buffer(&term_state.display, WEACT_BLACK);
     
@@ -773,6 +1638,11 @@ int main(int argc, char *argv[]) {
              term_state.term_cols, term_state.term_rows);
     ft_text_draw(term_state.text_ctx, 2, 5 + term_state.char_height, welcome);
     
+    if (term_state.console_count > 1) {
+        snprintf(welcome, sizeof(welcome), "Alt+1-%d=Console", term_state.console_count);
+        ft_text_draw(term_state.text_ctx, 2, 5 + term_state.char_height * 2, welcome);
+    }
+    
     ft_text_draw(term_state.text_ctx, 2, 5 + term_state.char_height * 3, "PgUp=Scroll");
     ft_text_draw(term_state.text_ctx, 2, 5 + term_state.char_height * 4, "Ctrl+C=Exit");
     weact_update_display(&term_state.display);